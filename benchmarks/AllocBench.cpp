@@ -0,0 +1,192 @@
+// Allocations per VFS operation and hot path allocation budgets. Built with TITAN_VFS_ALLOC_TRACKING,
+// EASTL hooks and global 'operator new' both report to AllocationTracker. Exits with 1 if reopening a
+// closed file or reading into a caller buffer allocates more than its budget. Registered with ctest,
+// so CI catches regressions.
+//
+// Usage: Titan-Vfs-bench-alloc [--files N] [--size BYTES] [--repeat N]
+
+#include "BenchCommon.hpp"
+
+#include <new>
+
+using namespace Titan::Vfs;
+
+#ifdef TITAN_VFS_ALLOC_TRACKING
+void* operator new(size_t size)
+{
+    Titan::Vfs::AllocationTracker::OnAllocate(size);
+    if (void* pointer = malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    free(pointer);
+}
+#endif
+
+namespace
+{
+
+/*
+ * Most allocations a single call of an operation may make once its file was opened and closed before
+ */
+struct Budget
+{
+    AllocOp Op;
+    uint64_t MaxAllocations;
+};
+
+typedef eastl::vector<Budget> TBudgets;
+
+// Memory file is reopened in place
+const TBudgets k_MemoryBudgets = { { AllocOp::OpenFile, 0 }, { AllocOp::Read, 0 } };
+// File stream allocates its buffer on open, one or two allocations depending on standard library
+const TBudgets k_NativeBudgets = { { AllocOp::OpenFile, 2 }, { AllocOp::Read, 0 } };
+// Entry is extracted again: buffer object, its storage and shared pointer control block
+const TBudgets k_ZipBudgets = { { AllocOp::OpenFile, 3 }, { AllocOp::Read, 0 } };
+// Entry cache hands out the buffer extracted on first open
+const TBudgets k_ZipCachedBudgets = { { AllocOp::OpenFile, 0 }, { AllocOp::Read, 0 } };
+
+/*
+ * Print stats of every operation, returns false if a budgeted one went over
+ */
+bool Report(const char* backend, const TBudgets& budgets)
+{
+    bool isWithinBudget = true;
+    for (size_t i = 0; i < static_cast<size_t>(AllocOp::Count); ++i) {
+        AllocOp op = static_cast<AllocOp>(i);
+        AllocationTracker::OpStats stats = AllocationTracker::GetStats(op);
+        if (stats.Calls == 0) {
+            continue;
+        }
+
+        const Budget* budget = nullptr;
+        for (const Budget& candidate : budgets) {
+            budget = candidate.Op == op ? &candidate : budget;
+        }
+        bool isOver = budget && stats.MaxAllocations > budget->MaxAllocations;
+        isWithinBudget &= !isOver;
+
+        printf("{\"bench\":\"allocations\",\"backend\":\"%s\",\"op\":\"%s\",\"calls\":%llu,\"allocs_per_call\":%.2f,\"bytes_per_call\":%.1f,"
+            "\"max_allocs\":%llu,\"max_bytes\":%llu,\"budget\":%lld,\"status\":\"%s\"}\n",
+            backend, AllocationTracker::GetOpName(op), static_cast<unsigned long long>(stats.Calls),
+            static_cast<double>(stats.Allocations) / static_cast<double>(stats.Calls),
+            static_cast<double>(stats.Bytes) / static_cast<double>(stats.Calls),
+            static_cast<unsigned long long>(stats.MaxAllocations), static_cast<unsigned long long>(stats.MaxBytes),
+            budget ? static_cast<long long>(budget->MaxAllocations) : -1LL, isOver ? "over" : (budget ? "ok" : "info"));
+    }
+    return isWithinBudget;
+}
+
+/*
+ * Mount backend, warm it up, then measure reopen and read of closed files and a few colder operations
+ */
+bool Measure(const char* backend, const HFileSystem& fs, const TBudgets& budgets, uint64_t numFiles, uint64_t fileSize, uint64_t repeat)
+{
+    HVirtualFileSystem vfs = VirtualFileSystem::Create();
+    vfs->AddFileSystem("/data", fs);
+
+    eastl::vector<eastl::string> paths;
+    for (uint64_t i = 0; i < numFiles; ++i) {
+        char path[64];
+        snprintf(path, sizeof(path), "/data/file%llu.bin", static_cast<unsigned long long>(i));
+        paths.push_back(path);
+    }
+
+    // First open fills resolve cache and creates file objects, which is allowed to allocate
+    eastl::vector<uint8_t> buffer(static_cast<size_t>(eastl::max<uint64_t>(fileSize, 1)));
+    for (const eastl::string& path : paths) {
+        if (HFile file = vfs->OpenFile(path, IFile::FileMode::Read)) {
+            file->Read(buffer.data(), buffer.size());
+            file->Close();
+        }
+    }
+
+    AllocationTracker::ResetStats();
+    for (uint64_t r = 0; r < repeat; ++r) {
+        for (const eastl::string& path : paths) {
+            HFile file = vfs->OpenFile(path, IFile::FileMode::Read);
+            if (!file || !file->IsOpened()) {
+                fprintf(stderr, "%s: can't open %s\n", backend, path.c_str());
+                return false;
+            }
+            file->Read(buffer.data(), buffer.size());
+            // Every measured open goes through the whole open path again
+            file->Close();
+        }
+    }
+
+    // Informational, no budget
+    eastl::vector<BatchReadRequest> requests;
+    for (const eastl::string& path : paths) {
+        requests.push_back(BatchReadRequest(FileInfo(path), buffer.data(), buffer.size()));
+    }
+    vfs->ReadFiles(requests);
+    for (const auto& entry : vfs->ListDirectory("/data/", true)) {
+        (void)entry;
+    }
+    vfs->RemoveFileSystem("/data", fs);
+
+    return Report(backend, budgets);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const uint64_t numFiles = eastl::max<uint64_t>(Bench::GetOption(argc, argv, "--files", 64), 1);
+    const uint64_t fileSize = Bench::GetOption(argc, argv, "--size", 4096);
+    const uint64_t repeat = eastl::max<uint64_t>(Bench::GetOption(argc, argv, "--repeat", 100), 1);
+
+    if constexpr (!g_AllocTrackingEnabled) {
+        fprintf(stderr, "Built without TITAN_VFS_ALLOC_TRACKING, nothing is counted\n");
+        return 1;
+    }
+
+    Bench::TempDirectory temp("titan-vfs-alloc");
+    std::filesystem::path dataPath = temp.Path() / "data";
+    std::filesystem::path zipPath = temp.Path() / "data.zip";
+    if (!Bench::WriteFiles(dataPath, "file", static_cast<uint32_t>(numFiles), fileSize, 1)) {
+        fprintf(stderr, "Can't write data set into %s\n", temp.Path().string().c_str());
+        return 1;
+    }
+
+    bool isWithinBudget = true;
+
+    HFileSystem memory = MemoryFileSystem::Create();
+    memory->Initialize();
+    Bench::PopulateMemoryFileSystem(memory, static_cast<uint32_t>(numFiles), fileSize);
+    isWithinBudget &= Measure("memory", memory, k_MemoryBudgets, numFiles, fileSize, repeat);
+
+    HFileSystem native = NativeFileSystem::Create(dataPath.string().c_str());
+    native->Initialize();
+    isWithinBudget &= Measure("native", native, k_NativeBudgets, numFiles, fileSize, repeat);
+
+    if (Bench::WriteZip(dataPath, zipPath)) {
+        HFileSystem zip = ZipFileSystem::Create(zipPath.string().c_str());
+        zip->Initialize();
+        isWithinBudget &= Measure("zip", zip, k_ZipBudgets, numFiles, fileSize, repeat);
+
+        ZipFileSystem::Options cachedOptions;
+        cachedOptions.EntryCacheCapacity = eastl::max<uint64_t>(numFiles * fileSize, 1);
+        HFileSystem cached = ZipFileSystem::Create(zipPath.string().c_str(), cachedOptions);
+        cached->Initialize();
+        isWithinBudget &= Measure("zip-cached", cached, k_ZipCachedBudgets, numFiles, fileSize, repeat);
+    } else {
+        fprintf(stderr, "Can't write %s, zip backend is skipped\n", zipPath.string().c_str());
+    }
+
+    if (!isWithinBudget) {
+        fprintf(stderr, "Allocation budget exceeded\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,232 @@
+#ifndef BENCHCOMMON_HPP
+#define BENCHCOMMON_HPP
+
+#include "Titan-Vfs/VFS.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// EASTL allocation hooks, every benchmark is a single translation unit
+void* operator new[](size_t size, const char* pName, int flags, unsigned debugFlags, const char* file, int line) {
+    Titan::Vfs::AllocationTracker::OnAllocate(size);
+    return malloc(size);
+}
+void* operator new[](size_t size, size_t alignment, size_t alignmentOffset, const char* pName, int flags, unsigned debugFlags, const char* file, int line) {
+    Titan::Vfs::AllocationTracker::OnAllocate(size);
+    return malloc(size);
+}
+
+namespace Titan::Vfs::Bench
+{
+
+using Clock = std::chrono::steady_clock;
+
+inline double SecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/*
+ * Small deterministic generator so runs are comparable
+ */
+class Random
+{
+public:
+    explicit Random(uint64_t seed)
+        : m_State(seed ? seed : 0x9E3779B97F4A7C15ull)
+    {
+    }
+
+    inline uint64_t Next()
+    {
+        m_State ^= m_State << 13;
+        m_State ^= m_State >> 7;
+        m_State ^= m_State << 17;
+        return m_State;
+    }
+
+    inline uint64_t Next(uint64_t bound)
+    {
+        return bound ? Next() % bound : 0;
+    }
+
+private:
+    uint64_t m_State;
+};
+
+/*
+ * Read integer option '--name value', returns fallback if missing
+ */
+inline uint64_t GetOption(int argc, char** argv, const char* name, uint64_t fallback)
+{
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], name) == 0) {
+            return strtoull(argv[i + 1], nullptr, 10);
+        }
+    }
+    return fallback;
+}
+
+inline const char* GetStringOption(int argc, char** argv, const char* name, const char* fallback)
+{
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], name) == 0) {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+inline bool HasFlag(int argc, char** argv, const char* name)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Fill memory filesystem with 'count' files named 'file<N>.bin' of 'size' bytes
+ */
+inline void PopulateMemoryFileSystem(const HFileSystem& fs, uint32_t count, uint64_t size)
+{
+    eastl::vector<uint8_t> data(static_cast<size_t>(size), 0xAB);
+    for (uint32_t i = 0; i < count; ++i) {
+        char name[64];
+        snprintf(name, sizeof(name), "file%u.bin", i);
+        HFile file = fs->OpenFile(FileInfo(fs->BasePath(), name, false), IFile::FileMode::ReadWrite);
+        if (file) {
+            file->Write(data);
+            file->Close();
+        }
+    }
+}
+
+/*
+ * Number of files of 'fs', counted without creating file objects of lazily mounted archives
+ */
+inline size_t CountFiles(const HFileSystem& fs)
+{
+    size_t count = 0;
+    fs->ForEachFile([&count](eastl::string_view) {
+        ++count;
+    });
+    return count;
+}
+
+/*
+ * Deterministic file content, 'compressibility' of 0 gives random bytes and 1 a single repeated byte
+ */
+inline void FillData(Random& random, uint8_t* data, size_t size, double compressibility)
+{
+    const uint64_t threshold = static_cast<uint64_t>(compressibility * 256.0);
+    for (size_t i = 0; i < size; ++i) {
+        uint64_t value = random.Next();
+        data[i] = (value & 0xFF) < threshold ? 'a' : static_cast<uint8_t>(value >> 8);
+    }
+}
+
+/*
+ * Write 'count' files named '<prefix><N>.bin' of 'size' bytes into 'directory'
+ */
+inline bool WriteFiles(const std::filesystem::path& directory, const char* prefix, uint32_t count, uint64_t size, uint64_t seed)
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        return false;
+    }
+
+    Random random(seed);
+    std::vector<uint8_t> data(static_cast<size_t>(size));
+    for (uint32_t i = 0; i < count; ++i) {
+        char name[64];
+        snprintf(name, sizeof(name), "%s%u.bin", prefix, i);
+        FillData(random, data.data(), data.size(), 0.5);
+
+        std::ofstream stream(directory / name, std::ios_base::binary | std::ios_base::trunc);
+        stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!stream) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * miniz 1.x writes and reads no zip64 records, so one archive holds at most 65535 entries
+ */
+constexpr uint64_t k_MaxZipEntries = 0xFFFF;
+
+/*
+ * Pack every regular file under 'directory' into zip archive, entry names are relative paths
+ */
+inline bool WriteZip(const std::filesystem::path& directory, const std::filesystem::path& zipPath, mz_uint level = MZ_DEFAULT_LEVEL)
+{
+    mz_zip_archive archive;
+    memset(&archive, 0, sizeof(archive));
+    if (!mz_zip_writer_init_file(&archive, zipPath.string().c_str(), 0)) {
+        return false;
+    }
+
+    bool isSucceeded = true;
+    std::vector<uint8_t> data;
+    std::error_code error;
+    for (std::filesystem::recursive_directory_iterator it(directory, error), end; isSucceeded && !error && it != end; it.increment(error)) {
+        if (!it->is_regular_file()) {
+            continue;
+        }
+
+        std::ifstream stream(it->path(), std::ios_base::binary);
+        data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+        std::string name = std::filesystem::relative(it->path(), directory).generic_string();
+        isSucceeded = mz_zip_writer_add_mem(&archive, name.c_str(), data.data(), data.size(), level);
+    }
+
+    isSucceeded = isSucceeded && !error && mz_zip_writer_finalize_archive(&archive);
+    mz_zip_writer_end(&archive);
+    return isSucceeded;
+}
+
+/*
+ * Scratch directory removed on destruction
+ */
+class TempDirectory
+{
+public:
+    explicit TempDirectory(const char* name)
+    {
+        char unique[64];
+        snprintf(unique, sizeof(unique), "%s-%llu", name, static_cast<unsigned long long>(Clock::now().time_since_epoch().count()));
+        m_Path = std::filesystem::temp_directory_path() / unique;
+        std::filesystem::create_directories(m_Path);
+    }
+
+    ~TempDirectory()
+    {
+        std::error_code error;
+        std::filesystem::remove_all(m_Path, error);
+    }
+
+    TempDirectory(const TempDirectory&) = delete;
+    TempDirectory& operator=(const TempDirectory&) = delete;
+
+    inline const std::filesystem::path& Path() const
+    {
+        return m_Path;
+    }
+
+private:
+    std::filesystem::path m_Path;
+};
+
+} // namespace Titan::Vfs::Bench
+
+#endif // BENCHCOMMON_HPP
@@ -0,0 +1,183 @@
+// Lock contention of the MT build. Threads open and read the same file, disjoint files on one
+// mount, or files on a mount of their own, and time blocked on every lock is reported next to
+// throughput, from 1 thread up to --threads.
+//
+// Readers resolve through a lock-free mount table snapshot, VirtualFileSystem::m_Mutex is only
+// taken by mount changes, so its waits stay at zero unless mounts change while the bench runs.
+//
+// Usage: Titan-Vfs-bench-contention [--threads N] [--files N] [--size BYTES] [--millis N] [--native]
+
+#include "BenchCommon.hpp"
+
+#include <atomic>
+#include <vector>
+
+using namespace Titan::Vfs;
+
+namespace
+{
+
+enum class Scenario
+{
+    SameFile,
+    DisjointFiles,
+    DisjointMounts
+};
+
+const char* const k_ScenarioNames[] = { "same_file", "disjoint_files", "disjoint_mounts" };
+
+/*
+ * Lock waits summed over filesystems
+ */
+struct LockWaits
+{
+    LockWaitStats::Snapshot MountTable;
+    LockWaitStats::Snapshot ResolveCache;
+    LockWaitStats::Snapshot FileSystem;
+    LockWaitStats::Snapshot File;
+};
+
+LockWaits GetLockWaits(const VirtualFileSystem& vfs, const eastl::vector<HFileSystem>& fileSystems)
+{
+    LockWaits waits;
+    VirtualFileSystem::LockStats vfsStats = vfs.GetLockStats();
+    waits.MountTable = vfsStats.MountTable;
+    waits.ResolveCache = vfsStats.ResolveCache;
+    for (const HFileSystem& fs : fileSystems) {
+        FileSystemStats::Snapshot stats = fs->GetStats();
+        waits.FileSystem.Add(stats.FileSystemLock);
+        waits.File.Add(stats.FileLock);
+    }
+    return waits;
+}
+
+inline double WaitMillis(const LockWaitStats::Snapshot& before, const LockWaitStats::Snapshot& after)
+{
+    return static_cast<double>(after.WaitNanoseconds - before.WaitNanoseconds) / 1e6;
+}
+
+inline unsigned long long NumWaits(const LockWaitStats::Snapshot& before, const LockWaitStats::Snapshot& after)
+{
+    return static_cast<unsigned long long>(after.Waits - before.Waits);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const uint64_t maxThreads = eastl::max<uint64_t>(Bench::GetOption(argc, argv, "--threads", 64), 1);
+    const uint64_t numFiles = eastl::max<uint64_t>(Bench::GetOption(argc, argv, "--files", 256), 1);
+    const uint64_t fileSize = Bench::GetOption(argc, argv, "--size", 4096);
+    const uint64_t millis = Bench::GetOption(argc, argv, "--millis", 500);
+    const bool isNative = Bench::HasFlag(argc, argv, "--native");
+
+    if constexpr (!g_MtSupportEnabled) {
+        fprintf(stderr, "Built without TITAN_VFS_MT_SUPPORT, locks are not taken\n");
+    }
+
+    // One filesystem per potential thread, disjoint mount scenario gives each thread its own
+    Bench::TempDirectory temp("titan-vfs-contention");
+    eastl::vector<HFileSystem> fileSystems;
+    HVirtualFileSystem vfs = VirtualFileSystem::Create();
+    for (uint64_t m = 0; m < maxThreads; ++m) {
+        HFileSystem fs;
+        if (isNative) {
+            char directory[64];
+            snprintf(directory, sizeof(directory), "mount%llu", static_cast<unsigned long long>(m));
+            std::filesystem::path path = temp.Path() / directory;
+            if (!Bench::WriteFiles(path, "file", static_cast<uint32_t>(numFiles), fileSize, m + 1)) {
+                fprintf(stderr, "Can't write %s\n", path.string().c_str());
+                return 1;
+            }
+            fs = NativeFileSystem::Create(path.string().c_str());
+            fs->Initialize();
+        } else {
+            fs = MemoryFileSystem::Create();
+            fs->Initialize();
+            Bench::PopulateMemoryFileSystem(fs, static_cast<uint32_t>(numFiles), fileSize);
+        }
+
+        char alias[64];
+        snprintf(alias, sizeof(alias), "/mount%llu", static_cast<unsigned long long>(m));
+        vfs->AddFileSystem(alias, fs);
+        fileSystems.push_back(fs);
+    }
+
+    auto pathOf = [](uint64_t mount, uint64_t file) {
+        char path[128];
+        snprintf(path, sizeof(path), "/mount%llu/file%llu.bin", static_cast<unsigned long long>(mount), static_cast<unsigned long long>(file));
+        return FileInfo(eastl::string(path));
+    };
+
+    for (Scenario scenario : { Scenario::SameFile, Scenario::DisjointFiles, Scenario::DisjointMounts }) {
+        double baseline = 0.0;
+        for (uint64_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+            // Paths are built up front so threads only touch the filesystem
+            std::vector<eastl::vector<FileInfo>> threadPaths(numThreads);
+            for (uint64_t t = 0; t < numThreads; ++t) {
+                for (uint64_t f = 0; f < numFiles; ++f) {
+                    if (scenario == Scenario::SameFile) {
+                        threadPaths[t].push_back(pathOf(0, 0));
+                        break;
+                    } else if (scenario == Scenario::DisjointFiles) {
+                        // Threads share mount 0 and split its files
+                        if (f % numThreads == t) {
+                            threadPaths[t].push_back(pathOf(0, f));
+                        }
+                    } else {
+                        threadPaths[t].push_back(pathOf(t, f));
+                    }
+                }
+                if (threadPaths[t].empty()) {
+                    threadPaths[t].push_back(pathOf(0, t % numFiles));
+                }
+            }
+
+            LockWaits before = GetLockWaits(*vfs, fileSystems);
+            std::atomic<bool> isRunning = true;
+            std::atomic<uint64_t> totalOps = 0;
+            std::vector<std::thread> threads;
+            for (uint64_t t = 0; t < numThreads; ++t) {
+                threads.emplace_back([&, t]() {
+                    const eastl::vector<FileInfo>& paths = threadPaths[t];
+                    eastl::vector<uint8_t> buffer(static_cast<size_t>(eastl::max<uint64_t>(fileSize, 1)));
+                    uint64_t ops = 0;
+                    for (size_t i = 0; isRunning.load(std::memory_order_relaxed); i = (i + 1) % paths.size()) {
+                        HFile file = vfs->OpenFile(paths[i], IFile::FileMode::Read);
+                        if (file) {
+                            file->Read(buffer.data(), buffer.size());
+                            ++ops;
+                        }
+                    }
+                    totalOps.fetch_add(ops);
+                });
+            }
+
+            Bench::Clock::time_point start = Bench::Clock::now();
+            std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+            isRunning = false;
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            double seconds = Bench::SecondsSince(start);
+            LockWaits after = GetLockWaits(*vfs, fileSystems);
+
+            double opsPerSecond = static_cast<double>(totalOps.load()) / seconds;
+            if (numThreads == 1) {
+                baseline = opsPerSecond;
+            }
+
+            printf("{\"bench\":\"contention\",\"scenario\":\"%s\",\"backend\":\"%s\",\"threads\":%llu,\"ops_per_sec\":%.0f,\"speedup\":%.2f,"
+                "\"vfs_mutex_waits\":%llu,\"vfs_mutex_wait_ms\":%.3f,\"resolve_cache_waits\":%llu,\"resolve_cache_wait_ms\":%.3f,"
+                "\"fs_mutex_waits\":%llu,\"fs_mutex_wait_ms\":%.3f,\"file_mutex_waits\":%llu,\"file_mutex_wait_ms\":%.3f}\n",
+                k_ScenarioNames[static_cast<size_t>(scenario)], isNative ? "native" : "memory",
+                static_cast<unsigned long long>(numThreads), opsPerSecond, baseline > 0.0 ? opsPerSecond / baseline : 0.0,
+                NumWaits(before.MountTable, after.MountTable), WaitMillis(before.MountTable, after.MountTable),
+                NumWaits(before.ResolveCache, after.ResolveCache), WaitMillis(before.ResolveCache, after.ResolveCache),
+                NumWaits(before.FileSystem, after.FileSystem), WaitMillis(before.FileSystem, after.FileSystem),
+                NumWaits(before.File, after.File), WaitMillis(before.File, after.File));
+        }
+    }
+
+    return 0;
+}
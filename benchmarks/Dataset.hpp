@@ -0,0 +1,256 @@
+#ifndef DATASET_HPP
+#define DATASET_HPP
+
+#include "BenchCommon.hpp"
+
+#include <cmath>
+
+namespace Titan::Vfs::Bench
+{
+
+enum class SizeDistribution
+{
+    Fixed,
+    Uniform,
+    // Sizes spread evenly over orders of magnitude, most entries small and a few large, like game assets
+    LogUniform
+};
+
+/*
+ * Shape of generated data set, same options and seed always give the same bytes
+ */
+struct DatasetOptions
+{
+    uint64_t NumEntries = 10000;
+    // Directory levels above every file and subdirectories per level
+    uint32_t Depth = 3;
+    uint32_t FanOut = 16;
+
+    SizeDistribution Distribution = SizeDistribution::LogUniform;
+    uint64_t MinSize = 64;
+    uint64_t MaxSize = 256 * 1024;
+    // 0 is random bytes, 1 is a single repeated byte
+    double Compressibility = 0.5;
+
+    // Every DLC layer replaces 'DlcOverlap' of base entries and adds 'DlcNew' times base count new entries
+    uint32_t NumDlcs = 0;
+    double DlcOverlap = 0.1;
+    double DlcNew = 0.05;
+
+    uint64_t Seed = 1;
+
+    bool IsTreeWritten = true;
+    bool IsZipWritten = false;
+    mz_uint ZipLevel = MZ_DEFAULT_LEVEL;
+};
+
+/*
+ * Totals of one generated layer
+ */
+struct DatasetLayer
+{
+    std::string Name;
+    std::filesystem::path TreePath;
+    std::filesystem::path ZipPath;
+    uint64_t NumFiles = 0;
+    uint64_t NumBytes = 0;
+};
+
+/*
+ * Stateless mixing, so any entry can be generated without generating the ones before it
+ */
+inline uint64_t Mix(uint64_t value)
+{
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+inline double UnitOf(uint64_t value)
+{
+    return static_cast<double>(value >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*
+ * Relative path of entry, files are spread round robin over 'FanOut ^ Depth' leaf directories
+ */
+inline std::string DatasetEntryName(const DatasetOptions& options, uint64_t index)
+{
+    std::string name;
+    uint64_t directory = index;
+    for (uint32_t level = 0; level < options.Depth; ++level) {
+        char component[32];
+        snprintf(component, sizeof(component), "d%llu/", static_cast<unsigned long long>(directory % eastl::max(options.FanOut, 1u)));
+        name += component;
+        directory /= eastl::max(options.FanOut, 1u);
+    }
+
+    char file[32];
+    snprintf(file, sizeof(file), "f%llu.bin", static_cast<unsigned long long>(index));
+    return name + file;
+}
+
+inline uint64_t DatasetEntrySize(const DatasetOptions& options, uint64_t entrySeed)
+{
+    const uint64_t minSize = eastl::min(options.MinSize, options.MaxSize);
+    const double unit = UnitOf(Mix(entrySeed ^ 0x5157ull));
+    switch (options.Distribution) {
+    case SizeDistribution::Uniform:
+        return minSize + static_cast<uint64_t>(unit * static_cast<double>(options.MaxSize - minSize));
+    case SizeDistribution::LogUniform: {
+        const double low = std::log(static_cast<double>(eastl::max<uint64_t>(minSize, 1)));
+        const double high = std::log(static_cast<double>(eastl::max<uint64_t>(options.MaxSize, 1)));
+        return static_cast<uint64_t>(std::exp(low + unit * (high - low)));
+    }
+    default:
+        return options.MaxSize;
+    }
+}
+
+/*
+ * Writes entries of one layer into directory tree and/or zip archive
+ */
+class DatasetWriter
+{
+public:
+    DatasetWriter(const DatasetOptions& options, const std::filesystem::path& root, const std::string& name)
+        : m_Options(options)
+    {
+        m_Layer.Name = name;
+        m_Layer.TreePath = root / name;
+        m_Layer.ZipPath = root / (name + ".zip");
+        memset(&m_Archive, 0, sizeof(m_Archive));
+
+        if (m_Options.IsTreeWritten) {
+            std::error_code error;
+            std::filesystem::create_directories(m_Layer.TreePath, error);
+            m_IsSucceeded = !error;
+        }
+        if (m_IsSucceeded && m_Options.IsZipWritten) {
+            m_IsSucceeded = m_IsZipOpened = mz_zip_writer_init_file(&m_Archive, m_Layer.ZipPath.string().c_str(), 0);
+        }
+    }
+
+    ~DatasetWriter()
+    {
+        if (m_IsZipOpened) {
+            mz_zip_writer_end(&m_Archive);
+        }
+    }
+
+    DatasetWriter(const DatasetWriter&) = delete;
+    DatasetWriter& operator=(const DatasetWriter&) = delete;
+
+    bool Add(const std::string& entryName, uint64_t entrySeed)
+    {
+        if (!m_IsSucceeded) {
+            return false;
+        }
+
+        Random random(entrySeed);
+        m_Data.resize(static_cast<size_t>(DatasetEntrySize(m_Options, entrySeed)));
+        FillData(random, m_Data.data(), m_Data.size(), m_Options.Compressibility);
+
+        if (m_Options.IsTreeWritten) {
+            std::filesystem::path path = m_Layer.TreePath / entryName;
+            if (!std::filesystem::exists(path.parent_path())) {
+                std::error_code error;
+                std::filesystem::create_directories(path.parent_path(), error);
+            }
+            std::ofstream stream(path, std::ios_base::binary | std::ios_base::trunc);
+            stream.write(reinterpret_cast<const char*>(m_Data.data()), static_cast<std::streamsize>(m_Data.size()));
+            m_IsSucceeded = static_cast<bool>(stream);
+        }
+        if (m_IsSucceeded && m_IsZipOpened) {
+            if (m_Layer.NumFiles >= k_MaxZipEntries) {
+                fprintf(stderr, "%s: zip archive can't hold more than %llu entries\n", m_Layer.Name.c_str(), static_cast<unsigned long long>(k_MaxZipEntries));
+                m_IsSucceeded = false;
+                return false;
+            }
+            m_IsSucceeded = mz_zip_writer_add_mem(&m_Archive, entryName.c_str(), m_Data.data(), m_Data.size(), m_Options.ZipLevel);
+        }
+
+        m_Layer.NumFiles += m_IsSucceeded ? 1 : 0;
+        m_Layer.NumBytes += m_IsSucceeded ? m_Data.size() : 0;
+        return m_IsSucceeded;
+    }
+
+    bool Finish()
+    {
+        if (m_IsSucceeded && m_IsZipOpened) {
+            m_IsSucceeded = mz_zip_writer_finalize_archive(&m_Archive);
+        }
+        return m_IsSucceeded;
+    }
+
+    inline const DatasetLayer& Layer() const
+    {
+        return m_Layer;
+    }
+
+private:
+    const DatasetOptions& m_Options;
+    DatasetLayer m_Layer;
+    mz_zip_archive m_Archive;
+    std::vector<uint8_t> m_Data;
+    bool m_IsZipOpened = false;
+    bool m_IsSucceeded = true;
+};
+
+/*
+ * Upper bound of entries in largest layer, DLC overlap is random so it is counted as expected share
+ */
+inline uint64_t MaxLayerEntries(const DatasetOptions& options)
+{
+    const double numDlcEntries = static_cast<double>(options.NumEntries) * (options.DlcOverlap + options.DlcNew);
+    return options.NumDlcs > 0 ? eastl::max(options.NumEntries, static_cast<uint64_t>(numDlcEntries)) : options.NumEntries;
+}
+
+/*
+ * Generate 'base' layer and 'dlc<N>' layers under 'root'. DLC entries that overlap base keep
+ * base names with new content, so mounting DLCs on the same alias patches them
+ */
+inline bool GenerateDataset(const DatasetOptions& options, const std::filesystem::path& root, std::vector<DatasetLayer>& outLayers)
+{
+    {
+        DatasetWriter base(options, root, "base");
+        for (uint64_t i = 0; i < options.NumEntries; ++i) {
+            if (!base.Add(DatasetEntryName(options, i), Mix(options.Seed ^ Mix(i)))) {
+                return false;
+            }
+        }
+        if (!base.Finish()) {
+            return false;
+        }
+        outLayers.push_back(base.Layer());
+    }
+
+    const uint64_t numNew = static_cast<uint64_t>(static_cast<double>(options.NumEntries) * options.DlcNew);
+    for (uint32_t dlc = 0; dlc < options.NumDlcs; ++dlc) {
+        const uint64_t layerSeed = Mix(options.Seed + dlc + 1);
+        DatasetWriter writer(options, root, "dlc" + std::to_string(dlc + 1));
+        for (uint64_t i = 0; i < options.NumEntries; ++i) {
+            if (UnitOf(Mix(layerSeed ^ Mix(i))) < options.DlcOverlap && !writer.Add(DatasetEntryName(options, i), Mix(layerSeed + i))) {
+                return false;
+            }
+        }
+
+        // New entries continue numbering after base and previous DLCs, so names never collide
+        const uint64_t first = options.NumEntries + dlc * numNew;
+        for (uint64_t i = first; i < first + numNew; ++i) {
+            if (!writer.Add(DatasetEntryName(options, i), Mix(layerSeed + i))) {
+                return false;
+            }
+        }
+        if (!writer.Finish()) {
+            return false;
+        }
+        outLayers.push_back(writer.Layer());
+    }
+    return true;
+}
+
+} // namespace Titan::Vfs::Bench
+
+#endif // DATASET_HPP
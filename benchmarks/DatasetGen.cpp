@@ -0,0 +1,128 @@
+// Deterministic synthetic data set for scale testing. Writes a 'base' layer and optional 'dlc<N>'
+// layers as directory trees and/or zip archives, and can time how long mounting them takes.
+//
+// Usage: Titan-Vfs-gen <output dir> [--entries N] [--depth N] [--fanout N] [--distribution fixed|uniform|log]
+//     [--min-size BYTES] [--max-size BYTES] [--compressibility PERCENT] [--dlcs N] [--dlc-overlap PERCENT]
+//     [--dlc-new PERCENT] [--seed N] [--level N] [--zip] [--no-tree] [--measure]
+//   --measure  initialize every generated layer and mount them all on one alias, results are JSON lines
+
+#include "Dataset.hpp"
+
+using namespace Titan::Vfs;
+
+namespace
+{
+
+inline double MillisSince(Bench::Clock::time_point start)
+{
+    return Bench::SecondsSince(start) * 1000.0;
+}
+
+void MeasureLayers(const std::vector<Bench::DatasetLayer>& layers, const Bench::DatasetOptions& options)
+{
+    // Native tree, zip with full file list and fast mounted zip
+    const char* backends[] = { "native", "zip", "zip-fast" };
+    for (int backendIndex = 0; backendIndex < 3; ++backendIndex) {
+        bool isZip = backendIndex > 0;
+        if ((isZip && !options.IsZipWritten) || (!isZip && !options.IsTreeWritten)) {
+            continue;
+        }
+
+        const char* backend = backends[backendIndex];
+        ZipFileSystem::Options zipOptions;
+        zipOptions.IsFastMount = backendIndex == 2;
+        HVirtualFileSystem vfs = VirtualFileSystem::Create();
+        Bench::Clock::time_point mountStart = Bench::Clock::now();
+        for (const Bench::DatasetLayer& layer : layers) {
+            Bench::Clock::time_point start = Bench::Clock::now();
+            HFileSystem fs;
+            if (isZip) {
+                fs = ZipFileSystem::Create(layer.ZipPath.string().c_str(), zipOptions);
+            } else {
+                fs = NativeFileSystem::Create(layer.TreePath.string().c_str());
+            }
+            fs->Initialize();
+            double initializeMs = MillisSince(start);
+
+            printf("{\"bench\":\"dataset_initialize\",\"backend\":\"%s\",\"layer\":\"%s\",\"entries\":%llu,\"files\":%zu,\"ms\":%.3f}\n",
+                backend, layer.Name.c_str(), static_cast<unsigned long long>(layer.NumFiles), Bench::CountFiles(fs), initializeMs);
+            vfs->AddFileSystem("/data", fs);
+        }
+        double mountMs = MillisSince(mountStart);
+
+        // Merged listing reports patched entries once
+        Bench::Clock::time_point start = Bench::Clock::now();
+        size_t numListed = 0;
+        for (const auto& entry : vfs->ListDirectory("/data/", true)) {
+            numListed += entry.Name().empty() ? 0 : 1;
+        }
+        printf("{\"bench\":\"dataset_mount\",\"backend\":\"%s\",\"layers\":%zu,\"mount_ms\":%.3f,\"listed\":%zu,\"list_ms\":%.3f}\n",
+            backend, layers.size(), mountMs, numListed, MillisSince(start));
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argv[1][0] == '-') {
+        printf("Usage: %s <output dir> [--entries N] [--depth N] [--fanout N] [--distribution fixed|uniform|log] [--min-size BYTES] [--max-size BYTES]\n"
+            "    [--compressibility PERCENT] [--dlcs N] [--dlc-overlap PERCENT] [--dlc-new PERCENT] [--seed N] [--level N] [--zip] [--no-tree] [--measure]\n", argv[0]);
+        return 1;
+    }
+
+    Bench::DatasetOptions options;
+    options.NumEntries = Bench::GetOption(argc, argv, "--entries", options.NumEntries);
+    options.Depth = static_cast<uint32_t>(Bench::GetOption(argc, argv, "--depth", options.Depth));
+    options.FanOut = static_cast<uint32_t>(eastl::max<uint64_t>(Bench::GetOption(argc, argv, "--fanout", options.FanOut), 1));
+    options.MinSize = Bench::GetOption(argc, argv, "--min-size", options.MinSize);
+    options.MaxSize = Bench::GetOption(argc, argv, "--max-size", options.MaxSize);
+    options.Compressibility = static_cast<double>(Bench::GetOption(argc, argv, "--compressibility", 50)) / 100.0;
+    options.NumDlcs = static_cast<uint32_t>(Bench::GetOption(argc, argv, "--dlcs", options.NumDlcs));
+    options.DlcOverlap = static_cast<double>(Bench::GetOption(argc, argv, "--dlc-overlap", 10)) / 100.0;
+    options.DlcNew = static_cast<double>(Bench::GetOption(argc, argv, "--dlc-new", 5)) / 100.0;
+    options.Seed = Bench::GetOption(argc, argv, "--seed", options.Seed);
+    options.ZipLevel = static_cast<mz_uint>(Bench::GetOption(argc, argv, "--level", options.ZipLevel));
+    options.IsZipWritten = Bench::HasFlag(argc, argv, "--zip");
+    options.IsTreeWritten = !Bench::HasFlag(argc, argv, "--no-tree");
+
+    const char* distribution = Bench::GetStringOption(argc, argv, "--distribution", "log");
+    if (strcmp(distribution, "fixed") == 0) {
+        options.Distribution = Bench::SizeDistribution::Fixed;
+    } else if (strcmp(distribution, "uniform") == 0) {
+        options.Distribution = Bench::SizeDistribution::Uniform;
+    } else if (strcmp(distribution, "log") == 0) {
+        options.Distribution = Bench::SizeDistribution::LogUniform;
+    } else {
+        fprintf(stderr, "Unknown distribution '%s'\n", distribution);
+        return 1;
+    }
+
+    if (!options.IsTreeWritten && !options.IsZipWritten) {
+        fprintf(stderr, "Nothing to write, --no-tree needs --zip\n");
+        return 1;
+    }
+    if (options.IsZipWritten && Bench::MaxLayerEntries(options) > Bench::k_MaxZipEntries) {
+        fprintf(stderr, "--zip writes at most %llu entries per layer as miniz has no zip64, drop --zip or pass fewer --entries\n",
+            static_cast<unsigned long long>(Bench::k_MaxZipEntries));
+        return 1;
+    }
+
+    std::vector<Bench::DatasetLayer> layers;
+    Bench::Clock::time_point start = Bench::Clock::now();
+    if (!Bench::GenerateDataset(options, argv[1], layers)) {
+        fprintf(stderr, "Can't write data set into %s\n", argv[1]);
+        return 1;
+    }
+
+    for (const Bench::DatasetLayer& layer : layers) {
+        fprintf(stderr, "%s: %llu files, %.1f MiB\n", layer.Name.c_str(), static_cast<unsigned long long>(layer.NumFiles),
+            static_cast<double>(layer.NumBytes) / (1024.0 * 1024.0));
+    }
+    fprintf(stderr, "Generated in %.1f s\n", Bench::SecondsSince(start));
+
+    if (Bench::HasFlag(argc, argv, "--measure")) {
+        MeasureLayers(layers, options);
+    }
+    return 0;
+}
@@ -0,0 +1,100 @@
+// Open throughput against number of threads. Every thread opens random files spread
+// over many mounts, optionally while another thread keeps hot-swapping a layer.
+//
+// Usage: Titan-Vfs-bench-mounts [--threads N] [--mounts N] [--files N] [--millis N] [--swap]
+
+#include "BenchCommon.hpp"
+
+#include <atomic>
+#include <vector>
+
+using namespace Titan::Vfs;
+
+int main(int argc, char** argv)
+{
+    const uint64_t maxThreads = Bench::GetOption(argc, argv, "--threads", eastl::max(1u, std::thread::hardware_concurrency()));
+    const uint64_t numMounts = Bench::GetOption(argc, argv, "--mounts", 16);
+    const uint64_t numFiles = Bench::GetOption(argc, argv, "--files", 256);
+    const uint64_t millis = Bench::GetOption(argc, argv, "--millis", 1000);
+    const bool hotSwap = Bench::HasFlag(argc, argv, "--swap");
+
+    HVirtualFileSystem vfs = VirtualFileSystem::Create();
+    eastl::vector<FileInfo> paths;
+    for (uint64_t m = 0; m < numMounts; ++m) {
+        HFileSystem fs = MemoryFileSystem::Create();
+        fs->Initialize();
+        Bench::PopulateMemoryFileSystem(fs, static_cast<uint32_t>(numFiles), 64);
+
+        char alias[64];
+        snprintf(alias, sizeof(alias), "/mount%llu", static_cast<unsigned long long>(m));
+        vfs->AddFileSystem(alias, fs);
+
+        for (uint64_t f = 0; f < numFiles; ++f) {
+            char path[128];
+            snprintf(path, sizeof(path), "%s/file%llu.bin", alias, static_cast<unsigned long long>(f));
+            paths.push_back(FileInfo(eastl::string(path)));
+        }
+    }
+
+    // Spare layer that is swapped in and out of '/mount0'
+    HFileSystem swapA = vfs->GetFilesystems("/mount0").front();
+    HFileSystem swapB = MemoryFileSystem::Create();
+    swapB->Initialize();
+    Bench::PopulateMemoryFileSystem(swapB, static_cast<uint32_t>(numFiles), 64);
+
+    double baseline = 0.0;
+    for (uint64_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+        std::atomic<bool> isRunning = true;
+        std::atomic<uint64_t> totalOpens = 0;
+        std::atomic<uint64_t> totalSwaps = 0;
+
+        std::vector<std::thread> threads;
+        for (uint64_t t = 0; t < numThreads; ++t) {
+            threads.emplace_back([&, t]() {
+                Bench::Random random(t + 1);
+                uint64_t opens = 0;
+                while (isRunning.load(std::memory_order_relaxed)) {
+                    HFile file = vfs->OpenFile(paths[random.Next(paths.size())], IFile::FileMode::Read);
+                    opens += (file != nullptr);
+                }
+                totalOpens.fetch_add(opens);
+            });
+        }
+
+        std::thread swapper;
+        if (hotSwap) {
+            swapper = std::thread([&]() {
+                bool isA = true;
+                while (isRunning.load(std::memory_order_relaxed)) {
+                    vfs->ReplaceFileSystem("/mount0", isA ? swapA : swapB, isA ? swapB : swapA);
+                    isA = !isA;
+                    totalSwaps.fetch_add(1, std::memory_order_relaxed);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            });
+        }
+
+        Bench::Clock::time_point start = Bench::Clock::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+        isRunning = false;
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        if (swapper.joinable()) {
+            swapper.join();
+        }
+        double seconds = Bench::SecondsSince(start);
+
+        double opensPerSecond = static_cast<double>(totalOpens.load()) / seconds;
+        if (numThreads == 1) {
+            baseline = opensPerSecond;
+        }
+
+        printf("{\"bench\":\"mount_open\",\"threads\":%llu,\"mounts\":%llu,\"opens_per_sec\":%.0f,\"speedup\":%.2f,\"swaps\":%llu}\n",
+            static_cast<unsigned long long>(numThreads), static_cast<unsigned long long>(numMounts),
+            opensPerSecond, baseline > 0.0 ? opensPerSecond / baseline : 0.0,
+            static_cast<unsigned long long>(totalSwaps.load()));
+    }
+
+    return 0;
+}
@@ -0,0 +1,436 @@
+// Micro-benchmarks of every backend against a raw POSIX baseline. Data set is generated into
+// a temporary directory, nothing is downloaded. Every result is one JSON object per line.
+//
+// Usage: Titan-Vfs-bench [--files N] [--small-size BYTES] [--large-size BYTES] [--init-max N] [--aliases N] [--repeat N]
+
+#include "BenchCommon.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define TITAN_VFS_BENCH_POSIX 1
+#endif
+
+using namespace Titan::Vfs;
+
+namespace
+{
+
+/*
+ * Backend under test
+ */
+struct Backend
+{
+    const char* Name = "";
+    HFileSystem FileSystem;
+};
+
+struct Options
+{
+    uint64_t NumFiles = 0;
+    uint64_t SmallSize = 0;
+    uint64_t LargeSize = 0;
+    uint64_t InitMax = 0;
+    uint64_t NumAliases = 0;
+    uint64_t Repeat = 0;
+};
+
+inline uint64_t NanosecondsSince(Bench::Clock::time_point start)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Bench::Clock::now() - start).count());
+}
+
+inline double PerSecond(double amount, uint64_t nanoseconds)
+{
+    return nanoseconds > 0 ? amount * 1e9 / static_cast<double>(nanoseconds) : 0.0;
+}
+
+inline eastl::string SmallName(uint64_t index)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "small/file%llu.bin", static_cast<unsigned long long>(index));
+    return name;
+}
+
+/*
+ * Read whole file in chunks, returns number of bytes read
+ */
+inline uint64_t ReadAll(const HFile& file, eastl::vector<uint8_t>& buffer)
+{
+    uint64_t size = file->Size();
+    uint64_t total = 0;
+    while (total < size) {
+        uint64_t bytesRead = file->Read(buffer.data(), eastl::min<uint64_t>(buffer.size(), size - total));
+        if (bytesRead == 0) {
+            break;
+        }
+        total += bytesRead;
+    }
+    return total;
+}
+
+void BenchOpen(const Backend& backend, const eastl::vector<FileInfo>& paths, const Options& options)
+{
+    Bench::Random random(1);
+    uint64_t elapsed = 0;
+    uint64_t numOpens = 0;
+    for (uint64_t r = 0; r < options.Repeat; ++r) {
+        for (size_t i = 0; i < paths.size(); ++i) {
+            const FileInfo& path = paths[random.Next(paths.size())];
+            Bench::Clock::time_point start = Bench::Clock::now();
+            HFile file = backend.FileSystem->OpenFile(path, IFile::FileMode::Read);
+            elapsed += NanosecondsSince(start);
+            numOpens += (file && file->IsOpened());
+            if (file) {
+                file->Close();
+            }
+        }
+    }
+
+    printf("{\"bench\":\"open\",\"backend\":\"%s\",\"files\":%zu,\"opens\":%llu,\"ns_per_op\":%.1f}\n",
+        backend.Name, paths.size(), static_cast<unsigned long long>(numOpens),
+        numOpens ? static_cast<double>(elapsed) / static_cast<double>(numOpens) : 0.0);
+}
+
+void BenchSmallReads(const Backend& backend, const eastl::vector<FileInfo>& paths, const Options& options)
+{
+    eastl::vector<uint8_t> buffer(static_cast<size_t>(eastl::max<uint64_t>(options.SmallSize, 1)));
+    uint64_t bytes = 0;
+    uint64_t numFiles = 0;
+    Bench::Clock::time_point start = Bench::Clock::now();
+    for (uint64_t r = 0; r < options.Repeat; ++r) {
+        for (const FileInfo& path : paths) {
+            HFile file = backend.FileSystem->OpenFile(path, IFile::FileMode::Read);
+            if (!file || !file->IsOpened()) {
+                continue;
+            }
+            bytes += ReadAll(file, buffer);
+            file->Close();
+            ++numFiles;
+        }
+    }
+    uint64_t elapsed = NanosecondsSince(start);
+
+    printf("{\"bench\":\"small_read\",\"backend\":\"%s\",\"files\":%llu,\"file_size\":%llu,\"files_per_sec\":%.0f,\"mib_per_sec\":%.1f}\n",
+        backend.Name, static_cast<unsigned long long>(numFiles), static_cast<unsigned long long>(options.SmallSize),
+        PerSecond(static_cast<double>(numFiles), elapsed), PerSecond(static_cast<double>(bytes) / (1024.0 * 1024.0), elapsed));
+}
+
+void BenchLargeRead(const Backend& backend, const FileInfo& path, const Options& options)
+{
+    eastl::vector<uint8_t> buffer(1024 * 1024);
+    uint64_t bytes = 0;
+    Bench::Clock::time_point start = Bench::Clock::now();
+    for (uint64_t r = 0; r < options.Repeat; ++r) {
+        HFile file = backend.FileSystem->OpenFile(path, IFile::FileMode::Read);
+        if (!file || !file->IsOpened()) {
+            break;
+        }
+        bytes += ReadAll(file, buffer);
+        file->Close();
+    }
+    uint64_t elapsed = NanosecondsSince(start);
+
+    printf("{\"bench\":\"large_read\",\"backend\":\"%s\",\"file_size\":%llu,\"mib_per_sec\":%.1f}\n",
+        backend.Name, static_cast<unsigned long long>(options.LargeSize), PerSecond(static_cast<double>(bytes) / (1024.0 * 1024.0), elapsed));
+}
+
+/*
+ * Resolution through VirtualFileSystem with backend mounted next to 'NumAliases - 1' other aliases
+ */
+void BenchAliasResolution(const Backend& backend, const eastl::vector<FileInfo>& paths, const Options& options)
+{
+    HVirtualFileSystem vfs = VirtualFileSystem::Create();
+    for (uint64_t i = 1; i < options.NumAliases; ++i) {
+        char alias[64];
+        snprintf(alias, sizeof(alias), "/bench/other%llu", static_cast<unsigned long long>(i));
+        HFileSystem other = MemoryFileSystem::Create();
+        other->Initialize();
+        vfs->AddFileSystem(alias, other);
+    }
+    vfs->AddFileSystem("/bench", backend.FileSystem);
+
+    eastl::vector<FileInfo> virtualPaths;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        virtualPaths.push_back(FileInfo(eastl::string("/bench/") + SmallName(i)));
+    }
+
+    // First pass fills resolution cache
+    uint64_t coldElapsed = 0;
+    Bench::Clock::time_point start = Bench::Clock::now();
+    for (const FileInfo& path : virtualPaths) {
+        vfs->IsFileExists(path);
+    }
+    coldElapsed = NanosecondsSince(start);
+
+    uint64_t numLookups = 0;
+    start = Bench::Clock::now();
+    for (uint64_t r = 0; r < options.Repeat; ++r) {
+        for (const FileInfo& path : virtualPaths) {
+            numLookups += vfs->IsFileExists(path) ? 1 : 0;
+        }
+    }
+    uint64_t warmElapsed = NanosecondsSince(start);
+
+    printf("{\"bench\":\"alias_resolution\",\"backend\":\"%s\",\"aliases\":%llu,\"found\":%llu,\"cold_ns_per_op\":%.1f,\"warm_ns_per_op\":%.1f}\n",
+        backend.Name, static_cast<unsigned long long>(options.NumAliases), static_cast<unsigned long long>(numLookups),
+        virtualPaths.empty() ? 0.0 : static_cast<double>(coldElapsed) / static_cast<double>(virtualPaths.size()),
+        numLookups ? static_cast<double>(warmElapsed) / static_cast<double>(numLookups) : 0.0);
+}
+
+/*
+ * Initialize() time of native and zip backends against number of entries, fast mounted zip against full file list
+ */
+void BenchInitialize(const std::filesystem::path& root, const Options& options)
+{
+    // Largest archive miniz can open is measured too, so fast mount runs on its parallel path
+    std::vector<uint64_t> counts;
+    for (uint64_t count = 100; count <= options.InitMax; count *= 10) {
+        counts.push_back(count);
+    }
+    if (options.InitMax >= Bench::k_MaxZipEntries) {
+        counts.push_back(Bench::k_MaxZipEntries);
+        std::sort(counts.begin(), counts.end());
+    }
+
+    for (uint64_t count : counts) {
+        char name[64];
+        snprintf(name, sizeof(name), "init%llu", static_cast<unsigned long long>(count));
+        std::filesystem::path directory = root / name;
+        std::filesystem::path zipPath = root / (std::string(name) + ".zip");
+        if (!Bench::WriteFiles(directory, "entry", static_cast<uint32_t>(count), 16, count)) {
+            fprintf(stderr, "Can't write %s\n", directory.string().c_str());
+            return;
+        }
+        bool hasZip = count <= Bench::k_MaxZipEntries && Bench::WriteZip(directory, zipPath);
+
+        Bench::Clock::time_point start = Bench::Clock::now();
+        HFileSystem native = NativeFileSystem::Create(directory.string().c_str());
+        native->Initialize();
+        uint64_t nativeElapsed = NanosecondsSince(start);
+        printf("{\"bench\":\"initialize\",\"backend\":\"native\",\"entries\":%llu,\"files\":%zu,\"ms\":%.3f}\n",
+            static_cast<unsigned long long>(count), Bench::CountFiles(native), static_cast<double>(nativeElapsed) / 1e6);
+
+        if (hasZip) {
+            start = Bench::Clock::now();
+            HFileSystem zip = ZipFileSystem::Create(zipPath.string().c_str());
+            zip->Initialize();
+            uint64_t zipElapsed = NanosecondsSince(start);
+            printf("{\"bench\":\"initialize\",\"backend\":\"zip\",\"entries\":%llu,\"files\":%zu,\"ms\":%.3f}\n",
+                static_cast<unsigned long long>(count), Bench::CountFiles(zip), static_cast<double>(zipElapsed) / 1e6);
+
+            ZipFileSystem::Options mappedOptions;
+            mappedOptions.IsMapped = true;
+            start = Bench::Clock::now();
+            HFileSystem mapped = ZipFileSystem::Create(zipPath.string().c_str(), mappedOptions);
+            mapped->Initialize();
+            uint64_t mappedElapsed = NanosecondsSince(start);
+            printf("{\"bench\":\"initialize\",\"backend\":\"zip-mapped\",\"entries\":%llu,\"files\":%zu,\"ms\":%.3f}\n",
+                static_cast<unsigned long long>(count), Bench::CountFiles(mapped), static_cast<double>(mappedElapsed) / 1e6);
+
+            // Fast mount indexes names only, file objects are created as files are opened
+            ZipFileSystem::Options fastOptions;
+            fastOptions.IsFastMount = true;
+            start = Bench::Clock::now();
+            HFileSystem fast = ZipFileSystem::Create(zipPath.string().c_str(), fastOptions);
+            fast->Initialize();
+            uint64_t fastElapsed = NanosecondsSince(start);
+            printf("{\"bench\":\"initialize\",\"backend\":\"zip-fast\",\"entries\":%llu,\"files\":%zu,\"ms\":%.3f,\"index_bytes\":%llu,\"full_index_bytes\":%llu}\n",
+                static_cast<unsigned long long>(count), Bench::CountFiles(fast), static_cast<double>(fastElapsed) / 1e6,
+                static_cast<unsigned long long>(fast->IndexBytes()), static_cast<unsigned long long>(zip->IndexBytes()));
+        }
+
+#ifdef TITAN_VFS_BENCH_POSIX
+        // Baseline is a plain directory walk
+        start = Bench::Clock::now();
+        size_t numEntries = 0;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+            numEntries += entry.is_regular_file() ? 1 : 0;
+        }
+        uint64_t posixElapsed = NanosecondsSince(start);
+        printf("{\"bench\":\"initialize\",\"backend\":\"posix\",\"entries\":%llu,\"files\":%zu,\"ms\":%.3f}\n",
+            static_cast<unsigned long long>(count), numEntries, static_cast<double>(posixElapsed) / 1e6);
+#endif
+    }
+}
+
+#ifdef TITAN_VFS_BENCH_POSIX
+void BenchPosix(const std::filesystem::path& root, const Options& options)
+{
+    std::vector<std::string> paths;
+    for (uint64_t i = 0; i < options.NumFiles; ++i) {
+        paths.push_back((root / SmallName(i).c_str()).string());
+    }
+
+    Bench::Random random(1);
+    uint64_t elapsed = 0;
+    uint64_t numOpens = 0;
+    for (uint64_t r = 0; r < options.Repeat; ++r) {
+        for (size_t i = 0; i < paths.size(); ++i) {
+            const std::string& path = paths[random.Next(paths.size())];
+            Bench::Clock::time_point start = Bench::Clock::now();
+            int fd = open(path.c_str(), O_RDONLY);
+            elapsed += NanosecondsSince(start);
+            if (fd >= 0) {
+                ++numOpens;
+                close(fd);
+            }
+        }
+    }
+    printf("{\"bench\":\"open\",\"backend\":\"posix\",\"files\":%zu,\"opens\":%llu,\"ns_per_op\":%.1f}\n",
+        paths.size(), static_cast<unsigned long long>(numOpens),
+        numOpens ? static_cast<double>(elapsed) / static_cast<double>(numOpens) : 0.0);
+
+    std::vector<uint8_t> buffer(1024 * 1024);
+    auto readAll = [&buffer](const std::string& path) -> uint64_t {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return 0;
+        }
+        uint64_t total = 0;
+        for (ssize_t n; (n = read(fd, buffer.data(), buffer.size())) > 0;) {
+            total += static_cast<uint64_t>(n);
+        }
+        close(fd);
+        return total;
+    };
+
+    uint64_t bytes = 0;
+    uint64_t numFiles = 0;
+    Bench::Clock::time_point start = Bench::Clock::now();
+    for (uint64_t r = 0; r < options.Repeat; ++r) {
+        for (const std::string& path : paths) {
+            bytes += readAll(path);
+            ++numFiles;
+        }
+    }
+    elapsed = NanosecondsSince(start);
+    printf("{\"bench\":\"small_read\",\"backend\":\"posix\",\"files\":%llu,\"file_size\":%llu,\"files_per_sec\":%.0f,\"mib_per_sec\":%.1f}\n",
+        static_cast<unsigned long long>(numFiles), static_cast<unsigned long long>(options.SmallSize),
+        PerSecond(static_cast<double>(numFiles), elapsed), PerSecond(static_cast<double>(bytes) / (1024.0 * 1024.0), elapsed));
+
+    bytes = 0;
+    start = Bench::Clock::now();
+    for (uint64_t r = 0; r < options.Repeat; ++r) {
+        bytes += readAll((root / "large.bin").string());
+    }
+    elapsed = NanosecondsSince(start);
+    printf("{\"bench\":\"large_read\",\"backend\":\"posix\",\"file_size\":%llu,\"mib_per_sec\":%.1f}\n",
+        static_cast<unsigned long long>(options.LargeSize), PerSecond(static_cast<double>(bytes) / (1024.0 * 1024.0), elapsed));
+}
+#endif
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    options.NumFiles = Bench::GetOption(argc, argv, "--files", 1000);
+    options.SmallSize = Bench::GetOption(argc, argv, "--small-size", 4096);
+    options.LargeSize = Bench::GetOption(argc, argv, "--large-size", 64 * 1024 * 1024);
+    options.InitMax = Bench::GetOption(argc, argv, "--init-max", 10000);
+    options.NumAliases = eastl::max<uint64_t>(Bench::GetOption(argc, argv, "--aliases", 16), 1);
+    options.Repeat = eastl::max<uint64_t>(Bench::GetOption(argc, argv, "--repeat", 3), 1);
+
+    Bench::TempDirectory temp("titan-vfs-bench");
+    std::filesystem::path dataPath = temp.Path() / "data";
+    std::filesystem::path zipPath = temp.Path() / "data.zip";
+    if (!Bench::WriteFiles(dataPath / "small", "file", static_cast<uint32_t>(options.NumFiles), options.SmallSize, 1) ||
+        !Bench::WriteFiles(dataPath, "large", 1, options.LargeSize, 2)) {
+        fprintf(stderr, "Can't write data set into %s\n", temp.Path().string().c_str());
+        return 1;
+    }
+    std::filesystem::rename(dataPath / "large0.bin", dataPath / "large.bin");
+
+    eastl::vector<Backend> backends;
+
+    Backend native;
+    native.Name = "native";
+    native.FileSystem = NativeFileSystem::Create(dataPath.string().c_str());
+    native.FileSystem->Initialize();
+    backends.push_back(native);
+
+    if (Bench::WriteZip(dataPath, zipPath)) {
+        Backend zip;
+        zip.Name = "zip";
+        zip.FileSystem = ZipFileSystem::Create(zipPath.string().c_str());
+        zip.FileSystem->Initialize();
+        backends.push_back(zip);
+
+        ZipFileSystem::Options mappedOptions;
+        mappedOptions.IsMapped = true;
+        Backend mapped;
+        mapped.Name = "zip-mapped";
+        mapped.FileSystem = ZipFileSystem::Create(zipPath.string().c_str(), mappedOptions);
+        mapped.FileSystem->Initialize();
+        backends.push_back(mapped);
+
+        ZipFileSystem::Options streamedOptions;
+        streamedOptions.StreamingMinSize = 1024 * 1024;
+        Backend streamed;
+        streamed.Name = "zip-streamed";
+        streamed.FileSystem = ZipFileSystem::Create(zipPath.string().c_str(), streamedOptions);
+        streamed.FileSystem->Initialize();
+        backends.push_back(streamed);
+
+        ZipFileSystem::Options cachedOptions;
+        cachedOptions.EntryCacheCapacity = 128 * 1024 * 1024;
+        Backend cached;
+        cached.Name = "zip-cached";
+        cached.FileSystem = ZipFileSystem::Create(zipPath.string().c_str(), cachedOptions);
+        cached.FileSystem->Initialize();
+        backends.push_back(cached);
+
+        ZipFileSystem::Options fastOptions;
+        fastOptions.IsFastMount = true;
+        Backend fast;
+        fast.Name = "zip-fast";
+        fast.FileSystem = ZipFileSystem::Create(zipPath.string().c_str(), fastOptions);
+        fast.FileSystem->Initialize();
+        backends.push_back(fast);
+    } else {
+        fprintf(stderr, "Can't write %s, zip backend is skipped\n", zipPath.string().c_str());
+    }
+
+    // Memory backend holds the same files
+    Backend memory;
+    memory.Name = "memory";
+    memory.FileSystem = MemoryFileSystem::Create();
+    memory.FileSystem->Initialize();
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(dataPath)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+        std::ifstream stream(entry.path(), std::ios_base::binary);
+        eastl::vector<uint8_t> data;
+        for (std::istreambuf_iterator<char> it(stream), end; it != end; ++it) {
+            data.push_back(static_cast<uint8_t>(*it));
+        }
+        eastl::string name = std::filesystem::relative(entry.path(), dataPath).generic_string().c_str();
+        HFile file = memory.FileSystem->OpenFile(FileInfo(memory.FileSystem->BasePath(), name, false), IFile::FileMode::ReadWrite);
+        if (file) {
+            file->Write(data);
+            file->Close();
+        }
+    }
+    backends.push_back(memory);
+
+    for (const Backend& backend : backends) {
+        eastl::vector<FileInfo> paths;
+        for (uint64_t i = 0; i < options.NumFiles; ++i) {
+            paths.push_back(FileInfo(backend.FileSystem->BasePath(), SmallName(i), false));
+        }
+
+        BenchOpen(backend, paths, options);
+        BenchSmallReads(backend, paths, options);
+        BenchLargeRead(backend, FileInfo(backend.FileSystem->BasePath(), "large.bin", false), options);
+        BenchAliasResolution(backend, paths, options);
+    }
+
+#ifdef TITAN_VFS_BENCH_POSIX
+    BenchPosix(dataPath, options);
+#endif
+
+    BenchInitialize(temp.Path(), options);
+    return 0;
+}
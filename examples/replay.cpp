@@ -0,0 +1,200 @@
+// Replays access trace recorded with VirtualFileSystem::SetAccessTrace against any mount
+// configuration and reports throughput and latency of every operation kind.
+//
+// Usage: vfsppreplay <trace> --mount <alias> <dir|archive.zip> [--mount ...] [--threads] [--timed]
+//   --threads  replay every recorded thread on its own thread instead of one thread in recorded order
+//   --timed    keep recorded gaps between operations instead of issuing them back to back
+
+#include "Titan-Vfs/VFS.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace Titan;
+
+void* operator new[](size_t size, const char* pName, int flags, unsigned debugFlags, const char* file, int line) {
+    return malloc(size);
+}
+void* operator new[](size_t size, size_t alignment, size_t alignmentOffset, const char* pName, int flags, unsigned debugFlags, const char* file, int line) {
+    return malloc(size);
+}
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr size_t k_NumOps = static_cast<size_t>(Vfs::TraceOp::Close) + 1;
+static const char* const k_OpNames[k_NumOps] = { "path", "open", "read", "seek", "close" };
+
+/*
+ * Latencies of one replay thread, merged at the end
+ */
+struct ReplayResult
+{
+    std::vector<uint64_t> Latencies[k_NumOps];
+    uint64_t BytesRead = 0;
+    uint64_t NumFailed = 0;
+    uint64_t NumSkipped = 0;
+};
+
+static Vfs::HFileSystem CreateFileSystem(const char* path)
+{
+    size_t length = strlen(path);
+    if (length > 4 && strcmp(path + length - 4, ".zip") == 0) {
+        return Vfs::ZipFileSystem::Create(path);
+    }
+    return Vfs::NativeFileSystem::Create(path);
+}
+
+static uint64_t Percentile(const std::vector<uint64_t>& sorted, double fraction)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+static void Replay(Vfs::VirtualFileSystem& vfs, const Vfs::TraceData& trace, const std::vector<const Vfs::TraceEvent*>& events,
+    size_t numFiles, bool isTimed, Clock::time_point start, ReplayResult& result)
+{
+    // Every replay thread has own handles, so handles passed between recorded threads are skipped
+    std::vector<Vfs::HFile> files(numFiles);
+    std::vector<uint8_t> buffer;
+    for (const Vfs::TraceEvent* event : events) {
+        if (isTimed) {
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds(event->Timestamp));
+        }
+
+        Vfs::HFile file = event->Op == Vfs::TraceOp::Open ? nullptr : files[event->FileId];
+        if (event->Op != Vfs::TraceOp::Open && !file) {
+            // Open failed during replay or was made by another thread
+            ++result.NumSkipped;
+            continue;
+        }
+
+        Clock::time_point opStart = Clock::now();
+        switch (event->Op) {
+        case Vfs::TraceOp::Open:
+            file = vfs.OpenFile(Vfs::FileInfo(trace.Paths[static_cast<size_t>(event->Value)]), static_cast<Vfs::IFile::FileMode>(event->Arg));
+            if (!file || !file->IsOpened()) {
+                result.NumFailed += (event->Result != 0);
+                file = nullptr;
+            }
+            files[event->FileId] = file;
+            break;
+        case Vfs::TraceOp::Read:
+            buffer.resize(std::max(buffer.size(), static_cast<size_t>(event->Value)));
+            result.BytesRead += file->Read(buffer.data(), event->Value);
+            break;
+        case Vfs::TraceOp::Seek:
+            file->Seek(event->Value, static_cast<Vfs::IFile::Origin>(event->Arg));
+            break;
+        case Vfs::TraceOp::Close:
+            file->Close();
+            files[event->FileId] = nullptr;
+            break;
+        default:
+            continue;
+        }
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - opStart).count();
+        result.Latencies[static_cast<size_t>(event->Op)].push_back(static_cast<uint64_t>(elapsed));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        printf("Usage: %s <trace> --mount <alias> <dir|archive.zip> [--mount ...] [--threads] [--timed]\n", argv[0]);
+        return 1;
+    }
+
+    Vfs::TraceData trace;
+    if (!Vfs::AccessTrace::Load(argv[1], trace)) {
+        printf("Can't load trace '%s'\n", argv[1]);
+        return 1;
+    }
+
+    bool isThreaded = false;
+    bool isTimed = false;
+    Vfs::HVirtualFileSystem vfs = Vfs::VirtualFileSystem::Create();
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "--mount") == 0 && i + 2 < argc) {
+            Vfs::HFileSystem fs = CreateFileSystem(argv[i + 2]);
+            fs->Initialize();
+            if (!fs->IsInitialized()) {
+                printf("Can't mount '%s'\n", argv[i + 2]);
+                return 1;
+            }
+            vfs->AddFileSystem(argv[i + 1], fs);
+            i += 2;
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            isThreaded = true;
+        } else if (strcmp(argv[i], "--timed") == 0) {
+            isTimed = true;
+        }
+    }
+
+    uint32_t maxFileId = 0;
+    for (const Vfs::TraceEvent& event : trace.Events) {
+        maxFileId = std::max(maxFileId, event.FileId);
+    }
+    size_t numFiles = static_cast<size_t>(maxFileId) + 1;
+
+    size_t numStreams = isThreaded ? std::max<size_t>(trace.NumThreads, 1) : 1;
+    std::vector<std::vector<const Vfs::TraceEvent*>> streams(numStreams);
+    for (const Vfs::TraceEvent& event : trace.Events) {
+        streams[isThreaded ? event.ThreadIndex : 0].push_back(&event);
+    }
+
+    std::vector<ReplayResult> results(numStreams);
+    Clock::time_point start = Clock::now();
+    if (numStreams == 1) {
+        Replay(*vfs, trace, streams[0], numFiles, isTimed, start, results[0]);
+    } else {
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < numStreams; ++i) {
+            threads.emplace_back([&, i]() {
+                Replay(*vfs, trace, streams[i], numFiles, isTimed, start, results[i]);
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    ReplayResult total;
+    std::vector<uint64_t> recorded[k_NumOps];
+    for (ReplayResult& result : results) {
+        for (size_t op = 0; op < k_NumOps; ++op) {
+            total.Latencies[op].insert(total.Latencies[op].end(), result.Latencies[op].begin(), result.Latencies[op].end());
+        }
+        total.BytesRead += result.BytesRead;
+        total.NumFailed += result.NumFailed;
+        total.NumSkipped += result.NumSkipped;
+    }
+    for (const Vfs::TraceEvent& event : trace.Events) {
+        recorded[static_cast<size_t>(event.Op)].push_back(event.Duration);
+    }
+
+    printf("Replayed %zu operations on %zu thread(s) in %.3f s, %.1f MiB/s, %llu failed opens, %llu skipped\n",
+        trace.Events.size(), numStreams, seconds, static_cast<double>(total.BytesRead) / (1024.0 * 1024.0) / seconds,
+        static_cast<unsigned long long>(total.NumFailed), static_cast<unsigned long long>(total.NumSkipped));
+    printf("%-6s %10s %12s %12s %12s %12s %14s %14s\n", "op", "count", "p50 ns", "p90 ns", "p99 ns", "max ns", "recorded p50", "recorded p99");
+    for (size_t op = static_cast<size_t>(Vfs::TraceOp::Open); op < k_NumOps; ++op) {
+        std::sort(total.Latencies[op].begin(), total.Latencies[op].end());
+        std::sort(recorded[op].begin(), recorded[op].end());
+        printf("%-6s %10zu %12llu %12llu %12llu %12llu %14llu %14llu\n", k_OpNames[op], total.Latencies[op].size(),
+            static_cast<unsigned long long>(Percentile(total.Latencies[op], 0.5)),
+            static_cast<unsigned long long>(Percentile(total.Latencies[op], 0.9)),
+            static_cast<unsigned long long>(Percentile(total.Latencies[op], 0.99)),
+            static_cast<unsigned long long>(total.Latencies[op].empty() ? 0 : total.Latencies[op].back()),
+            static_cast<unsigned long long>(Percentile(recorded[op], 0.5)),
+            static_cast<unsigned long long>(Percentile(recorded[op], 0.99)));
+    }
+
+    return 0;
+}
@@ -0,0 +1,323 @@
+#ifndef ACCESSTRACE_HPP
+#define ACCESSTRACE_HPP
+
+#include "IFile.h"
+#include "StringUtils.hpp"
+
+#include <chrono>
+#include <thread>
+
+namespace Titan::Vfs
+{
+
+using HAccessTrace = eastl::shared_ptr<class AccessTrace>;
+
+/*
+ * Traced file operation
+ */
+enum class TraceOp : uint8_t
+{
+    // Defines path string, followed by its bytes
+    Path,
+    Open,
+    Read,
+    Seek,
+    Close
+};
+
+/*
+ * One decoded trace record. Meaning of fields depends on operation:
+ *  Open  - Value is path index, Arg is file mode, Result is 1 if file was opened
+ *  Read  - Value is requested size, Result is number of bytes read
+ *  Seek  - Value is offset, Arg is origin, Result is new position
+ *  Close - no payload
+ */
+struct TraceEvent
+{
+    TraceOp Op = TraceOp::Open;
+    uint8_t Arg = 0;
+    uint16_t ThreadIndex = 0;
+    // Handle returned by one open, shared by all operations on it
+    uint32_t FileId = 0;
+    // Nanoseconds since recording started
+    uint64_t Timestamp = 0;
+    uint32_t Duration = 0;
+    uint64_t Value = 0;
+    uint64_t Result = 0;
+};
+
+/*
+ * Whole trace loaded in memory
+ */
+struct TraceData
+{
+    eastl::vector<eastl::string> Paths;
+    eastl::vector<TraceEvent> Events;
+    uint32_t NumThreads = 0;
+};
+
+/*
+ * Compact binary recorder of file accesses. Records are fixed size little-endian,
+ * paths are written once on first use and referenced by index afterwards.
+ * Data is buffered and written out in large chunks.
+ */
+class AccessTrace final
+{
+    AccessTrace(std::ofstream&& stream)
+        : m_Stream(eastl::move(stream))
+        , m_Start(std::chrono::steady_clock::now())
+    {
+        m_Buffer.reserve(k_FlushSize);
+        uint8_t header[k_HeaderSize] = {};
+        memcpy(header, k_Magic, sizeof(k_Magic));
+        PutU32(header + 8, k_Version);
+        m_Buffer.insert(m_Buffer.end(), header, header + k_HeaderSize);
+    }
+public:
+    ~AccessTrace()
+    {
+        Flush();
+    }
+
+    AccessTrace(const AccessTrace&) = delete;
+    AccessTrace& operator=(const AccessTrace&) = delete;
+
+    /*
+     * Start recording into 'filePath', returns null if file can't be created
+     */
+    static HAccessTrace Create(const eastl::string& filePath)
+    {
+        std::ofstream stream(filePath.c_str(), std::ios_base::binary | std::ios_base::trunc);
+        if (!stream.is_open()) {
+            return nullptr;
+        }
+        return HAccessTrace(new AccessTrace(eastl::move(stream)));
+    }
+
+    /*
+     * Nanoseconds since recording started
+     */
+    inline uint64_t Now() const
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_Start).count());
+    }
+
+    /*
+     * Record open that started at 'start', returns id of the handle
+     */
+    uint32_t RecordOpen(eastl::string_view path, IFile::FileMode mode, uint64_t start, bool isOpened)
+    {
+        uint64_t end = Now();
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return RecordOpenST(path, mode, start, end, isOpened);
+        } else {
+            return RecordOpenST(path, mode, start, end, isOpened);
+        }
+    }
+
+    void RecordRead(uint32_t fileId, uint64_t start, uint64_t size, uint64_t bytesRead)
+    {
+        Record(TraceOp::Read, 0, fileId, start, size, bytesRead);
+    }
+
+    void RecordSeek(uint32_t fileId, uint64_t start, uint64_t offset, IFile::Origin origin, uint64_t position)
+    {
+        Record(TraceOp::Seek, static_cast<uint8_t>(origin), fileId, start, offset, position);
+    }
+
+    void RecordClose(uint32_t fileId, uint64_t start)
+    {
+        Record(TraceOp::Close, 0, fileId, start, 0, 0);
+    }
+
+    /*
+     * Write buffered records to file
+     */
+    void Flush()
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            FlushST();
+        } else {
+            FlushST();
+        }
+    }
+
+    /*
+     * Read trace written by recorder. Truncated tail of an interrupted recording is ignored
+     */
+    static bool Load(const eastl::string& filePath, TraceData& outData)
+    {
+        std::ifstream stream(filePath.c_str(), std::ios_base::binary);
+        if (!stream.is_open()) {
+            return false;
+        }
+
+        uint8_t header[k_HeaderSize];
+        if (!stream.read(reinterpret_cast<char*>(header), k_HeaderSize) || memcmp(header, k_Magic, sizeof(k_Magic)) != 0) {
+            return false;
+        }
+        if (GetU32(header + 8) != k_Version) {
+            return false;
+        }
+
+        outData = TraceData();
+        uint8_t record[k_RecordSize];
+        while (stream.read(reinterpret_cast<char*>(record), k_RecordSize)) {
+            TraceEvent event = DecodeRecord(record);
+            outData.NumThreads = eastl::max(outData.NumThreads, static_cast<uint32_t>(event.ThreadIndex) + 1);
+
+            if (event.Op == TraceOp::Path) {
+                eastl::string path(static_cast<size_t>(event.Value), '\0');
+                if (!stream.read(path.data(), static_cast<std::streamsize>(path.size()))) {
+                    break;
+                }
+                if (event.FileId != outData.Paths.size()) {
+                    return false;
+                }
+                outData.Paths.push_back(eastl::move(path));
+                continue;
+            }
+
+            if (event.Op > TraceOp::Close || (event.Op == TraceOp::Open && event.Value >= outData.Paths.size())) {
+                return false;
+            }
+            outData.Events.push_back(event);
+        }
+
+        return true;
+    }
+
+private:
+    static constexpr char k_Magic[8] = { 'T', 'V', 'F', 'S', 'T', 'R', 'C', 'E' };
+    static constexpr uint32_t k_Version = 1;
+    static constexpr size_t k_HeaderSize = 16;
+    static constexpr size_t k_RecordSize = 36;
+    static constexpr size_t k_FlushSize = 1024 * 1024;
+
+    inline void Record(TraceOp op, uint8_t arg, uint32_t fileId, uint64_t start, uint64_t value, uint64_t result)
+    {
+        uint64_t end = Now();
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            AppendST(op, arg, fileId, start, end, value, result);
+        } else {
+            AppendST(op, arg, fileId, start, end, value, result);
+        }
+    }
+
+    inline uint32_t RecordOpenST(eastl::string_view path, IFile::FileMode mode, uint64_t start, uint64_t end, bool isOpened)
+    {
+        auto it = m_PathIndices.find_as(path, StringHash(), StringEqual());
+        if (it == m_PathIndices.end()) {
+            uint32_t pathIndex = static_cast<uint32_t>(m_PathIndices.size());
+            it = m_PathIndices.insert(eastl::make_pair(eastl::string(path.data(), path.length()), pathIndex)).first;
+
+            AppendST(TraceOp::Path, 0, pathIndex, start, start, path.length(), 0);
+            m_Buffer.insert(m_Buffer.end(), path.begin(), path.end());
+        }
+
+        uint32_t fileId = m_NextFileId++;
+        AppendST(TraceOp::Open, static_cast<uint8_t>(mode), fileId, start, end, it->second, isOpened ? 1 : 0);
+        return fileId;
+    }
+
+    inline void AppendST(TraceOp op, uint8_t arg, uint32_t fileId, uint64_t start, uint64_t end, uint64_t value, uint64_t result)
+    {
+        uint64_t duration = end > start ? end - start : 0;
+
+        uint8_t record[k_RecordSize];
+        record[0] = static_cast<uint8_t>(op);
+        record[1] = arg;
+        PutU16(record + 2, ThreadIndexST());
+        PutU32(record + 4, fileId);
+        PutU64(record + 8, start);
+        PutU32(record + 16, static_cast<uint32_t>(eastl::min<uint64_t>(duration, 0xFFFFFFFF)));
+        PutU64(record + 20, value);
+        PutU64(record + 28, result);
+        m_Buffer.insert(m_Buffer.end(), record, record + k_RecordSize);
+
+        if (m_Buffer.size() >= k_FlushSize) {
+            FlushST();
+        }
+    }
+
+    inline void FlushST()
+    {
+        if (!m_Buffer.empty()) {
+            m_Stream.write(reinterpret_cast<const char*>(m_Buffer.data()), static_cast<std::streamsize>(m_Buffer.size()));
+            m_Buffer.clear();
+        }
+        m_Stream.flush();
+    }
+
+    /*
+     * Threads are numbered densely in order of their first record
+     */
+    inline uint16_t ThreadIndexST()
+    {
+        uint64_t threadKey = static_cast<uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+        auto it = m_ThreadIndices.find(threadKey);
+        if (it == m_ThreadIndices.end()) {
+            it = m_ThreadIndices.insert(eastl::make_pair(threadKey, static_cast<uint16_t>(m_ThreadIndices.size()))).first;
+        }
+        return it->second;
+    }
+
+    static inline TraceEvent DecodeRecord(const uint8_t* record)
+    {
+        TraceEvent event;
+        event.Op = static_cast<TraceOp>(record[0]);
+        event.Arg = record[1];
+        event.ThreadIndex = static_cast<uint16_t>(record[2] | (record[3] << 8));
+        event.FileId = GetU32(record + 4);
+        event.Timestamp = GetU64(record + 8);
+        event.Duration = GetU32(record + 16);
+        event.Value = GetU64(record + 20);
+        event.Result = GetU64(record + 28);
+        return event;
+    }
+
+    static inline void PutU16(uint8_t* data, uint16_t value)
+    {
+        data[0] = static_cast<uint8_t>(value);
+        data[1] = static_cast<uint8_t>(value >> 8);
+    }
+
+    static inline void PutU32(uint8_t* data, uint32_t value)
+    {
+        PutU16(data, static_cast<uint16_t>(value));
+        PutU16(data + 2, static_cast<uint16_t>(value >> 16));
+    }
+
+    static inline void PutU64(uint8_t* data, uint64_t value)
+    {
+        PutU32(data, static_cast<uint32_t>(value));
+        PutU32(data + 4, static_cast<uint32_t>(value >> 32));
+    }
+
+    static inline uint32_t GetU32(const uint8_t* data)
+    {
+        return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+            (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+    }
+
+    static inline uint64_t GetU64(const uint8_t* data)
+    {
+        return static_cast<uint64_t>(GetU32(data)) | (static_cast<uint64_t>(GetU32(data + 4)) << 32);
+    }
+
+private:
+    std::ofstream m_Stream;
+    std::chrono::steady_clock::time_point m_Start;
+    eastl::vector<uint8_t> m_Buffer;
+    eastl::unordered_map<eastl::string, uint32_t, StringHash, StringEqual> m_PathIndices;
+    eastl::unordered_map<uint64_t, uint16_t> m_ThreadIndices;
+    uint32_t m_NextFileId = 0;
+    mutable std::mutex m_Mutex;
+};
+
+} // namespace vfspp
+
+#endif // ACCESSTRACE_HPP
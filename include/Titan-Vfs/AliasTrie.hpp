@@ -0,0 +1,117 @@
+#ifndef ALIASTRIE_HPP
+#define ALIASTRIE_HPP
+
+#include "Global.h"
+#include "StringUtils.hpp"
+
+#include <EASTL/fixed_vector.h>
+
+namespace Titan::Vfs
+{
+
+/*
+ * Path component trie over registered aliases. Every alias ends with '/', so it
+ * is stored as a chain of segments that each keep their trailing slash
+ * ('/dlc/en/' -> '/', 'dlc/', 'en/'). A lookup walks the path once and reports
+ * every alias that prefixes it together with the remaining relative path.
+ */
+template<typename TValue>
+class AliasTrie final
+{
+public:
+    struct Match
+    {
+        const eastl::string* Alias;
+        const TValue* Value;
+        eastl::string_view RelativePath;
+    };
+
+    typedef eastl::fixed_vector<Match, 8, true> TMatchList;
+
+public:
+    AliasTrie()
+    {
+        Clear();
+    }
+
+    /*
+     * Remove all aliases
+     */
+    void Clear()
+    {
+        m_Nodes.clear();
+        m_Nodes.push_back(Node());
+    }
+
+    /*
+     * Register alias, alias must end with '/'
+     */
+    void Insert(const eastl::string& alias, const TValue& value)
+    {
+        uint32_t node = 0;
+        size_t start = 0;
+        size_t end = 0;
+        while ((end = alias.find('/', start)) != eastl::string::npos) {
+            eastl::string_view segment(alias.data() + start, end - start + 1);
+            auto it = m_Nodes[node].Children.find_as(segment, StringHash(), StringEqual());
+            if (it != m_Nodes[node].Children.end()) {
+                node = it->second;
+            } else {
+                uint32_t child = static_cast<uint32_t>(m_Nodes.size());
+                m_Nodes[node].Children[eastl::string(segment.data(), segment.length())] = child;
+                m_Nodes.push_back(Node());
+                node = child;
+            }
+            start = end + 1;
+        }
+
+        m_Nodes[node].IsAlias = true;
+        m_Nodes[node].Alias = alias;
+        m_Nodes[node].Value = value;
+    }
+
+    /*
+     * Collect all aliases that prefix 'path' ordered from the longest to the shortest.
+     * Relative paths in matches point into 'path'
+     */
+    void FindMatches(eastl::string_view path, TMatchList& outMatches) const
+    {
+        outMatches.clear();
+
+        uint32_t node = 0;
+        size_t start = 0;
+        size_t end = 0;
+        while ((end = path.find('/', start)) != eastl::string_view::npos) {
+            eastl::string_view segment = path.substr(start, end - start + 1);
+            auto it = m_Nodes[node].Children.find_as(segment, StringHash(), StringEqual());
+            if (it == m_Nodes[node].Children.end()) {
+                break;
+            }
+
+            node = it->second;
+            start = end + 1;
+
+            const Node& current = m_Nodes[node];
+            if (current.IsAlias) {
+                outMatches.push_back(Match{ &current.Alias, &current.Value, path.substr(start) });
+            }
+        }
+
+        eastl::reverse(outMatches.begin(), outMatches.end());
+    }
+
+private:
+    struct Node
+    {
+        eastl::unordered_map<eastl::string, uint32_t, StringHash, StringEqual> Children;
+        eastl::string Alias;
+        TValue Value = TValue();
+        bool IsAlias = false;
+    };
+
+    eastl::vector<Node> m_Nodes;
+};
+
+} // namespace vfspp
+
+#endif // ALIASTRIE_HPP
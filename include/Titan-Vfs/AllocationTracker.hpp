@@ -0,0 +1,185 @@
+#ifndef ALLOCATIONTRACKER_HPP
+#define ALLOCATIONTRACKER_HPP
+
+#include "Global.h"
+
+#include <atomic>
+
+namespace Titan::Vfs
+{
+
+/*
+ * Operations measured by AllocationScope
+ */
+enum class AllocOp : uint8_t
+{
+    OpenFile,
+    Read,
+    Write,
+    ReadFiles,
+    ListDirectory,
+    Mount,
+    Count
+};
+
+/*
+ * Counts heap allocations per thread and per VFS operation when TITAN_VFS_ALLOC_TRACKING is defined.
+ * Allocations are reported by the application through OnAllocate, usually from the EASTL
+ * 'operator new[]' hooks and optionally from global 'operator new'
+ */
+class AllocationTracker final
+{
+public:
+    struct Counters
+    {
+        uint64_t Allocations = 0;
+        uint64_t Bytes = 0;
+    };
+
+    struct OpStats
+    {
+        uint64_t Calls = 0;
+        uint64_t Allocations = 0;
+        uint64_t Bytes = 0;
+        // Largest single call
+        uint64_t MaxAllocations = 0;
+        uint64_t MaxBytes = 0;
+    };
+
+public:
+    AllocationTracker() = delete;
+
+    static inline void OnAllocate(size_t size)
+    {
+        if constexpr (g_AllocTrackingEnabled) {
+            Counters& counters = ThreadCounters();
+            ++counters.Allocations;
+            counters.Bytes += size;
+        }
+    }
+
+    /*
+     * Allocations made by calling thread so far
+     */
+    static inline Counters GetThreadCounters()
+    {
+        return ThreadCounters();
+    }
+
+    static inline OpStats GetStats(AllocOp op)
+    {
+        const OpCounters& counters = Ops()[static_cast<size_t>(op)];
+        OpStats stats;
+        stats.Calls = counters.Calls.load(std::memory_order_relaxed);
+        stats.Allocations = counters.Allocations.load(std::memory_order_relaxed);
+        stats.Bytes = counters.Bytes.load(std::memory_order_relaxed);
+        stats.MaxAllocations = counters.MaxAllocations.load(std::memory_order_relaxed);
+        stats.MaxBytes = counters.MaxBytes.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    static inline void ResetStats()
+    {
+        for (OpCounters& counters : Ops()) {
+            counters.Calls.store(0, std::memory_order_relaxed);
+            counters.Allocations.store(0, std::memory_order_relaxed);
+            counters.Bytes.store(0, std::memory_order_relaxed);
+            counters.MaxAllocations.store(0, std::memory_order_relaxed);
+            counters.MaxBytes.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    static inline const char* GetOpName(AllocOp op)
+    {
+        static const char* const names[] = { "open_file", "read", "write", "read_files", "list_directory", "mount" };
+        return op < AllocOp::Count ? names[static_cast<size_t>(op)] : "";
+    }
+
+private:
+    friend class AllocationScope;
+
+    struct OpCounters
+    {
+        std::atomic<uint64_t> Calls = 0;
+        std::atomic<uint64_t> Allocations = 0;
+        std::atomic<uint64_t> Bytes = 0;
+        std::atomic<uint64_t> MaxAllocations = 0;
+        std::atomic<uint64_t> MaxBytes = 0;
+    };
+
+    static inline Counters& ThreadCounters()
+    {
+        thread_local Counters counters;
+        return counters;
+    }
+
+    static inline OpCounters (&Ops())[static_cast<size_t>(AllocOp::Count)]
+    {
+        static OpCounters ops[static_cast<size_t>(AllocOp::Count)];
+        return ops;
+    }
+
+    static inline void UpdateMax(std::atomic<uint64_t>& max, uint64_t value)
+    {
+        uint64_t current = max.load(std::memory_order_relaxed);
+        while (current < value && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    static inline void Record(AllocOp op, const Counters& delta)
+    {
+        OpCounters& counters = Ops()[static_cast<size_t>(op)];
+        counters.Calls.fetch_add(1, std::memory_order_relaxed);
+        counters.Allocations.fetch_add(delta.Allocations, std::memory_order_relaxed);
+        counters.Bytes.fetch_add(delta.Bytes, std::memory_order_relaxed);
+        UpdateMax(counters.MaxAllocations, delta.Allocations);
+        UpdateMax(counters.MaxBytes, delta.Bytes);
+    }
+};
+
+/*
+ * Attributes allocations made by current thread during its lifetime to an operation. Nested
+ * scopes are inclusive, allocations of an OpenFile inside ReadFiles count for both.
+ * Compiles to nothing without TITAN_VFS_ALLOC_TRACKING
+ */
+class AllocationScope final
+{
+public:
+    explicit AllocationScope(AllocOp op)
+        : m_Op(op)
+    {
+        if constexpr (g_AllocTrackingEnabled) {
+            m_Start = AllocationTracker::ThreadCounters();
+        }
+    }
+
+    ~AllocationScope()
+    {
+        if constexpr (g_AllocTrackingEnabled) {
+            AllocationTracker::Record(m_Op, Delta());
+        }
+    }
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+    /*
+     * Allocations made since scope was entered
+     */
+    inline AllocationTracker::Counters Delta() const
+    {
+        const AllocationTracker::Counters& current = AllocationTracker::ThreadCounters();
+        AllocationTracker::Counters delta;
+        delta.Allocations = current.Allocations - m_Start.Allocations;
+        delta.Bytes = current.Bytes - m_Start.Bytes;
+        return delta;
+    }
+
+private:
+    AllocOp m_Op;
+    AllocationTracker::Counters m_Start;
+};
+
+} // namespace vfspp
+
+#endif // ALLOCATIONTRACKER_HPP
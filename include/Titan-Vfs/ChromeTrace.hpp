@@ -0,0 +1,240 @@
+#ifndef CHROMETRACE_HPP
+#define CHROMETRACE_HPP
+
+#include "Global.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+namespace Titan::Vfs
+{
+
+using HChromeTrace = eastl::shared_ptr<class ChromeTrace>;
+
+/*
+ * Writes VFS activity as Chrome trace event JSON, loadable by chrome://tracing and Perfetto.
+ * One sink is active per process. Every event is a complete ('X') event with begin time and
+ * duration on the thread that did the work. Timestamps are microseconds of steady clock,
+ * so they line up with other captures that use the same clock
+ */
+class ChromeTrace final
+{
+    ChromeTrace(FILE* file)
+        : m_File(file)
+    {
+        m_Buffer.reserve(k_FlushSize + 1024);
+        m_Buffer.append("[\n");
+    }
+public:
+    ~ChromeTrace()
+    {
+        // Metadata event closes array without a trailing comma
+        m_Buffer.append("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Titan-Vfs\"}}\n]\n");
+        FlushST();
+        fclose(m_File);
+    }
+
+    ChromeTrace(const ChromeTrace&) = delete;
+    ChromeTrace& operator=(const ChromeTrace&) = delete;
+
+    /*
+     * Create sink writing into 'filePath', returns null if file can't be created.
+     * File is complete once sink is destroyed
+     */
+    static HChromeTrace Create(const eastl::string& filePath)
+    {
+        FILE* file = fopen(filePath.c_str(), "wb");
+        if (!file) {
+            return nullptr;
+        }
+        return HChromeTrace(new ChromeTrace(file));
+    }
+
+    /*
+     * Make 'trace' the sink of all filesystems, null stops recording
+     */
+    static void SetActive(HChromeTrace trace)
+    {
+        std::lock_guard<std::mutex> lock(SinkMutex());
+        IsActiveFlag().store(trace != nullptr, std::memory_order_relaxed);
+        Sink() = eastl::move(trace);
+    }
+
+    static HChromeTrace GetActive()
+    {
+        std::lock_guard<std::mutex> lock(SinkMutex());
+        return Sink();
+    }
+
+    static inline bool IsActive()
+    {
+        return IsActiveFlag().load(std::memory_order_relaxed);
+    }
+
+    /*
+     * Steady clock in nanoseconds, zero while no sink is active
+     */
+    static inline uint64_t Start()
+    {
+        return IsActive() ? Now() : 0;
+    }
+
+    static inline uint64_t Now()
+    {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        // Never zero, zero marks an unmeasured operation
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()) | 1;
+    }
+
+    /*
+     * Emit event that began at 'start' returned by Start() and ends now. 'category' and
+     * 'name' must be string literals, 'path' is copied into event arguments if not empty
+     */
+    static void Emit(const char* category, const char* name, uint64_t start, eastl::string_view path = eastl::string_view())
+    {
+        if (start == 0) {
+            return;
+        }
+
+        uint64_t end = Now();
+        uint32_t threadId = ThreadId();
+
+        std::lock_guard<std::mutex> lock(SinkMutex());
+        if (Sink()) {
+            Sink()->AppendST(category, name, start, end, threadId, path);
+        }
+    }
+
+    /*
+     * Write buffered events to file
+     */
+    void Flush()
+    {
+        std::lock_guard<std::mutex> lock(SinkMutex());
+        FlushST();
+    }
+
+private:
+    static constexpr size_t k_FlushSize = 256 * 1024;
+
+    inline void AppendST(const char* category, const char* name, uint64_t start, uint64_t end, uint32_t threadId, eastl::string_view path)
+    {
+        uint64_t duration = end > start ? end - start : 0;
+
+        char event[256];
+        int length = snprintf(event, sizeof(event), "{\"cat\":\"%s\",\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu.%03u,\"dur\":%llu.%03u",
+            category, name, threadId,
+            static_cast<unsigned long long>(start / 1000), static_cast<unsigned>(start % 1000),
+            static_cast<unsigned long long>(duration / 1000), static_cast<unsigned>(duration % 1000));
+        m_Buffer.append(event, static_cast<size_t>(eastl::clamp(length, 0, static_cast<int>(sizeof(event) - 1))));
+
+        if (!path.empty()) {
+            m_Buffer.append(",\"args\":{\"path\":\"");
+            AppendEscapedST(path);
+            m_Buffer.append("\"}");
+        }
+        m_Buffer.append("},\n");
+
+        if (m_Buffer.size() >= k_FlushSize) {
+            FlushST();
+        }
+    }
+
+    inline void AppendEscapedST(eastl::string_view text)
+    {
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                m_Buffer.push_back('\\');
+                m_Buffer.push_back(c);
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                m_Buffer.append(escaped);
+            } else {
+                m_Buffer.push_back(c);
+            }
+        }
+    }
+
+    inline void FlushST()
+    {
+        if (!m_Buffer.empty()) {
+            fwrite(m_Buffer.data(), 1, m_Buffer.size(), m_File);
+            m_Buffer.clear();
+        }
+        fflush(m_File);
+    }
+
+    /*
+     * Threads are numbered in order of their first event
+     */
+    static inline uint32_t ThreadId()
+    {
+        static std::atomic<uint32_t> nextThreadId = 1;
+        thread_local uint32_t threadId = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+        return threadId;
+    }
+
+    static inline std::mutex& SinkMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static inline HChromeTrace& Sink()
+    {
+        static HChromeTrace sink;
+        return sink;
+    }
+
+    static inline std::atomic<bool>& IsActiveFlag()
+    {
+        static std::atomic<bool> isActive = false;
+        return isActive;
+    }
+
+private:
+    FILE* m_File;
+    eastl::string m_Buffer;
+};
+
+/*
+ * Emits an event covering enclosing scope, costs one relaxed load while no sink is active
+ */
+class TraceScope final
+{
+public:
+    TraceScope(const char* category, const char* name, eastl::string_view path = eastl::string_view())
+        : m_Category(category)
+        , m_Name(name)
+        , m_Path(path)
+        , m_Start(ChromeTrace::Start())
+    {
+    }
+
+    TraceScope(const char* category, const char* name, const eastl::string& path)
+        : TraceScope(category, name, eastl::string_view(path.data(), path.length()))
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (m_Start != 0) {
+            ChromeTrace::Emit(m_Category, m_Name, m_Start, m_Path);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* m_Category;
+    const char* m_Name;
+    eastl::string_view m_Path;
+    uint64_t m_Start;
+};
+
+} // namespace vfspp
+
+#endif // CHROMETRACE_HPP
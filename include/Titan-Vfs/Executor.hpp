@@ -0,0 +1,205 @@
+#ifndef EXECUTOR_HPP
+#define EXECUTOR_HPP
+
+#include "Global.h"
+
+#include <condition_variable>
+#include <thread>
+
+#include <EASTL/deque.h>
+
+namespace Titan::Vfs
+{
+
+using HExecutor = eastl::shared_ptr<class IExecutor>;
+
+/*
+ * Scheduling hint, executors without priorities may ignore it
+ */
+enum class TaskPriority : uint8_t
+{
+    Low,
+    Normal,
+    High
+};
+
+/*
+ * Runs asynchronous filesystem work. Implement it to route requests into an existing job system
+ */
+class IExecutor
+{
+public:
+    typedef eastl::function<void()> TTask;
+
+public:
+    IExecutor() = default;
+    virtual ~IExecutor() = default;
+
+    /*
+     * Schedule task, it may run on any thread
+     */
+    virtual void Submit(TTask task) = 0;
+
+    /*
+     * Schedule task with priority, by default priority is ignored
+     */
+    virtual void Submit(TTask task, TaskPriority priority)
+    {
+        Submit(eastl::move(task));
+    }
+
+    /*
+     * Executors that run tasks on submitting thread return true, work that only pays off in background is then skipped
+     */
+    virtual bool IsInline() const
+    {
+        return false;
+    }
+};
+
+/*
+ * Runs tasks immediately on the submitting thread
+ */
+class InlineExecutor final : public IExecutor
+{
+public:
+    static HExecutor Create()
+    {
+        return HExecutor(new InlineExecutor());
+    }
+
+    virtual void Submit(TTask task) override
+    {
+        task();
+    }
+
+    virtual void Submit(TTask task, TaskPriority priority) override
+    {
+        task();
+    }
+
+    virtual bool IsInline() const override
+    {
+        return true;
+    }
+};
+
+/*
+ * Fixed set of worker threads serving one queue per priority. Higher priority queues are
+ * drained first, queued tasks are finished before destruction
+ */
+class ThreadPoolExecutor final : public IExecutor
+{
+    ThreadPoolExecutor(uint32_t numThreads)
+        : m_State(eastl::make_shared<State>())
+    {
+        for (uint32_t i = 0; i < numThreads; ++i) {
+            m_Threads.emplace_back([state = m_State]() {
+                WorkerLoop(*state);
+            });
+        }
+    }
+public:
+    ~ThreadPoolExecutor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_State->Mutex);
+            m_State->IsStopping = true;
+        }
+        m_State->Condition.notify_all();
+
+        // Last owner may be released by a task, that worker can't join itself and exits on its own
+        for (std::thread& thread : m_Threads) {
+            if (thread.get_id() == std::this_thread::get_id()) {
+                thread.detach();
+            } else {
+                thread.join();
+            }
+        }
+    }
+
+    /*
+     * Create pool, zero threads means one per hardware thread
+     */
+    static HExecutor Create(uint32_t numThreads = 0)
+    {
+        if (numThreads == 0) {
+            numThreads = eastl::max(2u, std::thread::hardware_concurrency());
+        }
+        return HExecutor(new ThreadPoolExecutor(numThreads));
+    }
+
+    virtual void Submit(TTask task) override
+    {
+        Submit(eastl::move(task), TaskPriority::Normal);
+    }
+
+    virtual void Submit(TTask task, TaskPriority priority) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_State->Mutex);
+            m_State->Tasks[static_cast<size_t>(priority)].push_back(eastl::move(task));
+            ++m_State->NumTasks;
+        }
+        m_State->Condition.notify_one();
+    }
+
+    /*
+     * Number of worker threads
+     */
+    size_t NumThreads() const
+    {
+        return m_Threads.size();
+    }
+
+private:
+    static constexpr size_t k_NumPriorities = static_cast<size_t>(TaskPriority::High) + 1;
+
+    /*
+     * Shared with workers so a detached worker never touches a destroyed pool
+     */
+    struct State
+    {
+        eastl::deque<TTask> Tasks[k_NumPriorities];
+        size_t NumTasks = 0;
+        std::mutex Mutex;
+        std::condition_variable Condition;
+        bool IsStopping = false;
+    };
+
+    static void WorkerLoop(State& state)
+    {
+        for (;;) {
+            TTask task;
+            {
+                std::unique_lock<std::mutex> lock(state.Mutex);
+                state.Condition.wait(lock, [&state]() {
+                    return state.IsStopping || state.NumTasks > 0;
+                });
+
+                if (state.NumTasks == 0) {
+                    return;
+                }
+
+                for (size_t i = k_NumPriorities; i-- > 0;) {
+                    if (!state.Tasks[i].empty()) {
+                        task = eastl::move(state.Tasks[i].front());
+                        state.Tasks[i].pop_front();
+                        break;
+                    }
+                }
+                --state.NumTasks;
+            }
+
+            task();
+        }
+    }
+
+private:
+    eastl::shared_ptr<State> m_State;
+    eastl::vector<std::thread> m_Threads;
+};
+
+} // namespace vfspp
+
+#endif // EXECUTOR_HPP
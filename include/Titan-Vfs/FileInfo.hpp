@@ -4,6 +4,8 @@
 #include "Global.h"
 #include "StringUtils.hpp"
 
+#include <EASTL/fixed_string.h>
+
 namespace fs = std::filesystem;
 
 namespace Titan::Vfs
@@ -11,6 +13,10 @@ namespace Titan::Vfs
     
 class FileInfo final
 {
+public:
+    // Scratch space for paths normalized without heap allocation
+    typedef eastl::fixed_string<char, 256, true> TPathBuffer;
+
 public:
     FileInfo(const eastl::string& filePath)
     {
@@ -24,6 +30,8 @@ public:
 
     FileInfo(const fs::path& path, bool isDir)
         : m_Path(path)
+        , m_AbsolutePath(path.string().c_str())
+        , m_PathId(StringUtils::Hash(m_AbsolutePath))
         , m_IsDir(isDir)
     {
     }
@@ -60,11 +68,19 @@ public:
     }
     
     /*
-     * Get absolute file path
+     * Get absolute file path, computed once on construction
+     */
+    inline const eastl::string& AbsolutePath() const
+    {
+        return m_AbsolutePath;
+    }
+
+    /*
+     * Hash of absolute path, equal to StringHash of AbsolutePath() so it can be used to probe file tables
      */
-    inline eastl::string AbsolutePath() const
+    inline uint64_t PathId() const
     {
-        return m_Path.string().c_str();
+        return m_PathId;
     }
     
     /*
@@ -85,24 +101,47 @@ public:
      */
     inline bool IsValid() const
     {
-        return !m_Path.string().empty();
+        return !m_AbsolutePath.empty();
+    }
+
+    /*
+     * Normalize path the same way constructors do. Result points either to 'path' or into 'buffer'
+     */
+    static eastl::string_view Normalize(eastl::string_view path, TPathBuffer& buffer)
+    {
+#if defined(_WIN32)
+        if (path.find('\\') == eastl::string_view::npos) {
+            return path;
+        }
+
+        buffer.assign(path.data(), path.length());
+        eastl::replace(buffer.begin(), buffer.end(), '\\', '/');
+        return eastl::string_view(buffer.data(), buffer.length());
+#else
+        // Generic format of a native path is the path itself
+        return path;
+#endif
     }
 
 private:
     void Configure(const eastl::string& basePath, const eastl::string& fileName, bool isDir)
     {
         m_Path = (fs::path(basePath.c_str()) / fs::path(fileName.c_str())).generic_string();
+        m_AbsolutePath = m_Path.string().c_str();
+        m_PathId = StringUtils::Hash(m_AbsolutePath);
         m_IsDir = isDir;
     }
     
 private:
     fs::path m_Path;
+    eastl::string m_AbsolutePath;
+    uint64_t m_PathId;
     bool m_IsDir;
 };
     
 inline bool operator ==(const FileInfo& fi1, const FileInfo& fi2)
 {
-    return fi1.AbsolutePath() == fi2.AbsolutePath();
+    return fi1.PathId() == fi2.PathId() && fi1.AbsolutePath() == fi2.AbsolutePath();
 }
     
 inline bool operator <(const FileInfo& fi1, const FileInfo& fi2)
@@ -0,0 +1,304 @@
+#ifndef FILESYSTEMSTATS_HPP
+#define FILESYSTEMSTATS_HPP
+
+#include "Global.h"
+#include "LatencyHistogram.hpp"
+#include "ChromeTrace.hpp"
+#include "MemoryBudget.hpp"
+
+#include <atomic>
+#include <chrono>
+
+namespace Titan::Vfs
+{
+
+using HFileSystemStats = eastl::shared_ptr<class FileSystemStats>;
+
+/*
+ * Time spent blocked on one mutex. Uncontended acquisitions are not timed
+ */
+class LockWaitStats final
+{
+public:
+    struct Snapshot
+    {
+        uint64_t Waits = 0;
+        uint64_t WaitNanoseconds = 0;
+
+        inline void Add(const Snapshot& other)
+        {
+            Waits += other.Waits;
+            WaitNanoseconds += other.WaitNanoseconds;
+        }
+    };
+
+public:
+    LockWaitStats() = default;
+
+    LockWaitStats(const LockWaitStats&) = delete;
+    LockWaitStats& operator=(const LockWaitStats&) = delete;
+
+    inline void AddWait(uint64_t nanoseconds)
+    {
+        m_Waits.fetch_add(1, std::memory_order_relaxed);
+        m_WaitNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+    }
+
+    inline Snapshot GetSnapshot() const
+    {
+        Snapshot snapshot;
+        snapshot.Waits = m_Waits.load(std::memory_order_relaxed);
+        snapshot.WaitNanoseconds = m_WaitNanoseconds.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    inline void Reset()
+    {
+        m_Waits.store(0, std::memory_order_relaxed);
+        m_WaitNanoseconds.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> m_Waits = 0;
+    std::atomic<uint64_t> m_WaitNanoseconds = 0;
+};
+
+/*
+ * Scoped lock that tries the mutex first and only reads the clock when it has to block
+ */
+template<typename TMutex>
+class TimedLockGuard final
+{
+public:
+    TimedLockGuard(TMutex& mutex, LockWaitStats* stats)
+        : m_Mutex(mutex)
+    {
+        if (m_Mutex.try_lock()) {
+            return;
+        }
+
+        uint64_t traceStart = ChromeTrace::Start();
+        auto start = std::chrono::steady_clock::now();
+        m_Mutex.lock();
+        ChromeTrace::Emit("lock", "LockWait", traceStart);
+        if (stats) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            stats->AddWait(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+    }
+
+    ~TimedLockGuard()
+    {
+        m_Mutex.unlock();
+    }
+
+    TimedLockGuard(const TimedLockGuard&) = delete;
+    TimedLockGuard& operator=(const TimedLockGuard&) = delete;
+
+private:
+    TMutex& m_Mutex;
+};
+
+/*
+ * Counters of one filesystem or mount. Updated with relaxed atomics, so snapshot
+ * is cheap but fields are not consistent with each other while traffic is running.
+ * Shared with opened files so reads are counted after filesystem is unmounted.
+ */
+class FileSystemStats final
+{
+public:
+    struct Snapshot
+    {
+        uint64_t Opens = 0;
+        uint64_t Misses = 0;
+        uint64_t BytesRead = 0;
+        uint64_t BytesWritten = 0;
+        uint64_t BytesDecompressed = 0;
+        // Data currently held in memory by files, not cleared by Reset
+        uint64_t FileDataBytes = 0;
+        // Filesystem lock and lock of its files
+        LockWaitStats::Snapshot FileSystemLock;
+        LockWaitStats::Snapshot FileLock;
+
+        inline void Add(const Snapshot& other)
+        {
+            Opens += other.Opens;
+            Misses += other.Misses;
+            BytesRead += other.BytesRead;
+            BytesWritten += other.BytesWritten;
+            BytesDecompressed += other.BytesDecompressed;
+            FileDataBytes += other.FileDataBytes;
+            FileSystemLock.Add(other.FileSystemLock);
+            FileLock.Add(other.FileLock);
+        }
+    };
+
+public:
+    FileSystemStats() = default;
+
+    FileSystemStats(const FileSystemStats&) = delete;
+    FileSystemStats& operator=(const FileSystemStats&) = delete;
+
+    static HFileSystemStats Create()
+    {
+        return HFileSystemStats(new FileSystemStats());
+    }
+
+    inline void AddOpen()
+    {
+        m_Opens.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline void AddMiss()
+    {
+        m_Misses.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline void AddBytesRead(uint64_t size)
+    {
+        if (size > 0) {
+            m_BytesRead.fetch_add(size, std::memory_order_relaxed);
+        }
+    }
+
+    inline void AddBytesWritten(uint64_t size)
+    {
+        if (size > 0) {
+            m_BytesWritten.fetch_add(size, std::memory_order_relaxed);
+        }
+    }
+
+    inline void AddBytesDecompressed(uint64_t size)
+    {
+        if (size > 0) {
+            m_BytesDecompressed.fetch_add(size, std::memory_order_relaxed);
+        }
+    }
+
+    /*
+     * Account 'size' bytes of file data about to be allocated. Returns false if
+     * attached budget has a hard limit that refuses them
+     */
+    inline bool ReserveFileData(uint64_t size)
+    {
+        if (size == 0) {
+            return true;
+        }
+
+        if (m_HasBudget.load(std::memory_order_relaxed)) {
+            HMemoryBudget budget = GetMemoryBudget();
+            if (budget && !budget->Reserve(size)) {
+                return false;
+            }
+        }
+
+        m_FileDataBytes.fetch_add(size, std::memory_order_relaxed);
+        return true;
+    }
+
+    inline void ReleaseFileData(uint64_t size)
+    {
+        if (size == 0) {
+            return;
+        }
+
+        if (m_HasBudget.load(std::memory_order_relaxed)) {
+            if (HMemoryBudget budget = GetMemoryBudget()) {
+                budget->Release(size);
+            }
+        }
+
+        m_FileDataBytes.fetch_sub(eastl::min(size, m_FileDataBytes.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+    }
+
+    inline uint64_t FileDataBytes() const
+    {
+        return m_FileDataBytes.load(std::memory_order_relaxed);
+    }
+
+    /*
+     * Budget that file data reservations are checked against, null removes it
+     */
+    void SetMemoryBudget(HMemoryBudget budget)
+    {
+        std::lock_guard<std::mutex> lock(m_BudgetMutex);
+        m_HasBudget.store(budget != nullptr, std::memory_order_relaxed);
+        m_Budget = eastl::move(budget);
+    }
+
+    HMemoryBudget GetMemoryBudget() const
+    {
+        std::lock_guard<std::mutex> lock(m_BudgetMutex);
+        return m_Budget;
+    }
+
+    inline LockWaitStats& FileSystemLock()
+    {
+        return m_FileSystemLock;
+    }
+
+    inline LockWaitStats& FileLock()
+    {
+        return m_FileLock;
+    }
+
+    inline LatencyHistogram& Latency(LatencyOp op)
+    {
+        return m_Latency[static_cast<size_t>(op)];
+    }
+
+    /*
+     * Histograms are kept out of Snapshot, copying them is much more expensive than counters
+     */
+    LatencyHistogram::Snapshot GetLatency(LatencyOp op) const
+    {
+        return m_Latency[static_cast<size_t>(op)].GetSnapshot();
+    }
+
+    Snapshot GetSnapshot() const
+    {
+        Snapshot snapshot;
+        snapshot.Opens = m_Opens.load(std::memory_order_relaxed);
+        snapshot.Misses = m_Misses.load(std::memory_order_relaxed);
+        snapshot.BytesRead = m_BytesRead.load(std::memory_order_relaxed);
+        snapshot.BytesWritten = m_BytesWritten.load(std::memory_order_relaxed);
+        snapshot.BytesDecompressed = m_BytesDecompressed.load(std::memory_order_relaxed);
+        snapshot.FileDataBytes = m_FileDataBytes.load(std::memory_order_relaxed);
+        snapshot.FileSystemLock = m_FileSystemLock.GetSnapshot();
+        snapshot.FileLock = m_FileLock.GetSnapshot();
+        return snapshot;
+    }
+
+    void Reset()
+    {
+        m_Opens.store(0, std::memory_order_relaxed);
+        m_Misses.store(0, std::memory_order_relaxed);
+        m_BytesRead.store(0, std::memory_order_relaxed);
+        m_BytesWritten.store(0, std::memory_order_relaxed);
+        m_BytesDecompressed.store(0, std::memory_order_relaxed);
+        m_FileSystemLock.Reset();
+        m_FileLock.Reset();
+        for (LatencyHistogram& latency : m_Latency) {
+            latency.Reset();
+        }
+    }
+
+private:
+    std::atomic<uint64_t> m_Opens = 0;
+    std::atomic<uint64_t> m_Misses = 0;
+    std::atomic<uint64_t> m_BytesRead = 0;
+    std::atomic<uint64_t> m_BytesWritten = 0;
+    std::atomic<uint64_t> m_BytesDecompressed = 0;
+    LockWaitStats m_FileSystemLock;
+    LockWaitStats m_FileLock;
+    LatencyHistogram m_Latency[static_cast<size_t>(LatencyOp::Count)];
+    std::atomic<uint64_t> m_FileDataBytes = 0;
+    // Lets reservations skip budget lookup while none is attached
+    std::atomic<bool> m_HasBudget = false;
+    HMemoryBudget m_Budget;
+    mutable std::mutex m_BudgetMutex;
+};
+
+} // namespace vfspp
+
+#endif // FILESYSTEMSTATS_HPP
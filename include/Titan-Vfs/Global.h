@@ -2,6 +2,7 @@
 #define GLOBAL_H
 
 #include <mutex>
+#include <atomic>
 
 #include <EASTL/string.h>
 #include <EASTL/shared_ptr.h>
@@ -10,8 +11,10 @@
 #include <EASTL/list.h>
 
 #include <EASTL/algorithm.h>
+#include <EASTL/sort.h>
 
 #include <EASTL/unordered_map.h>
+#include <EASTL/functional.h>
 
 #include <fstream>
 #include <iostream>
@@ -24,6 +27,12 @@ namespace Titan::Vfs
 #else
     constexpr bool g_MtSupportEnabled = false;
 #endif
+
+#ifdef TITAN_VFS_ALLOC_TRACKING
+    constexpr bool g_AllocTrackingEnabled = true;
+#else
+    constexpr bool g_AllocTrackingEnabled = false;
+#endif
 }
 
 #endif // GLOBAL_H
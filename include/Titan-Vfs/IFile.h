@@ -3,12 +3,25 @@
 
 #include "Global.h"
 #include "FileInfo.hpp"
+#include "FileSystemStats.hpp"
+#include "AllocationTracker.hpp"
 
 namespace Titan::Vfs
 {
     
 using HFile = eastl::shared_ptr<class IFile>;
 
+/*
+ * Whole contents of a file held in memory. Owner keeps data alive, so view stays valid
+ * after file is closed, also when another opener of the same file closes it
+ */
+struct FileView
+{
+    const uint8_t* Data = nullptr;
+    uint64_t Size = 0;
+    eastl::shared_ptr<const void> Owner;
+};
+
 class IFile
 {
 public:
@@ -124,6 +137,15 @@ public:
      * Write data from stream to file
      */
     virtual uint64_t Write(std::istream& stream, uint64_t size, uint64_t bufferSize = 1024) = 0;
+
+    /*
+     * Get whole contents of opened file without copying, if file already holds them in memory.
+     * Returns false otherwise. View keeps data alive on its own, closing file doesn't invalidate it
+     */
+    virtual bool GetView(FileView& outView)
+    {
+        return false;
+    }
 };
     
 inline bool operator==(HFile f1, HFile f2)
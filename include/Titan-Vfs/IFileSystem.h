@@ -8,13 +8,55 @@ namespace Titan::Vfs
 
 using HFileSystem = eastl::shared_ptr<class IFileSystem>;
 
+/*
+ * One file of a batch read, data is placed into caller owned buffer
+ */
+struct BatchReadRequest
+{
+    BatchReadRequest(const FileInfo& filePath, uint8_t* buffer, uint64_t bufferSize)
+        : FilePath(filePath)
+        , Buffer(buffer)
+        , BufferSize(bufferSize)
+    {
+    }
+
+    FileInfo FilePath;
+    uint8_t* Buffer = nullptr;
+    uint64_t BufferSize = 0;
+
+    // Filled by read, file is truncated to buffer size
+    uint64_t BytesRead = 0;
+    bool IsSucceeded = false;
+};
+
 class IFileSystem
 {
 public:
-    typedef eastl::unordered_map<eastl::string, HFile> TFileList;
+    // Hashed with StringHash so FileInfo::PathId() can probe it directly
+    typedef eastl::unordered_map<eastl::string, HFile, StringHash, StringEqual> TFileList;
+
+    /*
+     * File list change events reported to listeners
+     */
+    enum class FileEvent : uint8_t
+    {
+        Created,
+        Removed,
+        // Whole file list was replaced by Initialize or Shutdown, file info is empty
+        Reset
+    };
+
+    /*
+     * Listener is invoked while filesystem is locked, it must not call back into filesystem.
+     * Reset is reported with no locks held, so listeners may read file list again
+     */
+    typedef eastl::function<void(const IFileSystem&, const FileInfo&, FileEvent)> TFileListener;
     
 public:
-    IFileSystem() = default;
+    IFileSystem()
+        : m_Stats(FileSystemStats::Create())
+    {
+    }
     ~IFileSystem() = default;
     
     /*
@@ -40,7 +82,27 @@ public:
      * Retrieve file list according filter
      */
     virtual const TFileList& FileList() const = 0;
-    
+
+    /*
+     * Visit absolute path of every file. Filesystems that create file objects lazily
+     * override it to list files without creating them
+     */
+    virtual void ForEachFile(const eastl::function<void(eastl::string_view)>& callback) const
+    {
+        for (const auto& file : FileList()) {
+            callback(eastl::string_view(file.first.data(), file.first.length()));
+        }
+    }
+
+    /*
+     * Filesystems that build file list on demand return true, merged indexes then probe
+     * them on lookup instead of copying their paths on mount
+     */
+    virtual bool IsListedLazily() const
+    {
+        return false;
+    }
+
     /*
      * Check is readonly filesystem
      */
@@ -91,8 +153,252 @@ public:
      */
     virtual bool IsDir(const FileInfo& dirPath) const = 0;
 
+    /*
+     * Get size of existing file. Filesystems override it to answer without opening the file
+     */
+    virtual bool FileSize(const FileInfo& filePath, uint64_t& outSize)
+    {
+        if (!IsFileExists(filePath)) {
+            return false;
+        }
+
+        // File object may be shared with other openers, only close it if it is opened here
+        HFile openedFile = FindFile(filePath, FileList());
+        bool wasOpened = openedFile && openedFile->IsOpened();
+
+        HFile file = OpenFile(filePath, IFile::FileMode::Read);
+        if (!file || !file->IsOpened()) {
+            return false;
+        }
+
+        outSize = file->Size();
+        if (!wasOpened) {
+            file->Close();
+        }
+        return true;
+    }
+
+    /*
+     * Lookups by absolute path. Path is normalized on stack and tables are probed
+     * with it directly, filesystems override these to avoid building FileInfo
+     */
+    virtual HFile OpenFile(eastl::string_view filePath, IFile::FileMode mode)
+    {
+        return OpenFile(FileInfo(eastl::string(filePath.data(), filePath.length())), mode);
+    }
+
+    virtual bool IsFileExists(eastl::string_view filePath) const
+    {
+        return IsFileExists(FileInfo(eastl::string(filePath.data(), filePath.length())));
+    }
+
+    virtual bool IsFile(eastl::string_view filePath) const
+    {
+        return IsFile(FileInfo(eastl::string(filePath.data(), filePath.length())));
+    }
+
+    virtual bool IsDir(eastl::string_view dirPath) const
+    {
+        return IsDir(FileInfo(eastl::string(dirPath.data(), dirPath.length())));
+    }
+
+    /*
+     * Strings convert both to FileInfo and to string_view, these pick the string_view lookups
+     * so calls with eastl::string or a literal are not ambiguous
+     */
+    HFile OpenFile(const eastl::string& filePath, IFile::FileMode mode)
+    {
+        return OpenFile(eastl::string_view(filePath.data(), filePath.length()), mode);
+    }
+
+    HFile OpenFile(const char* filePath, IFile::FileMode mode)
+    {
+        return OpenFile(eastl::string_view(filePath), mode);
+    }
+
+    bool IsFileExists(const eastl::string& filePath) const
+    {
+        return IsFileExists(eastl::string_view(filePath.data(), filePath.length()));
+    }
+
+    bool IsFileExists(const char* filePath) const
+    {
+        return IsFileExists(eastl::string_view(filePath));
+    }
+
+    bool IsFile(const eastl::string& filePath) const
+    {
+        return IsFile(eastl::string_view(filePath.data(), filePath.length()));
+    }
+
+    bool IsFile(const char* filePath) const
+    {
+        return IsFile(eastl::string_view(filePath));
+    }
+
+    bool IsDir(const eastl::string& dirPath) const
+    {
+        return IsDir(eastl::string_view(dirPath.data(), dirPath.length()));
+    }
+
+    bool IsDir(const char* dirPath) const
+    {
+        return IsDir(eastl::string_view(dirPath));
+    }
+
+    /*
+     * Read whole files into request buffers. Filesystems that know physical
+     * file placement override it to order and merge reads
+     */
+    virtual void ReadFiles(const eastl::vector<BatchReadRequest*>& requests)
+    {
+        for (BatchReadRequest* request : requests) {
+            if (!IsFileExists(request->FilePath)) {
+                continue;
+            }
+
+            // File is not handed to caller, so it is closed again unless someone else has it opened
+            HFile openedFile = FindFile(request->FilePath, FileList());
+            bool wasOpened = openedFile && openedFile->IsOpened();
+
+            HFile file = OpenFile(request->FilePath, IFile::FileMode::Read);
+            if (file && file->IsOpened()) {
+                request->BytesRead = file->Read(request->Buffer, request->BufferSize);
+                request->IsSucceeded = true;
+                if (!wasOpened) {
+                    file->Close();
+                }
+            }
+        }
+    }
+
+    /*
+     * Counters of this filesystem and files opened from it
+     */
+    FileSystemStats::Snapshot GetStats() const
+    {
+        return m_Stats->GetSnapshot();
+    }
+
+    /*
+     * Approximate heap held by file list index. Walks the whole list, not meant for every frame
+     */
+    virtual uint64_t IndexBytes() const
+    {
+        return 0;
+    }
+
+    /*
+     * Drop up to 'bytes' of data kept only for reuse, like cached entries. Called by memory budget on
+     * reserving thread, so it must not take locks held while reserving. Returns number of bytes freed
+     */
+    virtual uint64_t ReleaseMemory(uint64_t bytes)
+    {
+        return 0;
+    }
+
+    /*
+     * Check file data reservations of this filesystem and its files against 'budget', null removes limit
+     */
+    void SetMemoryBudget(HMemoryBudget budget)
+    {
+        m_Stats->SetMemoryBudget(eastl::move(budget));
+    }
+
+    HMemoryBudget GetMemoryBudget() const
+    {
+        return m_Stats->GetMemoryBudget();
+    }
+
+    /*
+     * Handed to opened files so they count their reads and lock waits, and to
+     * holders of data read from this filesystem so it is charged to its budget
+     */
+    inline const HFileSystemStats& SharedStats() const
+    {
+        return m_Stats;
+    }
+
+    /*
+     * Latency of this filesystem's opens and initialization, and of reads and seeks on its files
+     */
+    LatencyHistogram::Snapshot GetLatency(LatencyOp op) const
+    {
+        return m_Stats->GetLatency(op);
+    }
+
+    void ResetStats()
+    {
+        m_Stats->Reset();
+    }
+
+    /*
+     * Subscribe to file creation/removal, returns id to unsubscribe with
+     */
+    uint32_t AddListener(TFileListener listener)
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_ListenerMutex);
+            return AddListenerST(eastl::move(listener));
+        } else {
+            return AddListenerST(eastl::move(listener));
+        }
+    }
+
+    /*
+     * Unsubscribe listener by id returned from AddListener
+     */
+    void RemoveListener(uint32_t listenerId)
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_ListenerMutex);
+            RemoveListenerST(listenerId);
+        } else {
+            RemoveListenerST(listenerId);
+        }
+    }
+
 protected:
-    inline bool IsFile(const FileInfo& filePath, const TFileList& fileList) const
+    inline FileSystemStats& Stats() const
+    {
+        return *m_Stats;
+    }
+
+    /*
+     * Must be called by writable filesystems whenever file list is changed
+     */
+    void NotifyListeners(const FileInfo& fileInfo, FileEvent event) const
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_ListenerMutex);
+            NotifyListenersST(fileInfo, event);
+        } else {
+            NotifyListenersST(fileInfo, event);
+        }
+    }
+
+    /*
+     * Must be called by filesystems after Initialize or Shutdown changed file list, without holding own lock
+     */
+    void NotifyReset() const
+    {
+        // Listeners may call back into filesystem, so they run on a copy taken under lock
+        eastl::vector<eastl::pair<uint32_t, TFileListener>> listeners;
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_ListenerMutex);
+            listeners = m_Listeners;
+        } else {
+            listeners = m_Listeners;
+        }
+
+        FileInfo fileInfo("", "", true);
+        for (const auto& listener : listeners) {
+            listener.second(*this, fileInfo, FileEvent::Reset);
+        }
+    }
+
+    template<typename TPath>
+    inline bool IsFile(const TPath& filePath, const TFileList& fileList) const
     {
         HFile file = FindFile(filePath, fileList);
         if (file) {
@@ -101,7 +407,8 @@ protected:
         return false;
     }
     
-    inline bool IsDir(const FileInfo& dirPath, const TFileList& fileList) const
+    template<typename TPath>
+    inline bool IsDir(const TPath& dirPath, const TFileList& fileList) const
     {
         HFile file = FindFile(dirPath, fileList);
         if (file) {
@@ -110,14 +417,66 @@ protected:
         return false;
     }
 
+    /*
+     * Hash nodes, keys, file objects of 'fileObjectSize' and path copies kept by their FileInfo
+     */
+    static uint64_t EstimateIndexBytes(const TFileList& fileList, size_t fileObjectSize)
+    {
+        uint64_t bytes = fileList.bucket_count() * sizeof(void*);
+        for (const auto& it : fileList) {
+            bytes += sizeof(TFileList::node_type) + fileObjectSize + 3 * (it.first.capacity() + 1);
+        }
+        return bytes;
+    }
+
     HFile FindFile(const FileInfo& fileInfo, const TFileList& fileList) const
     {
-        auto it = fileList.find(fileInfo.AbsolutePath());
+        auto it = fileList.find_by_hash(fileInfo.AbsolutePath(), static_cast<size_t>(fileInfo.PathId()));
+        if (it == fileList.end()) {
+            return nullptr;
+        }
+        return it->second;
+    }
+
+    HFile FindFile(eastl::string_view filePath, const TFileList& fileList) const
+    {
+        FileInfo::TPathBuffer buffer;
+        eastl::string_view normalizedPath = FileInfo::Normalize(filePath, buffer);
+
+        auto it = fileList.find_as(normalizedPath, StringHash(), StringEqual());
         if (it == fileList.end()) {
             return nullptr;
         }
         return it->second;
     }
+
+private:
+    inline uint32_t AddListenerST(TFileListener listener)
+    {
+        uint32_t listenerId = m_NextListenerId++;
+        m_Listeners.push_back(eastl::make_pair(listenerId, eastl::move(listener)));
+        return listenerId;
+    }
+
+    inline void RemoveListenerST(uint32_t listenerId)
+    {
+        m_Listeners.erase(eastl::remove_if(m_Listeners.begin(), m_Listeners.end(), [listenerId](const auto& listener) {
+            return listener.first == listenerId;
+        }), m_Listeners.end());
+    }
+
+    inline void NotifyListenersST(const FileInfo& fileInfo, FileEvent event) const
+    {
+        for (const auto& listener : m_Listeners) {
+            listener.second(*this, fileInfo, event);
+        }
+    }
+
+private:
+    eastl::vector<eastl::pair<uint32_t, TFileListener>> m_Listeners;
+    uint32_t m_NextListenerId = 1;
+    mutable std::mutex m_ListenerMutex;
+    HFileSystemStats m_Stats;
 };
 
 }; // namespace vfspp
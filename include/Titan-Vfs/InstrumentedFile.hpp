@@ -0,0 +1,174 @@
+#ifndef INSTRUMENTEDFILE_HPP
+#define INSTRUMENTEDFILE_HPP
+
+#include "IFile.h"
+#include "AccessTrace.hpp"
+
+namespace Titan::Vfs
+{
+
+/*
+ * Decorator that records reads, seeks and closes of wrapped file into access trace.
+ * Wrapped file does its own locking, so decorator holds no lock
+ */
+class InstrumentedFile final : public IFile
+{
+public:
+    InstrumentedFile(HFile file, HAccessTrace trace, uint32_t fileId)
+        : m_File(eastl::move(file))
+        , m_Trace(eastl::move(trace))
+        , m_FileId(fileId)
+    {
+    }
+
+    /*
+     * Get file information
+     */
+    virtual const FileInfo& GetFileInfo() const override
+    {
+        return m_File->GetFileInfo();
+    }
+
+    /*
+     * Returns file size
+     */
+    virtual uint64_t Size() override
+    {
+        return m_File->Size();
+    }
+
+    /*
+     * Check is readonly filesystem
+     */
+    virtual bool IsReadOnly() const override
+    {
+        return m_File->IsReadOnly();
+    }
+
+    /*
+     * Open file for reading/writting
+     */
+    virtual void Open(FileMode mode) override
+    {
+        m_File->Open(mode);
+    }
+
+    /*
+     * Close file
+     */
+    virtual void Close() override
+    {
+        uint64_t start = m_Trace->Now();
+        m_File->Close();
+        m_Trace->RecordClose(m_FileId, start);
+    }
+
+    /*
+     * Check is file ready for reading/writing
+     */
+    virtual bool IsOpened() const override
+    {
+        return m_File->IsOpened();
+    }
+
+    /*
+     * Seek on a file
+     */
+    virtual uint64_t Seek(uint64_t offset, Origin origin) override
+    {
+        uint64_t start = m_Trace->Now();
+        uint64_t position = m_File->Seek(offset, origin);
+        m_Trace->RecordSeek(m_FileId, start, offset, origin, position);
+        return position;
+    }
+
+    /*
+     * Returns offset in file
+     */
+    virtual uint64_t Tell() override
+    {
+        return m_File->Tell();
+    }
+
+    /*
+     * Read data from file to buffer
+     */
+    virtual uint64_t Read(uint8_t* buffer, uint64_t size) override
+    {
+        uint64_t start = m_Trace->Now();
+        uint64_t bytesRead = m_File->Read(buffer, size);
+        m_Trace->RecordRead(m_FileId, start, size, bytesRead);
+        return bytesRead;
+    }
+
+    /*
+     * Write buffer data to file
+     */
+    virtual uint64_t Write(const uint8_t* buffer, uint64_t size) override
+    {
+        return m_File->Write(buffer, size);
+    }
+
+    /*
+     * Read data from file to vector
+     */
+    virtual uint64_t Read(eastl::vector<uint8_t>& buffer, uint64_t size) override
+    {
+        uint64_t start = m_Trace->Now();
+        uint64_t bytesRead = m_File->Read(buffer, size);
+        m_Trace->RecordRead(m_FileId, start, size, bytesRead);
+        return bytesRead;
+    }
+
+    /*
+     * Write data from vector to file
+     */
+    virtual uint64_t Write(const eastl::vector<uint8_t>& buffer) override
+    {
+        return m_File->Write(buffer);
+    }
+
+    /*
+     * Read data from file to stream
+     */
+    virtual uint64_t Read(std::ostream& stream, uint64_t size, uint64_t bufferSize = 1024) override
+    {
+        uint64_t start = m_Trace->Now();
+        uint64_t bytesRead = m_File->Read(stream, size, bufferSize);
+        m_Trace->RecordRead(m_FileId, start, size, bytesRead);
+        return bytesRead;
+    }
+
+    /*
+     * Write data from stream to file
+     */
+    virtual uint64_t Write(std::istream& stream, uint64_t size, uint64_t bufferSize = 1024) override
+    {
+        return m_File->Write(stream, size, bufferSize);
+    }
+
+    /*
+     * Get contents of wrapped file without copying
+     */
+    virtual bool GetView(FileView& outView) override
+    {
+        return m_File->GetView(outView);
+    }
+
+    /*
+     * File that is being traced
+     */
+    inline const HFile& GetWrappedFile() const
+    {
+        return m_File;
+    }
+
+private:
+    HFile m_File;
+    HAccessTrace m_Trace;
+    uint32_t m_FileId;
+};
+
+} // namespace vfspp
+
+#endif // INSTRUMENTEDFILE_HPP
@@ -0,0 +1,267 @@
+#ifndef LATENCYHISTOGRAM_HPP
+#define LATENCYHISTOGRAM_HPP
+
+#include "Global.h"
+
+#include <atomic>
+#include <chrono>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Titan::Vfs
+{
+
+/*
+ * Operations with latency histograms
+ */
+enum class LatencyOp : uint8_t
+{
+    OpenFile,
+    Read,
+    Seek,
+    Initialize,
+    Count
+};
+
+/*
+ * Log-bucketed histogram of durations in nanoseconds. Every power of two is split into
+ * 8 linear sub-buckets, so a reported value is at most 12.5% above the real one.
+ * Buckets are relaxed atomics, recording never locks
+ */
+class LatencyHistogram final
+{
+public:
+    static constexpr uint32_t k_SubBucketBits = 3;
+    static constexpr uint32_t k_SubBuckets = 1u << k_SubBucketBits;
+    // Durations above 2^47 ns (about 39 hours) land in the last bucket
+    static constexpr uint32_t k_MaxMagnitude = 47;
+    static constexpr size_t k_NumBuckets = (k_MaxMagnitude - k_SubBucketBits + 2) * k_SubBuckets;
+
+    /*
+     * Percentiles of a snapshot, in nanoseconds
+     */
+    struct Summary
+    {
+        uint64_t Count = 0;
+        uint64_t P50 = 0;
+        uint64_t P99 = 0;
+        uint64_t P999 = 0;
+        uint64_t Max = 0;
+    };
+
+    struct Snapshot
+    {
+        uint64_t Count = 0;
+        uint64_t Max = 0;
+        uint64_t Buckets[k_NumBuckets] = {};
+
+        inline void Add(const Snapshot& other)
+        {
+            Count += other.Count;
+            Max = eastl::max(Max, other.Max);
+            for (size_t i = 0; i < k_NumBuckets; ++i) {
+                Buckets[i] += other.Buckets[i];
+            }
+        }
+
+        /*
+         * Smallest recorded duration that 'percentile' (0..1) of samples don't exceed
+         */
+        inline uint64_t Percentile(double percentile) const
+        {
+            if (Count == 0) {
+                return 0;
+            }
+
+            uint64_t target = static_cast<uint64_t>(percentile * static_cast<double>(Count) + 0.999999);
+            target = eastl::clamp<uint64_t>(target, 1, Count);
+
+            uint64_t total = 0;
+            for (size_t i = 0; i < k_NumBuckets; ++i) {
+                total += Buckets[i];
+                if (total >= target) {
+                    return eastl::min(BucketUpperBound(i), Max);
+                }
+            }
+            return Max;
+        }
+
+        inline Summary Summarize() const
+        {
+            Summary summary;
+            summary.Count = Count;
+            summary.P50 = Percentile(0.5);
+            summary.P99 = Percentile(0.99);
+            summary.P999 = Percentile(0.999);
+            summary.Max = Max;
+            return summary;
+        }
+    };
+
+public:
+    LatencyHistogram() = default;
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    /*
+     * Recording is off by default. While off timers don't read the clock
+     */
+    static inline void SetRecording(bool isRecording)
+    {
+        IsRecordingFlag().store(isRecording, std::memory_order_relaxed);
+    }
+
+    static inline bool IsRecording()
+    {
+        return IsRecordingFlag().load(std::memory_order_relaxed);
+    }
+
+    /*
+     * Start of a measured operation, zero while recording is off
+     */
+    static inline uint64_t Start()
+    {
+        return IsRecording() ? Now() : 0;
+    }
+
+    static inline uint64_t Now()
+    {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        // Never zero, zero marks an unmeasured operation
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()) | 1;
+    }
+
+    inline void Record(uint64_t nanoseconds)
+    {
+        m_Buckets[BucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        m_Count.fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t max = m_Max.load(std::memory_order_relaxed);
+        while (max < nanoseconds && !m_Max.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed)) {
+        }
+    }
+
+    /*
+     * Record time passed since 'start' returned by Start(), nothing if it was not measured
+     */
+    inline void RecordSince(uint64_t start)
+    {
+        if (start != 0) {
+            uint64_t now = Now();
+            Record(now > start ? now - start : 0);
+        }
+    }
+
+    Snapshot GetSnapshot() const
+    {
+        Snapshot snapshot;
+        snapshot.Count = m_Count.load(std::memory_order_relaxed);
+        snapshot.Max = m_Max.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < k_NumBuckets; ++i) {
+            snapshot.Buckets[i] = m_Buckets[i].load(std::memory_order_relaxed);
+        }
+        return snapshot;
+    }
+
+    void Reset()
+    {
+        m_Count.store(0, std::memory_order_relaxed);
+        m_Max.store(0, std::memory_order_relaxed);
+        for (auto& bucket : m_Buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    static inline size_t BucketIndex(uint64_t value)
+    {
+        if (value < k_SubBuckets) {
+            return static_cast<size_t>(value);
+        }
+
+        uint32_t magnitude = HighestBit(value);
+        if (magnitude > k_MaxMagnitude) {
+            return k_NumBuckets - 1;
+        }
+
+        uint32_t subBucket = static_cast<uint32_t>(value >> (magnitude - k_SubBucketBits)) & (k_SubBuckets - 1);
+        return (magnitude - k_SubBucketBits + 1) * k_SubBuckets + subBucket;
+    }
+
+    static inline uint64_t BucketLowerBound(size_t index)
+    {
+        if (index < k_SubBuckets) {
+            return index;
+        }
+
+        uint32_t magnitude = static_cast<uint32_t>(index / k_SubBuckets) + k_SubBucketBits - 1;
+        uint64_t subBucket = index % k_SubBuckets;
+        return (k_SubBuckets + subBucket) << (magnitude - k_SubBucketBits);
+    }
+
+    static inline uint64_t BucketUpperBound(size_t index)
+    {
+        if (index < k_SubBuckets) {
+            return index;
+        }
+
+        uint32_t magnitude = static_cast<uint32_t>(index / k_SubBuckets) + k_SubBucketBits - 1;
+        return BucketLowerBound(index) + (1ull << (magnitude - k_SubBucketBits)) - 1;
+    }
+
+private:
+    static inline std::atomic<bool>& IsRecordingFlag()
+    {
+        static std::atomic<bool> isRecording = false;
+        return isRecording;
+    }
+
+    static inline uint32_t HighestBit(uint64_t value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index = 0;
+        _BitScanReverse64(&index, value);
+        return static_cast<uint32_t>(index);
+#else
+        return 63u - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+    }
+
+private:
+    std::atomic<uint64_t> m_Count = 0;
+    std::atomic<uint64_t> m_Max = 0;
+    std::atomic<uint64_t> m_Buckets[k_NumBuckets] = {};
+};
+
+/*
+ * Records duration of enclosing scope into histogram, costs one relaxed load while recording is off
+ */
+class LatencyTimer final
+{
+public:
+    explicit LatencyTimer(LatencyHistogram* histogram)
+        : m_Histogram(histogram)
+        , m_Start(histogram ? LatencyHistogram::Start() : 0)
+    {
+    }
+
+    ~LatencyTimer()
+    {
+        if (m_Start != 0) {
+            m_Histogram->RecordSince(m_Start);
+        }
+    }
+
+    LatencyTimer(const LatencyTimer&) = delete;
+    LatencyTimer& operator=(const LatencyTimer&) = delete;
+
+private:
+    LatencyHistogram* m_Histogram;
+    uint64_t m_Start;
+};
+
+} // namespace vfspp
+
+#endif // LATENCYHISTOGRAM_HPP
@@ -0,0 +1,107 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include "Global.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Titan::Vfs
+{
+
+#if defined(_WIN32)
+/*
+ * Win32 mapping lives in src/MappedFile.cpp, so windows.h macros never leak into users of this header
+ */
+namespace Win32Mapping
+{
+    const uint8_t* Map(const char* filePath, uint64_t maxSize, uint64_t& outSize);
+    void Unmap(const uint8_t* data);
+}
+#endif
+
+using HMappedFile = eastl::shared_ptr<class MappedFile>;
+
+/*
+ * Whole file mapped read-only into address space. Pages are read by the OS on first touch
+ * and shared with page cache, so reading mapped data needs no syscalls and no copies
+ */
+class MappedFile final
+{
+    MappedFile(const uint8_t* data, uint64_t size)
+        : m_Data(data)
+        , m_Size(size)
+    {
+    }
+public:
+    ~MappedFile()
+    {
+        if (!m_Data) {
+            return;
+        }
+#if defined(_WIN32)
+        Win32Mapping::Unmap(m_Data);
+#else
+        munmap(const_cast<uint8_t*>(m_Data), static_cast<size_t>(m_Size));
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /*
+     * Map 'filePath', returns null if file can't be opened, is empty or larger than 'maxSize'
+     */
+    static HMappedFile Open(const eastl::string& filePath, uint64_t maxSize)
+    {
+#if defined(_WIN32)
+        uint64_t size = 0;
+        const uint8_t* data = Win32Mapping::Map(filePath.c_str(), maxSize, size);
+        if (!data) {
+            return nullptr;
+        }
+        return HMappedFile(new MappedFile(data, size));
+#else
+        int file = open(filePath.c_str(), O_RDONLY);
+        if (file < 0) {
+            return nullptr;
+        }
+
+        struct stat fileStat;
+        if (fstat(file, &fileStat) != 0 || fileStat.st_size <= 0 || static_cast<uint64_t>(fileStat.st_size) > maxSize) {
+            close(file);
+            return nullptr;
+        }
+
+        // Mapping keeps file referenced, descriptor can be closed right away
+        void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        close(file);
+        if (data == MAP_FAILED) {
+            return nullptr;
+        }
+        return HMappedFile(new MappedFile(static_cast<const uint8_t*>(data), static_cast<uint64_t>(fileStat.st_size)));
+#endif
+    }
+
+    inline const uint8_t* Data() const
+    {
+        return m_Data;
+    }
+
+    inline uint64_t Size() const
+    {
+        return m_Size;
+    }
+
+private:
+    const uint8_t* m_Data;
+    uint64_t m_Size;
+};
+
+} // namespace vfspp
+
+#endif // MAPPEDFILE_HPP
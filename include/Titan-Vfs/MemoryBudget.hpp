@@ -0,0 +1,152 @@
+#ifndef MEMORYBUDGET_HPP
+#define MEMORYBUDGET_HPP
+
+#include "Global.h"
+
+#include <atomic>
+
+namespace Titan::Vfs
+{
+
+using HMemoryBudget = eastl::shared_ptr<class MemoryBudget>;
+
+/*
+ * What happens when a reservation would take budget over its limit
+ */
+enum class MemoryLimitMode : uint8_t
+{
+    // Reservation succeeds and eviction callback is asked to free the excess
+    Soft,
+    // Eviction callback is asked to free the excess first, reservation is refused if it couldn't
+    Hard
+};
+
+/*
+ * Limit of file data held by filesystems sharing this budget, usually all layers of one mount.
+ * Used bytes are relaxed atomics, so concurrent reservations may briefly overshoot a hard limit
+ */
+class MemoryBudget final
+{
+public:
+    /*
+     * Called with number of bytes over limit. Runs on reserving thread, possibly while
+     * a filesystem or file lock is held, so it must not open files
+     */
+    typedef eastl::function<void(uint64_t)> TEvictCallback;
+
+    struct Snapshot
+    {
+        uint64_t Limit = 0;
+        MemoryLimitMode Mode = MemoryLimitMode::Soft;
+        uint64_t UsedBytes = 0;
+        uint64_t Refusals = 0;
+        uint64_t Evictions = 0;
+    };
+
+public:
+    MemoryBudget(uint64_t limit, MemoryLimitMode mode)
+        : m_Limit(limit)
+        , m_Mode(mode)
+    {
+    }
+
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    static HMemoryBudget Create(uint64_t limit, MemoryLimitMode mode)
+    {
+        return HMemoryBudget(new MemoryBudget(limit, mode));
+    }
+
+    /*
+     * Account 'size' new bytes. Returns false if hard limit refused them
+     */
+    bool Reserve(uint64_t size)
+    {
+        uint64_t used = m_UsedBytes.fetch_add(size, std::memory_order_relaxed) + size;
+        if (used <= m_Limit) {
+            return true;
+        }
+
+        m_Evictions.fetch_add(1, std::memory_order_relaxed);
+        Evict(used - m_Limit);
+
+        // Evicted data is released into budget right away, 'size' is still counted in used bytes
+        if (m_Mode == MemoryLimitMode::Hard && m_UsedBytes.load(std::memory_order_relaxed) > m_Limit) {
+            Release(size);
+            m_Refusals.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    void Release(uint64_t size)
+    {
+        // Bytes reserved before budget was attached are released into it too, never go below zero
+        uint64_t used = m_UsedBytes.load(std::memory_order_relaxed);
+        while (!m_UsedBytes.compare_exchange_weak(used, used - eastl::min(used, size), std::memory_order_relaxed)) {
+        }
+    }
+
+    /*
+     * Start from bytes already held by filesystems budget is attached to
+     */
+    void SetUsedBytes(uint64_t size)
+    {
+        m_UsedBytes.store(size, std::memory_order_relaxed);
+    }
+
+    void SetEvictCallback(TEvictCallback callback)
+    {
+        std::lock_guard<std::mutex> lock(m_CallbackMutex);
+        m_EvictCallback = eastl::move(callback);
+    }
+
+    inline uint64_t Limit() const
+    {
+        return m_Limit;
+    }
+
+    inline MemoryLimitMode Mode() const
+    {
+        return m_Mode;
+    }
+
+    Snapshot GetSnapshot() const
+    {
+        Snapshot snapshot;
+        snapshot.Limit = m_Limit;
+        snapshot.Mode = m_Mode;
+        snapshot.UsedBytes = m_UsedBytes.load(std::memory_order_relaxed);
+        snapshot.Refusals = m_Refusals.load(std::memory_order_relaxed);
+        snapshot.Evictions = m_Evictions.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+private:
+    inline void Evict(uint64_t excess)
+    {
+        TEvictCallback callback;
+        {
+            std::lock_guard<std::mutex> lock(m_CallbackMutex);
+            callback = m_EvictCallback;
+        }
+
+        if (callback) {
+            callback(excess);
+        }
+    }
+
+private:
+    const uint64_t m_Limit;
+    const MemoryLimitMode m_Mode;
+    std::atomic<uint64_t> m_UsedBytes = 0;
+    std::atomic<uint64_t> m_Refusals = 0;
+    std::atomic<uint64_t> m_Evictions = 0;
+    TEvictCallback m_EvictCallback;
+    std::mutex m_CallbackMutex;
+};
+
+} // namespace vfspp
+
+#endif // MEMORYBUDGET_HPP
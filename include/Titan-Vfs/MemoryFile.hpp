@@ -13,17 +13,21 @@ class MemoryFile final : public IFile
 {
     friend class MemoryFileSystem;
 public:
-    MemoryFile(const FileInfo& fileInfo)
+    MemoryFile(const FileInfo& fileInfo, const HFileSystemStats& stats = nullptr)
         : m_FileInfo(fileInfo)
         , m_IsReadOnly(true)
         , m_IsOpened(false)
         , m_Mode(FileMode::Read)
+        , m_Stats(stats)
     {
     }   
 
     ~MemoryFile()
     {
         Close();
+        if (m_Stats) {
+            m_Stats->ReleaseFileData(m_Data.size());
+        }
     }
     
     /*
@@ -32,7 +36,7 @@ public:
     virtual const FileInfo& GetFileInfo() const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return GetFileInfoST();
         } else {
             return GetFileInfoST();
@@ -45,7 +49,7 @@ public:
     virtual uint64_t Size() override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return SizeST();
         } else {
             return SizeST();
@@ -58,7 +62,7 @@ public:
     virtual bool IsReadOnly() const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return IsReadOnlyST();
         } else {
             return IsReadOnlyST();
@@ -71,7 +75,7 @@ public:
     virtual void Open(FileMode mode) override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             OpenST(mode);
         } else {
             OpenST(mode);
@@ -84,7 +88,7 @@ public:
     virtual void Close() override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             CloseST();
         } else {
             CloseST();
@@ -97,7 +101,7 @@ public:
     virtual bool IsOpened() const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return IsOpenedST();
         } else {
             return IsOpenedST();
@@ -109,8 +113,9 @@ public:
      */
     virtual uint64_t Seek(uint64_t offset, Origin origin) override
     {
+        LatencyTimer latencyTimer(Latency(LatencyOp::Seek));
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return SeekST(offset, origin);
         } else {
             return SeekST(offset, origin);
@@ -122,7 +127,7 @@ public:
     virtual uint64_t Tell() override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return TellST();
         } else {
             return TellST();
@@ -134,8 +139,10 @@ public:
      */
     virtual uint64_t Read(uint8_t* buffer, uint64_t size) override
     {
+        LatencyTimer latencyTimer(Latency(LatencyOp::Read));
+        AllocationScope allocationScope(AllocOp::Read);
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return ReadST(buffer, size);
         } else {
             return ReadST(buffer, size);
@@ -146,8 +153,9 @@ public:
      */
     virtual uint64_t Write(const uint8_t* buffer, uint64_t size) override
     {
+        AllocationScope allocationScope(AllocOp::Write);
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return WriteST(buffer, size);
         } else {
             return WriteST(buffer, size);
@@ -159,8 +167,9 @@ public:
      */
     virtual uint64_t Read(eastl::vector<uint8_t>& buffer, uint64_t size) override
     {
+        LatencyTimer latencyTimer(Latency(LatencyOp::Read));
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return ReadST(buffer, size);
         } else {
             return ReadST(buffer, size);
@@ -173,7 +182,7 @@ public:
     virtual uint64_t Write(const eastl::vector<uint8_t>& buffer) override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return WriteST(buffer);
         } else {
             return WriteST(buffer);
@@ -185,8 +194,9 @@ public:
      */
     virtual uint64_t Read(std::ostream& stream, uint64_t size, uint64_t bufferSize = 1024) override
     {
+        LatencyTimer latencyTimer(Latency(LatencyOp::Read));
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return ReadST(stream, size, bufferSize);
         } else {
             return ReadST(stream, size, bufferSize);
@@ -199,7 +209,7 @@ public:
     virtual uint64_t Write(std::istream& stream, uint64_t size, uint64_t bufferSize = 1024) override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return WriteST(stream, size, bufferSize);
         } else {
             return WriteST(stream, size, bufferSize);
@@ -207,6 +217,16 @@ public:
     }
 
 private:
+    inline LockWaitStats* LockStats() const
+    {
+        return m_Stats ? &m_Stats->FileLock() : nullptr;
+    }
+
+    inline LatencyHistogram* Latency(LatencyOp op) const
+    {
+        return m_Stats ? &m_Stats->Latency(op) : nullptr;
+    }
+
     inline const FileInfo& GetFileInfoST() const
     {
         return m_FileInfo;
@@ -245,6 +265,9 @@ private:
             m_SeekPos = SizeST() > 0 ? SizeST() - 1 : 0;
         }
         if ((mode & FileMode::Truncate) == FileMode::Truncate) {
+            if (m_Stats) {
+                m_Stats->ReleaseFileData(m_Data.size());
+            }
             m_Data.clear();
         }
         
@@ -273,11 +296,11 @@ private:
         if (origin == Origin::Begin) {
             m_SeekPos = offset;
         } else if (origin == Origin::End) {
-            m_SeekPos = Size() - offset;
+            m_SeekPos = SizeST() - offset;
         } else if (origin == Origin::Set) {
             m_SeekPos += offset;
         }
-        m_SeekPos = std::min(m_SeekPos, Size() - 1);
+        m_SeekPos = std::min(m_SeekPos, SizeST() - 1);
 
         return TellST();
     }
@@ -302,6 +325,9 @@ private:
         uint64_t maxSize = std::min(size, leftSize);
         if (maxSize > 0) {
             memcpy(buffer, m_Data.data(), static_cast<size_t>(maxSize));
+            if (m_Stats) {
+                m_Stats->AddBytesRead(maxSize);
+            }
             return maxSize;
         }
 
@@ -321,9 +347,20 @@ private:
         
         uint64_t leftSize = SizeST() - TellST();
         if (size > leftSize) {
-            m_Data.resize((size_t)(m_Data.size() + (size - leftSize)));
+            // Over a hard memory limit only the part that fits into existing data is written
+            if (m_Stats && !m_Stats->ReserveFileData(size - leftSize)) {
+                size = leftSize;
+            } else {
+                m_Data.resize((size_t)(m_Data.size() + (size - leftSize)));
+            }
+        }
+        if (size == 0) {
+            return 0;
         }
         memcpy(m_Data.data() + TellST(), buffer, static_cast<size_t>(size));
+        if (m_Stats) {
+            m_Stats->AddBytesWritten(size);
+        }
         
         return size;
     }
@@ -393,6 +430,7 @@ private:
     bool m_IsOpened;
     uint64_t m_SeekPos;
     FileMode m_Mode;
+    HFileSystemStats m_Stats;
     mutable std::mutex m_Mutex;
 };
     
@@ -21,6 +21,12 @@ class MemoryFileSystem final : public IFileSystem
     {
     }
 public:
+    // Overrides below would hide string lookups of IFileSystem
+    using IFileSystem::OpenFile;
+    using IFileSystem::IsFileExists;
+    using IFileSystem::IsFile;
+    using IFileSystem::IsDir;
+
     ~MemoryFileSystem()
     {
         Shutdown();
@@ -36,9 +42,11 @@ public:
      */
     virtual void Initialize() override
     {
+        LatencyTimer latencyTimer(&Stats().Latency(LatencyOp::Initialize));
+        TraceScope traceScope("memory", "Initialize");
         if constexpr (g_MtSupportEnabled)
         {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             InitializeST();
         }
         else
@@ -52,14 +60,19 @@ public:
      */
     virtual void Shutdown() override
     {
+        bool isReset = false;
         if constexpr (g_MtSupportEnabled)
         {
-            std::lock_guard<std::mutex> lock(m_Mutex);
-            ShutdownST();
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            isReset = ShutdownST();
         }
         else
         {
-            ShutdownST();
+            isReset = ShutdownST();
+        }
+        if (isReset)
+        {
+            NotifyReset();
         }
     }
     
@@ -70,7 +83,7 @@ public:
     {
         if constexpr (g_MtSupportEnabled)
         {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return IsInitializedST();
         }
         else
@@ -85,7 +98,7 @@ public:
     virtual const eastl::string& BasePath() const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return BasePathST();
         } else {
             return BasePathST();
@@ -98,12 +111,25 @@ public:
     virtual const TFileList& FileList() const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return FileListST();
         } else {
             return FileListST();
         }
     }
+
+    /*
+     * Visit absolute path of every file. Callback is invoked while filesystem is locked, it must not call back into filesystem
+     */
+    virtual void ForEachFile(const eastl::function<void(eastl::string_view)>& callback) const override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            ForEachFileST(callback);
+        } else {
+            ForEachFileST(callback);
+        }
+    }
     
     /*
      * Check is readonly filesystem
@@ -111,7 +137,7 @@ public:
     virtual bool IsReadOnly() const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return IsReadOnlyST();
         } else {
             return IsReadOnlyST();
@@ -124,8 +150,10 @@ public:
      */
     virtual HFile OpenFile(const FileInfo& filePath, IFile::FileMode mode) override
     {
+        LatencyTimer latencyTimer(&Stats().Latency(LatencyOp::OpenFile));
+        TraceScope traceScope("memory", "OpenFile", filePath.AbsolutePath());
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return OpenFileST(filePath, mode);
         } else {
             return OpenFileST(filePath, mode);
@@ -138,7 +166,7 @@ public:
     virtual void CloseFile(HFile file) override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             CloseFileST(file);
         } else {
             CloseFileST(file);
@@ -151,7 +179,7 @@ public:
     virtual bool CreateFile(const FileInfo& filePath) override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return CreateFileST(filePath);
         } else {
             return CreateFileST(filePath);
@@ -164,7 +192,7 @@ public:
     virtual bool RemoveFile(const FileInfo& filePath) override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return RemoveFileST(filePath);
         } else {
             return RemoveFileST(filePath);
@@ -177,7 +205,7 @@ public:
     virtual bool CopyFile(const FileInfo& src, const FileInfo& dest) override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return CopyFileST(src, dest);
         } else {
             return CopyFileST(src, dest);
@@ -190,7 +218,7 @@ public:
     virtual bool RenameFile(const FileInfo& srcPath, const FileInfo& dstPath) override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return RenameFileST(srcPath, dstPath);
         } else {
             return RenameFileST(srcPath, dstPath);
@@ -203,7 +231,7 @@ public:
     virtual bool IsFileExists(const FileInfo& filePath) const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return IsFileExistsST(filePath);
         } else {
             return IsFileExistsST(filePath);
@@ -216,7 +244,7 @@ public:
     virtual bool IsFile(const FileInfo& filePath) const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return IFileSystem::IsFile(filePath, m_FileList);
         } else {
             return IFileSystem::IsFile(filePath, m_FileList);
@@ -229,13 +257,106 @@ public:
     virtual bool IsDir(const FileInfo& dirPath) const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return IFileSystem::IsDir(dirPath, m_FileList);
+        } else {
+            return IFileSystem::IsDir(dirPath, m_FileList);
+        }
+    }
+
+    /*
+     * Get size of existing file without opening it
+     */
+    virtual bool FileSize(const FileInfo& filePath, uint64_t& outSize) override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return FileSizeST(filePath, outSize);
+        } else {
+            return FileSizeST(filePath, outSize);
+        }
+    }
+
+    /*
+     * Open file by absolute path, existing files are found without building FileInfo
+     */
+    virtual HFile OpenFile(eastl::string_view filePath, IFile::FileMode mode) override
+    {
+        LatencyTimer latencyTimer(&Stats().Latency(LatencyOp::OpenFile));
+        TraceScope traceScope("memory", "OpenFile", filePath);
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return OpenFileST(filePath, mode);
+        } else {
+            return OpenFileST(filePath, mode);
+        }
+    }
+
+    /*
+     * Check if file exists on filesystem by absolute path
+     */
+    virtual bool IsFileExists(eastl::string_view filePath) const override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return FindFile(filePath, m_FileList) != nullptr;
+        } else {
+            return FindFile(filePath, m_FileList) != nullptr;
+        }
+    }
+
+    /*
+     * Check is file by absolute path
+     */
+    virtual bool IsFile(eastl::string_view filePath) const override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return IFileSystem::IsFile(filePath, m_FileList);
+        } else {
+            return IFileSystem::IsFile(filePath, m_FileList);
+        }
+    }
+
+    /*
+     * Check is dir by absolute path
+     */
+    virtual bool IsDir(eastl::string_view dirPath) const override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return IFileSystem::IsDir(dirPath, m_FileList);
         } else {
             return IFileSystem::IsDir(dirPath, m_FileList);
         }
     }
 
+    /*
+     * Copy files straight from memory without touching their open state
+     */
+    virtual void ReadFiles(const eastl::vector<BatchReadRequest*>& requests) override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            ReadFilesST(requests);
+        } else {
+            ReadFilesST(requests);
+        }
+    }
+
+    /*
+     * Approximate heap held by file list
+     */
+    virtual uint64_t IndexBytes() const override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return EstimateIndexBytes(m_FileList, sizeof(MemoryFile));
+        } else {
+            return EstimateIndexBytes(m_FileList, sizeof(MemoryFile));
+        }
+    }
+
 private:
     inline void InitializeST()
     {
@@ -245,14 +366,16 @@ private:
         m_IsInitialized = true;
     }
 
-    inline void ShutdownST()
+    inline bool ShutdownST()
     {
+        bool isReset = !m_FileList.empty();
         // close all files
         for (auto& file : m_FileList) {
             file.second->Close();
         }
         m_FileList.clear();
         m_IsInitialized = false;
+        return isReset;
     }
 
     inline bool IsInitializedST() const
@@ -271,6 +394,13 @@ private:
         return m_FileList;
     }
 
+    inline void ForEachFileST(const eastl::function<void(eastl::string_view)>& callback) const
+    {
+        for (const auto& file : m_FileList) {
+            callback(eastl::string_view(file.first.data(), file.first.length()));
+        }
+    }
+
     inline bool IsReadOnlyST() const
     {
         return false;
@@ -281,7 +411,7 @@ private:
         HFile file = FindFile(filePath, m_FileList);
         bool isExists = (file != nullptr);
         if (!isExists && !IsReadOnlyST()) {
-            file.reset(new MemoryFile(filePath));
+            file.reset(new MemoryFile(filePath, SharedStats()));
         }
 
         if (file) {
@@ -289,12 +419,48 @@ private:
             
             if (!isExists && file->IsOpened()) {
                 m_FileList[filePath.AbsolutePath()] = file;
+                NotifyListeners(filePath, FileEvent::Created);
             }
         }
+
+        if (file && file->IsOpened()) {
+            Stats().AddOpen();
+        } else {
+            Stats().AddMiss();
+        }
         
         return file;
     }
 
+    inline void ReadFilesST(const eastl::vector<BatchReadRequest*>& requests)
+    {
+        for (BatchReadRequest* request : requests) {
+            HFile file = FindFile(request->FilePath, m_FileList);
+            if (!file) {
+                Stats().AddMiss();
+                continue;
+            }
+
+            MemoryFile& memoryFile = static_cast<MemoryFile&>(*file);
+            auto copy = [&]() {
+                uint64_t size = eastl::min(request->BufferSize, static_cast<uint64_t>(memoryFile.m_Data.size()));
+                if (size > 0) {
+                    memcpy(request->Buffer, memoryFile.m_Data.data(), static_cast<size_t>(size));
+                }
+                request->BytesRead = size;
+                request->IsSucceeded = true;
+                Stats().AddBytesRead(size);
+            };
+
+            if constexpr (g_MtSupportEnabled) {
+                TimedLockGuard<std::mutex> lock(memoryFile.m_Mutex, &Stats().FileLock());
+                copy();
+            } else {
+                copy();
+            }
+        }
+    }
+
     inline void CloseFileST(HFile file)
     {
         if (!file) {
@@ -302,7 +468,9 @@ private:
         }
 
         file->Close();
-        m_FileList.erase(file->GetFileInfo().AbsolutePath());
+        if (m_FileList.erase(file->GetFileInfo().AbsolutePath()) > 0) {
+            NotifyListeners(file->GetFileInfo(), FileEvent::Removed);
+        }
     }
 
     inline bool CreateFileST(const FileInfo& filePath)
@@ -319,6 +487,9 @@ private:
     inline bool RemoveFileST(const FileInfo& filePath)
     {
         auto numRemoved = m_FileList.erase(filePath.AbsolutePath());
+        if (numRemoved > 0) {
+            NotifyListeners(filePath, FileEvent::Removed);
+        }
         return numRemoved > 0;
     }
 
@@ -335,14 +506,18 @@ private:
                 srcFile->Open(IFile::FileMode::Read);
             }
 
-            dstFile->m_Data.assign(srcFile->m_Data.begin(), srcFile->m_Data.end());
+            // Destination was truncated, so all of its data is new
+            bool isReserved = Stats().ReserveFileData(srcFile->m_Data.size());
+            if (isReserved) {
+                dstFile->m_Data.assign(srcFile->m_Data.begin(), srcFile->m_Data.end());
+            }
             dstFile->Close();
 
             if (needClose) {
                 srcFile->Close();
             }
 
-            return true;
+            return isReserved;
         }
 
         return false;
@@ -358,6 +533,34 @@ private:
         return result;
     }
 
+    inline HFile OpenFileST(eastl::string_view filePath, IFile::FileMode mode)
+    {
+        HFile file = FindFile(filePath, m_FileList);
+        if (file) {
+            return OpenFileST(file->GetFileInfo(), mode);
+        }
+
+        // New file needs its FileInfo anyway
+        return OpenFileST(FileInfo(eastl::string(filePath.data(), filePath.length())), mode);
+    }
+
+    inline bool FileSizeST(const FileInfo& filePath, uint64_t& outSize) const
+    {
+        HFile file = FindFile(filePath, m_FileList);
+        if (!file) {
+            return false;
+        }
+
+        MemoryFile& memoryFile = static_cast<MemoryFile&>(*file);
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(memoryFile.m_Mutex, &Stats().FileLock());
+            outSize = memoryFile.m_Data.size();
+        } else {
+            outSize = memoryFile.m_Data.size();
+        }
+        return true;
+    }
+
     inline bool IsFileExistsST(const FileInfo& filePath) const
     {
         return FindFile(filePath, m_FileList) != nullptr;
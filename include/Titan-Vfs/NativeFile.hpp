@@ -11,18 +11,20 @@ using HNativeFile = std::shared_ptr<class NativeFile>;
 class NativeFile final : public IFile
 {
 public:
-    NativeFile(const FileInfo& fileInfo)
+    NativeFile(const FileInfo& fileInfo, const HFileSystemStats& stats = nullptr)
         : m_FileInfo(fileInfo)
         , m_IsReadOnly(true)
         , m_Mode(FileMode::Read)
+        , m_Stats(stats)
     {
     }
     
-    NativeFile(const FileInfo& fileInfo, std::fstream&& stream)
+    NativeFile(const FileInfo& fileInfo, std::fstream&& stream, const HFileSystemStats& stats = nullptr)
         : m_FileInfo(fileInfo)
         , m_Stream(eastl::move(stream))
         , m_IsReadOnly(true)
         , m_Mode(FileMode::Read)
+        , m_Stats(stats)
     {
     }
 
@@ -37,7 +39,7 @@ public:
     virtual const FileInfo& GetFileInfo() const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return GetFileInfoST();
         } else {
             return GetFileInfoST();
@@ -51,7 +53,7 @@ public:
     {
         if constexpr (g_MtSupportEnabled)
         {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return SizeST();
         } else {
             return SizeST();
@@ -65,7 +67,7 @@ public:
     {
         if constexpr (g_MtSupportEnabled)
         {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return IsReadOnlyST();
         }
         else
@@ -80,7 +82,7 @@ public:
     virtual void Open(FileMode mode) override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             OpenST(mode);
         } else {
             OpenST(mode);
@@ -93,7 +95,7 @@ public:
     virtual void Close() override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             CloseST();
         } else {
             CloseST();
@@ -106,7 +108,7 @@ public:
     virtual bool IsOpened() const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return IsOpenedST();
         } else {
             return IsOpenedST();
@@ -118,8 +120,9 @@ public:
      */
     virtual uint64_t Seek(uint64_t offset, Origin origin) override
     {
+        LatencyTimer latencyTimer(Latency(LatencyOp::Seek));
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return SeekST(offset, origin);
         } else {
             return SeekST(offset, origin);
@@ -131,7 +134,7 @@ public:
     virtual uint64_t Tell() override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return TellST();
         } else {
             return TellST();
@@ -143,8 +146,10 @@ public:
      */
     virtual uint64_t Read(uint8_t* buffer, uint64_t size) override
     {
+        LatencyTimer latencyTimer(Latency(LatencyOp::Read));
+        AllocationScope allocationScope(AllocOp::Read);
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return ReadST(buffer, size);
         } else {
             return ReadST(buffer, size);
@@ -155,8 +160,9 @@ public:
      */
     virtual uint64_t Write(const uint8_t* buffer, uint64_t size) override
     {
+        AllocationScope allocationScope(AllocOp::Write);
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return WriteST(buffer, size);
         } else {
             return WriteST(buffer, size);
@@ -168,8 +174,9 @@ public:
      */
     virtual uint64_t Read(eastl::vector<uint8_t>& buffer, uint64_t size) override
     {
+        LatencyTimer latencyTimer(Latency(LatencyOp::Read));
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return ReadST(buffer, size);
         } else {
             return ReadST(buffer, size);
@@ -182,7 +189,7 @@ public:
     virtual uint64_t Write(const eastl::vector<uint8_t>& buffer) override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return WriteST(buffer);
         } else {
             return WriteST(buffer);
@@ -194,8 +201,9 @@ public:
      */
     virtual uint64_t Read(std::ostream& stream, uint64_t size, uint64_t bufferSize = 1024) override
     {
+        LatencyTimer latencyTimer(Latency(LatencyOp::Read));
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return ReadST(stream, size, bufferSize);
         } else {
             return ReadST(stream, size, bufferSize);
@@ -208,7 +216,7 @@ public:
     virtual uint64_t Write(std::istream& stream, uint64_t size, uint64_t bufferSize = 1024) override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return WriteST(stream, size, bufferSize);
         } else {
             return WriteST(stream, size, bufferSize);
@@ -216,6 +224,16 @@ public:
     }
 
 private:
+    inline LockWaitStats* LockStats() const
+    {
+        return m_Stats ? &m_Stats->FileLock() : nullptr;
+    }
+
+    inline LatencyHistogram* Latency(LatencyOp op) const
+    {
+        return m_Stats ? &m_Stats->Latency(op) : nullptr;
+    }
+
     inline const FileInfo& GetFileInfoST() const
     {
         return m_FileInfo;
@@ -321,7 +339,11 @@ private:
         uint64_t leftSize = SizeST() - TellST();
         uint64_t maxSize = std::min(size, leftSize);
         if (maxSize > 0) {
+            TraceScope traceScope("native", "Read", GetFileInfoST().AbsolutePath());
             m_Stream.read(reinterpret_cast<char*>(buffer), maxSize);
+            if (m_Stats) {
+                m_Stats->AddBytesRead(maxSize);
+            }
             return maxSize;
         }
 
@@ -340,7 +362,12 @@ private:
         }
         
         m_Stream.write(reinterpret_cast<const char*>(buffer), size);
-        return static_cast<uint64_t>(m_Stream.gcount());
+        // Stream write is all or nothing, gcount() only counts reads
+        uint64_t bytesWritten = m_Stream.good() ? size : 0;
+        if (m_Stats) {
+            m_Stats->AddBytesWritten(bytesWritten);
+        }
+        return bytesWritten;
     }
 
     inline uint64_t ReadST(eastl::vector<uint8_t>& buffer, uint64_t size)
@@ -406,6 +433,7 @@ private:
     std::fstream m_Stream;
     bool m_IsReadOnly;
     FileMode m_Mode;
+    HFileSystemStats m_Stats;
     mutable std::mutex m_Mutex;
 };
     
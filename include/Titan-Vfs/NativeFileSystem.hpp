@@ -6,6 +6,10 @@
 #include "StringUtils.hpp"
 #include "NativeFile.hpp"
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#endif
+
 namespace fs = std::filesystem;
 
 namespace Titan::Vfs
@@ -18,9 +22,16 @@ class NativeFileSystem final : public IFileSystem
     NativeFileSystem(const eastl::string& basePath)
        : m_BasePath(basePath)
        , m_IsInitialized(false)
+       , m_IsReadOnly(true)
     {
     }
 public:
+    // Overrides below would hide string lookups of IFileSystem
+    using IFileSystem::OpenFile;
+    using IFileSystem::IsFileExists;
+    using IFileSystem::IsFile;
+    using IFileSystem::IsDir;
+
     ~NativeFileSystem()
     {
         Shutdown();
@@ -36,11 +47,17 @@ public:
      */
     virtual void Initialize() override
     {
+        LatencyTimer latencyTimer(&Stats().Latency(LatencyOp::Initialize));
+        TraceScope traceScope("native", "Initialize");
+        bool isReset = false;
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
-            InitializeST();
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            isReset = InitializeST();
         } else {
-            InitializeST();
+            isReset = InitializeST();
+        }
+        if (isReset) {
+            NotifyReset();
         }
     }
 
@@ -49,11 +66,15 @@ public:
      */
     virtual void Shutdown() override
     {
+        bool isReset = false;
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
-            ShutdownST();
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            isReset = ShutdownST();
         } else {
-            ShutdownST();
+            isReset = ShutdownST();
+        }
+        if (isReset) {
+            NotifyReset();
         }
     }
     
@@ -63,7 +84,7 @@ public:
     virtual bool IsInitialized() const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return IsInitializedST();
         } else {
             return IsInitializedST();
@@ -76,7 +97,7 @@ public:
     virtual const eastl::string& BasePath() const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return BasePathST();
         } else {
             return BasePathST();
@@ -89,12 +110,25 @@ public:
     virtual const TFileList& FileList() const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return FileListST();
         } else {
             return FileListST();
         }
     }
+
+    /*
+     * Visit absolute path of every file. Callback is invoked while filesystem is locked, it must not call back into filesystem
+     */
+    virtual void ForEachFile(const eastl::function<void(eastl::string_view)>& callback) const override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            ForEachFileST(callback);
+        } else {
+            ForEachFileST(callback);
+        }
+    }
     
     /*
      * Check is readonly filesystem
@@ -102,7 +136,7 @@ public:
     virtual bool IsReadOnly() const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return IsReadOnlyST();
         } else {
             return IsReadOnlyST();
@@ -115,8 +149,10 @@ public:
      */
     virtual HFile OpenFile(const FileInfo& filePath, IFile::FileMode mode) override
     {
+        LatencyTimer latencyTimer(&Stats().Latency(LatencyOp::OpenFile));
+        TraceScope traceScope("native", "OpenFile", filePath.AbsolutePath());
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return OpenFileST(filePath, mode);
         } else {
             return OpenFileST(filePath, mode);
@@ -129,7 +165,7 @@ public:
     virtual void CloseFile(HFile file) override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             CloseFileST(file);
         } else {
             CloseFileST(file);
@@ -142,7 +178,7 @@ public:
     virtual bool CreateFile(const FileInfo& filePath) override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return CreateFileST(filePath);
         } else {
             return CreateFileST(filePath);
@@ -155,7 +191,7 @@ public:
     virtual bool RemoveFile(const FileInfo& filePath) override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return RemoveFileST(filePath);
         } else {
             return RemoveFileST(filePath);
@@ -168,7 +204,7 @@ public:
     virtual bool CopyFile(const FileInfo& src, const FileInfo& dest) override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return CopyFileST(src, dest);
         } else {
             return CopyFileST(src, dest);
@@ -181,7 +217,7 @@ public:
     virtual bool RenameFile(const FileInfo& srcPath, const FileInfo& dstPath) override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return RenameFileST(srcPath, dstPath);
         } else {
             return RenameFileST(srcPath, dstPath);
@@ -194,7 +230,7 @@ public:
     virtual bool IsFileExists(const FileInfo& filePath) const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return IsFileExistsST(filePath);
         } else {
             return IsFileExistsST(filePath);
@@ -207,7 +243,7 @@ public:
     virtual bool IsFile(const FileInfo& filePath) const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return IFileSystem::IsFile(filePath, m_FileList);
         } else {
             return IFileSystem::IsFile(filePath, m_FileList);
@@ -220,30 +256,157 @@ public:
     virtual bool IsDir(const FileInfo& dirPath) const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return IFileSystem::IsDir(dirPath, m_FileList);
         } else {
             return IFileSystem::IsDir(dirPath, m_FileList);
         }
     }
 
+    /*
+     * Get size of existing file without opening it
+     */
+    virtual bool FileSize(const FileInfo& filePath, uint64_t& outSize) override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return FileSizeST(filePath, outSize);
+        } else {
+            return FileSizeST(filePath, outSize);
+        }
+    }
+
+    /*
+     * Open file by absolute path, existing files are found without building FileInfo
+     */
+    virtual HFile OpenFile(eastl::string_view filePath, IFile::FileMode mode) override
+    {
+        LatencyTimer latencyTimer(&Stats().Latency(LatencyOp::OpenFile));
+        TraceScope traceScope("native", "OpenFile", filePath);
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return OpenFileST(filePath, mode);
+        } else {
+            return OpenFileST(filePath, mode);
+        }
+    }
+
+    /*
+     * Check if file exists on filesystem by absolute path
+     */
+    virtual bool IsFileExists(eastl::string_view filePath) const override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return FindFile(filePath, m_FileList) != nullptr;
+        } else {
+            return FindFile(filePath, m_FileList) != nullptr;
+        }
+    }
+
+    /*
+     * Check is file by absolute path
+     */
+    virtual bool IsFile(eastl::string_view filePath) const override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return IFileSystem::IsFile(filePath, m_FileList);
+        } else {
+            return IFileSystem::IsFile(filePath, m_FileList);
+        }
+    }
+
+    /*
+     * Check is dir by absolute path
+     */
+    virtual bool IsDir(eastl::string_view dirPath) const override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return IFileSystem::IsDir(dirPath, m_FileList);
+        } else {
+            return IFileSystem::IsDir(dirPath, m_FileList);
+        }
+    }
+
+    /*
+     * Read files in inode order, which follows their placement on disk for most
+     * filesystems. Files are read through own streams so opened handles are not disturbed
+     */
+    virtual void ReadFiles(const eastl::vector<BatchReadRequest*>& requests) override
+    {
+        eastl::vector<PendingRead> pendingReads;
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            CollectReadsST(requests, pendingReads);
+        } else {
+            CollectReadsST(requests, pendingReads);
+        }
+
+        // Disk is accessed without holding filesystem lock
+        eastl::sort(pendingReads.begin(), pendingReads.end(), [](const PendingRead& a, const PendingRead& b) {
+            if (a.Device != b.Device) {
+                return a.Device < b.Device;
+            }
+            if (a.Inode != b.Inode) {
+                return a.Inode < b.Inode;
+            }
+            return a.Path < b.Path;
+        });
+
+        for (const PendingRead& pendingRead : pendingReads) {
+            BatchReadRequest* request = pendingRead.Request;
+            TraceScope traceScope("native", "Read", pendingRead.Path);
+            std::ifstream stream(pendingRead.Path.c_str(), std::ios_base::binary);
+            if (!stream.is_open()) {
+                Stats().AddMiss();
+                continue;
+            }
+
+            stream.read(reinterpret_cast<char*>(request->Buffer), static_cast<std::streamsize>(request->BufferSize));
+            request->BytesRead = static_cast<uint64_t>(stream.gcount());
+            request->IsSucceeded = !stream.bad();
+            Stats().AddBytesRead(request->BytesRead);
+        }
+    }
+
+    /*
+     * Approximate heap held by file list
+     */
+    virtual uint64_t IndexBytes() const override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return EstimateIndexBytes(m_FileList, sizeof(NativeFile));
+        } else {
+            return EstimateIndexBytes(m_FileList, sizeof(NativeFile));
+        }
+    }
+
 private:
-    inline void InitializeST()
+    inline bool InitializeST()
     {
         if (m_IsInitialized) {
-            return;
+            return false;
         }
 
         if (!fs::exists(m_BasePath.c_str()) || !fs::is_directory(m_BasePath.c_str())) {
-            return;
+            return false;
         }
 
         BuildFilelist(m_BasePath, m_FileList);
+
+        // Permissions are read once, checking them on every open costs a stat and a path allocation
+        auto perms = fs::status(m_BasePath.c_str()).permissions();
+        m_IsReadOnly = (perms & fs::perms::owner_write) == fs::perms::none;
         m_IsInitialized = true;
+        return true;
     }
 
-    inline void ShutdownST()
+    inline bool ShutdownST()
     {
+        bool isReset = !m_FileList.empty();
         m_BasePath = "";
         // close all files
         for (auto& file : m_FileList) {
@@ -251,6 +414,7 @@ private:
         }
         m_FileList.clear();
         m_IsInitialized = false;
+        return isReset;
     }
     
     inline bool IsInitializedST() const
@@ -267,15 +431,21 @@ private:
     {
         return m_FileList;
     }
+
+    inline void ForEachFileST(const eastl::function<void(eastl::string_view)>& callback) const
+    {
+        for (const auto& file : m_FileList) {
+            callback(eastl::string_view(file.first.data(), file.first.length()));
+        }
+    }
     
     inline bool IsReadOnlyST() const
     {
         if (!IsInitializedST()) {
             return true;
         }
-        
-        auto perms = fs::status(m_BasePath.c_str()).permissions();
-        return (perms & fs::perms::owner_write) == fs::perms::none;
+
+        return m_IsReadOnly;
     }
     
     inline HFile OpenFileST(const FileInfo& filePath, IFile::FileMode mode)
@@ -286,6 +456,7 @@ private:
         requestWrite |= ((mode & IFile::FileMode::Truncate) == IFile::FileMode::Truncate);
 
         if (IsReadOnlyST() && requestWrite) {
+            Stats().AddMiss();
             return nullptr;
         }
 
@@ -293,7 +464,7 @@ private:
         bool isExists = (file != nullptr);
         if (!isExists && !IsReadOnlyST()) {
             mode = mode | IFile::FileMode::Truncate;
-            file.reset(new NativeFile(filePath));
+            file.reset(new NativeFile(filePath, SharedStats()));
         }
 
         if (file) {
@@ -301,8 +472,15 @@ private:
        
             if (!isExists && file->IsOpened()) {
                 m_FileList[filePath.AbsolutePath()] = file;
+                NotifyListeners(filePath, FileEvent::Created);
             }
         }
+
+        if (file && file->IsOpened()) {
+            Stats().AddOpen();
+        } else {
+            Stats().AddMiss();
+        }
         
         return file;
     }
@@ -331,7 +509,9 @@ private:
             return false;
         }
         
-        m_FileList.erase(filePath.AbsolutePath());
+        if (m_FileList.erase(filePath.AbsolutePath()) > 0) {
+            NotifyListeners(filePath, FileEvent::Removed);
+        }
         return fs::remove(filePath.AbsolutePath().c_str());
     }
     
@@ -362,11 +542,72 @@ private:
         return true;
     }
 
+    inline HFile OpenFileST(eastl::string_view filePath, IFile::FileMode mode)
+    {
+        HFile file = FindFile(filePath, m_FileList);
+        if (file) {
+            return OpenFileST(file->GetFileInfo(), mode);
+        }
+
+        // New file needs its FileInfo anyway
+        return OpenFileST(FileInfo(eastl::string(filePath.data(), filePath.length())), mode);
+    }
+
+    inline bool FileSizeST(const FileInfo& filePath, uint64_t& outSize) const
+    {
+        if (!IsFileExistsST(filePath)) {
+            return false;
+        }
+
+        std::error_code error;
+        uintmax_t size = fs::file_size(filePath.AbsolutePath().c_str(), error);
+        if (error) {
+            return false;
+        }
+
+        outSize = static_cast<uint64_t>(size);
+        return true;
+    }
+
     inline bool IsFileExistsST(const FileInfo& filePath) const
     {
         return FindFile(filePath, m_FileList) != nullptr;
     }
 
+    /*
+     * Known file of a batch with its physical location
+     */
+    struct PendingRead
+    {
+        BatchReadRequest* Request = nullptr;
+        eastl::string Path;
+        uint64_t Device = 0;
+        uint64_t Inode = 0;
+    };
+
+    inline void CollectReadsST(const eastl::vector<BatchReadRequest*>& requests, eastl::vector<PendingRead>& outPendingReads) const
+    {
+        outPendingReads.reserve(requests.size());
+        for (BatchReadRequest* request : requests) {
+            if (!IsFileExistsST(request->FilePath)) {
+                Stats().AddMiss();
+                continue;
+            }
+
+            PendingRead pendingRead;
+            pendingRead.Request = request;
+            pendingRead.Path = request->FilePath.AbsolutePath();
+#if defined(__unix__) || defined(__APPLE__)
+            struct stat fileStat;
+            if (stat(pendingRead.Path.c_str(), &fileStat) == 0) {
+                pendingRead.Device = static_cast<uint64_t>(fileStat.st_dev);
+                pendingRead.Inode = static_cast<uint64_t>(fileStat.st_ino);
+            }
+#endif
+            outPendingReads.push_back(eastl::move(pendingRead));
+        }
+    }
+
     void BuildFilelist(eastl::string basePath, TFileList& outFileList)
     {
         for (const auto& entry : fs::directory_iterator(basePath.c_str())) {
@@ -375,7 +616,7 @@ private:
                 BuildFilelist(entry.path().string().c_str(), outFileList);
             } else if (fs::is_regular_file(entry.status())) {
                 FileInfo fileInfo(basePath, filename.c_str(), false);
-                HFile file(new NativeFile(fileInfo));
+                HFile file(new NativeFile(fileInfo, SharedStats()));
                 outFileList[fileInfo.AbsolutePath()] = file;
             }
         }
@@ -384,6 +625,7 @@ private:
 private:
     eastl::string m_BasePath;
     bool m_IsInitialized;
+    bool m_IsReadOnly;
     TFileList m_FileList;
     mutable std::mutex m_Mutex;
 };
@@ -0,0 +1,674 @@
+#ifndef OVERLAYINDEX_HPP
+#define OVERLAYINDEX_HPP
+
+#include "IFileSystem.h"
+#include "StringUtils.hpp"
+
+#include <shared_mutex>
+
+#include <EASTL/fixed_vector.h>
+
+namespace Titan::Vfs
+{
+
+using HOverlayIndex = eastl::shared_ptr<class OverlayIndex>;
+
+/*
+ * Merged view of all layers mounted on one alias. Maps relative path to every
+ * layer that has it, so the winning (newest) layer is found with one hash probe
+ * regardless of stack depth. Kept up to date incrementally on layer changes and
+ * on file creation/removal reported by layers, a layer is reindexed when it is
+ * initialized or shut down. Layers listed lazily (fast mounted archives) are not
+ * copied on mount, lookups probe them until a directory listing needs their files.
+ *
+ * Index is copy-on-write: every change builds a complete new version that shares
+ * untouched shards with the previous one and replaces it at once. Added layers are
+ * indexed before they replace removed ones, so lookups never see a layer half gone
+ */
+class OverlayIndex final
+{
+public:
+    static constexpr size_t k_Shards = 64;
+
+    /*
+     * Layers that have one relative path
+     */
+    struct Entry
+    {
+        eastl::fixed_vector<uint16_t, 2, true> Layers;
+    };
+
+    typedef eastl::unordered_map<eastl::string, Entry, StringHash, StringEqual> TEntryMap;
+
+    struct Layer
+    {
+        HFileSystem FileSystem;
+        // Absolute path of layer root, stripped from file list keys
+        eastl::string Prefix;
+        uint32_t Rank = 0;
+        // Lazily listed layer that is not indexed yet
+        bool IsPending = false;
+    };
+
+    /*
+     * Immutable version of index, stays complete while newer versions are built
+     */
+    struct State
+    {
+        eastl::vector<Layer> Layers;
+        // Entries by relative path, split so a change copies only shards it touches. Shards never written are null
+        eastl::shared_ptr<const TEntryMap> Shards[k_Shards];
+        size_t NumEntries = 0;
+
+        static inline size_t ShardOf(uint64_t hash)
+        {
+            return static_cast<size_t>((hash >> 32) % k_Shards);
+        }
+
+        inline const Entry* FindEntry(eastl::string_view relativePath) const
+        {
+            uint64_t hash = StringUtils::Hash(relativePath);
+            const TEntryMap* shard = Shards[ShardOf(hash)].get();
+            if (!shard) {
+                return nullptr;
+            }
+
+            auto it = shard->find_as(relativePath, StringKnownHash(hash), StringEqual());
+            return (it != shard->end()) ? &it->second : nullptr;
+        }
+
+        /*
+         * Newest layer of entry
+         */
+        inline const Layer& Winner(const Entry& entry) const
+        {
+            const Layer* winner = &Layers[entry.Layers.front()];
+            for (uint16_t id : entry.Layers) {
+                const Layer& layer = Layers[id];
+                if (layer.Rank > winner->Rank) {
+                    winner = &layer;
+                }
+            }
+            return *winner;
+        }
+    };
+
+    typedef eastl::shared_ptr<const State> HState;
+
+public:
+    OverlayIndex()
+        : m_State(eastl::make_shared<State>())
+    {
+    }
+
+    OverlayIndex(const OverlayIndex&) = delete;
+    OverlayIndex& operator=(const OverlayIndex&) = delete;
+
+    /*
+     * Set layers in mount order (first is base). Files of added layers are gathered first,
+     * then added and removed layers are swapped in one new version
+     */
+    void SetLayers(const eastl::list<HFileSystem>& layers)
+    {
+        for (;;) {
+            eastl::vector<GatheredLayer> addedLayers;
+            if constexpr (g_MtSupportEnabled) {
+                std::lock_guard<std::mutex> lock(m_WriteMutex);
+                StageLayersST(layers, addedLayers);
+            } else {
+                StageLayersST(layers, addedLayers);
+            }
+
+            for (GatheredLayer& added : addedLayers) {
+                added.Info = MakeLayer(added.Info.FileSystem);
+                if (!added.Info.IsPending) {
+                    GatherFiles(added.Info, added.RelativePaths);
+                }
+            }
+
+            bool isApplied = false;
+            if constexpr (g_MtSupportEnabled) {
+                std::lock_guard<std::mutex> lock(m_WriteMutex);
+                isApplied = ApplyLayersST(layers, addedLayers);
+            } else {
+                isApplied = ApplyLayersST(layers, addedLayers);
+            }
+            if (isApplied) {
+                return;
+            }
+        }
+    }
+
+    /*
+     * Index files of layers that are still probed on lookup, must be called before entries are walked
+     */
+    void IndexPendingLayers()
+    {
+        HState state = GetState();
+        for (const Layer& layer : state->Layers) {
+            if (layer.FileSystem && layer.IsPending) {
+                IndexLayer(*layer.FileSystem, true);
+            }
+        }
+    }
+
+    /*
+     * Find newest layer that has 'relativePath'
+     */
+    HFileSystem Find(eastl::string_view relativePath) const
+    {
+        HFileSystem winner;
+        TProbeList probes;
+        if constexpr (g_MtSupportEnabled) {
+            std::shared_lock<std::shared_mutex> lock(m_Mutex);
+            winner = FindST(relativePath, probes);
+        } else {
+            winner = FindST(relativePath, probes);
+        }
+
+        // Pending layers newer than indexed winner are asked without holding index lock, newest first
+        for (const Probe& probe : probes) {
+            if (probe.FileSystem->IsFileExists(eastl::string_view(probe.Path.data(), probe.Path.length()))) {
+                return probe.FileSystem;
+            }
+        }
+        return winner;
+    }
+
+    /*
+     * Apply file creation/removal reported by a layer, other filesystems are ignored.
+     * Reset reindexes whole layer, so it must be reported without holding filesystem lock
+     */
+    void OnFileEvent(const IFileSystem& fs, const FileInfo& fileInfo, IFileSystem::FileEvent event)
+    {
+        if (event == IFileSystem::FileEvent::Reset) {
+            bool isLazy = fs.IsListedLazily();
+            bool isStale = false;
+            if constexpr (g_MtSupportEnabled) {
+                std::lock_guard<std::mutex> lock(m_WriteMutex);
+                isStale = ResetLayerST(fs, isLazy);
+            } else {
+                isStale = ResetLayerST(fs, isLazy);
+            }
+            if (isStale) {
+                IndexLayer(fs, false);
+            }
+            return;
+        }
+
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_WriteMutex);
+            OnFileEventST(fs, fileInfo, event);
+        } else {
+            OnFileEventST(fs, fileInfo, event);
+        }
+    }
+
+    /*
+     * Current version of index, it is never changed and may be walked without locks
+     */
+    HState GetState() const
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::shared_lock<std::shared_mutex> lock(m_Mutex);
+            return m_State;
+        } else {
+            return m_State;
+        }
+    }
+
+    /*
+     * Number of distinct relative paths over all layers
+     */
+    size_t Size() const
+    {
+        return GetState()->NumEntries;
+    }
+
+    /*
+     * Approximate heap held by current version of index, shards shared with older versions included
+     */
+    uint64_t MemoryBytes() const
+    {
+        HState state = GetState();
+        uint64_t bytes = sizeof(State) + state->Layers.capacity() * sizeof(Layer);
+        for (const auto& shard : state->Shards) {
+            if (!shard) {
+                continue;
+            }
+
+            bytes += sizeof(TEntryMap) + shard->bucket_count() * sizeof(void*);
+            for (const auto& it : *shard) {
+                bytes += sizeof(TEntryMap::node_type) + it.first.capacity() + 1;
+            }
+        }
+        for (const Layer& layer : state->Layers) {
+            bytes += layer.Prefix.capacity() + 1;
+        }
+        return bytes;
+    }
+
+private:
+    static constexpr uint16_t k_InvalidLayer = 0xFFFF;
+
+    /*
+     * Pending layer to ask for a path
+     */
+    struct Probe
+    {
+        HFileSystem FileSystem;
+        uint32_t Rank = 0;
+        FileInfo::TPathBuffer Path;
+    };
+
+    typedef eastl::fixed_vector<Probe, 2, true> TProbeList;
+
+    /*
+     * File list of a layer gathered without index locks, valid while layer has no newer events
+     */
+    struct GatheredLayer
+    {
+        Layer Info;
+        uint64_t Sequence = 0;
+        eastl::vector<eastl::string> RelativePaths;
+    };
+
+    /*
+     * Copy of a version that is being changed, shards are copied on first write
+     */
+    class StateEditor final
+    {
+    public:
+        explicit StateEditor(const State& base)
+            : m_State(eastl::make_shared<State>(base))
+        {
+        }
+
+        inline State& Get()
+        {
+            return *m_State;
+        }
+
+        inline TEntryMap& MutableShard(size_t shard)
+        {
+            if (!m_Copies[shard]) {
+                const TEntryMap* source = m_State->Shards[shard].get();
+                eastl::shared_ptr<TEntryMap> copy = source ? eastl::make_shared<TEntryMap>(*source) : eastl::make_shared<TEntryMap>();
+                m_Copies[shard] = copy.get();
+                m_State->Shards[shard] = eastl::move(copy);
+                m_IsChanged = true;
+            }
+            return *m_Copies[shard];
+        }
+
+        inline bool IsChanged() const
+        {
+            return m_IsChanged;
+        }
+
+        inline HState Finish()
+        {
+            return eastl::move(m_State);
+        }
+
+    private:
+        eastl::shared_ptr<State> m_State;
+        TEntryMap* m_Copies[k_Shards] = {};
+        bool m_IsChanged = false;
+    };
+
+    static inline uint16_t FindLayer(const State& state, const IFileSystem* fs)
+    {
+        for (uint16_t id = 0; id < state.Layers.size(); ++id) {
+            if (state.Layers[id].FileSystem.get() == fs) {
+                return id;
+            }
+        }
+        return k_InvalidLayer;
+    }
+
+    static inline Layer MakeLayer(const HFileSystem& fs)
+    {
+        Layer layer;
+        layer.FileSystem = fs;
+        layer.Prefix = FileInfo(fs->BasePath(), "", false).AbsolutePath();
+        layer.IsPending = fs->IsListedLazily();
+        return layer;
+    }
+
+    static inline uint16_t AddLayer(State& state, const Layer& layer)
+    {
+        // Reuse slot of a removed layer
+        for (uint16_t id = 0; id < state.Layers.size(); ++id) {
+            if (!state.Layers[id].FileSystem) {
+                state.Layers[id] = layer;
+                return id;
+            }
+        }
+
+        state.Layers.push_back(layer);
+        return static_cast<uint16_t>(state.Layers.size() - 1);
+    }
+
+    static inline void AddFile(StateEditor& editor, uint16_t id, eastl::string_view relativePath)
+    {
+        uint64_t hash = StringUtils::Hash(relativePath);
+        TEntryMap& shard = editor.MutableShard(State::ShardOf(hash));
+        auto it = shard.find_as(relativePath, StringKnownHash(hash), StringEqual());
+        if (it == shard.end()) {
+            it = shard.insert(eastl::make_pair(eastl::string(relativePath.data(), relativePath.length()), Entry())).first;
+            ++editor.Get().NumEntries;
+        }
+
+        auto& layers = it->second.Layers;
+        if (eastl::find(layers.begin(), layers.end(), id) == layers.end()) {
+            layers.push_back(id);
+        }
+    }
+
+    static inline void RemoveFile(StateEditor& editor, uint16_t id, eastl::string_view relativePath)
+    {
+        // Shard is only copied if layer really has the file
+        const Entry* entry = editor.Get().FindEntry(relativePath);
+        if (!entry || eastl::find(entry->Layers.begin(), entry->Layers.end(), id) == entry->Layers.end()) {
+            return;
+        }
+
+        uint64_t hash = StringUtils::Hash(relativePath);
+        TEntryMap& shard = editor.MutableShard(State::ShardOf(hash));
+        auto it = shard.find_as(relativePath, StringKnownHash(hash), StringEqual());
+
+        auto& layers = it->second.Layers;
+        layers.erase(eastl::remove(layers.begin(), layers.end(), id), layers.end());
+        if (layers.empty()) {
+            shard.erase(it);
+            --editor.Get().NumEntries;
+        }
+    }
+
+    static inline void ClearLayer(StateEditor& editor, uint16_t id)
+    {
+        for (size_t i = 0; i < k_Shards; ++i) {
+            const TEntryMap* source = editor.Get().Shards[i].get();
+            bool hasLayer = source && eastl::any_of(source->begin(), source->end(), [id](const TEntryMap::value_type& value) {
+                return eastl::find(value.second.Layers.begin(), value.second.Layers.end(), id) != value.second.Layers.end();
+            });
+            if (!hasLayer) {
+                continue;
+            }
+
+            TEntryMap& shard = editor.MutableShard(i);
+            for (auto it = shard.begin(); it != shard.end();) {
+                auto& layers = it->second.Layers;
+                layers.erase(eastl::remove(layers.begin(), layers.end(), id), layers.end());
+                if (layers.empty()) {
+                    it = shard.erase(it);
+                    --editor.Get().NumEntries;
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    /*
+     * Replace current version. Must be called with write mutex held, replaced version is released
+     * after index lock, readers may still hold it
+     */
+    inline void PublishST(HState state)
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::unique_lock<std::shared_mutex> lock(m_Mutex);
+            m_State.swap(state);
+        } else {
+            m_State.swap(state);
+        }
+    }
+
+    /*
+     * Layers that are not indexed yet, events of them are counted from now on. Layer details
+     * are filled in by caller, filesystems must not be called under write mutex
+     */
+    inline void StageLayersST(const eastl::list<HFileSystem>& layers, eastl::vector<GatheredLayer>& outAddedLayers)
+    {
+        for (const HFileSystem& fs : layers) {
+            if (FindLayer(*m_State, fs.get()) != k_InvalidLayer) {
+                continue;
+            }
+
+            GatheredLayer added;
+            added.Info.FileSystem = fs;
+            added.Sequence = m_Sequences[fs.get()];
+            outAddedLayers.push_back(eastl::move(added));
+        }
+    }
+
+    /*
+     * Returns false if file list of an added layer has to be gathered again
+     */
+    inline bool ApplyLayersST(const eastl::list<HFileSystem>& layers, const eastl::vector<GatheredLayer>& addedLayers)
+    {
+        for (const GatheredLayer& added : addedLayers) {
+            if (m_Sequences[added.Info.FileSystem.get()] != added.Sequence) {
+                return false;
+            }
+        }
+
+        StateEditor editor(*m_State);
+        State& state = editor.Get();
+
+        // Drop layers that are no longer mounted
+        for (uint16_t id = 0; id < state.Layers.size(); ++id) {
+            const HFileSystem& fs = state.Layers[id].FileSystem;
+            if (fs && eastl::find(layers.begin(), layers.end(), fs) == layers.end()) {
+                ClearLayer(editor, id);
+                m_Sequences.erase(fs.get());
+                state.Layers[id] = Layer();
+            }
+        }
+
+        for (const GatheredLayer& added : addedLayers) {
+            uint16_t id = AddLayer(state, added.Info);
+            for (const eastl::string& relativePath : added.RelativePaths) {
+                AddFile(editor, id, relativePath);
+            }
+        }
+
+        // Refresh ranks of all layers
+        uint32_t rank = 0;
+        for (const HFileSystem& fs : layers) {
+            uint16_t id = FindLayer(state, fs.get());
+            if (id != k_InvalidLayer) {
+                state.Layers[id].Rank = rank++;
+            }
+        }
+
+        PublishST(editor.Finish());
+        return true;
+    }
+
+    /*
+     * Count reset of layer. Lazily listed layer drops its entries and is probed again until next
+     * listing, returns true if file list of layer has to be gathered again
+     */
+    inline bool ResetLayerST(const IFileSystem& fs, bool isLazy)
+    {
+        // Staged layer gathers its list again
+        auto sequence = m_Sequences.find(&fs);
+        if (sequence != m_Sequences.end()) {
+            ++sequence->second;
+        }
+
+        uint16_t id = FindLayer(*m_State, &fs);
+        if (id == k_InvalidLayer) {
+            return false;
+        }
+
+        if (!isLazy) {
+            return true;
+        }
+
+        StateEditor editor(*m_State);
+        ClearLayer(editor, id);
+        editor.Get().Layers[id].IsPending = true;
+        PublishST(editor.Finish());
+        return false;
+    }
+
+    /*
+     * Replace entries of layer 'fs' with its current file list. File lists are gathered without
+     * holding index locks since filesystems notify us under their own lock. An event that arrives
+     * meanwhile may be older or newer than gathered list, so list is gathered again
+     */
+    inline void IndexLayer(const IFileSystem& fs, bool isPendingOnly)
+    {
+        for (;;) {
+            GatheredLayer gathered;
+            bool isListed = false;
+            if constexpr (g_MtSupportEnabled) {
+                std::lock_guard<std::mutex> lock(m_WriteMutex);
+                isListed = ReadLayerST(fs, isPendingOnly, gathered);
+            } else {
+                isListed = ReadLayerST(fs, isPendingOnly, gathered);
+            }
+            if (!isListed) {
+                return;
+            }
+
+            GatherFiles(gathered.Info, gathered.RelativePaths);
+
+            bool isIndexed = false;
+            if constexpr (g_MtSupportEnabled) {
+                std::lock_guard<std::mutex> lock(m_WriteMutex);
+                isIndexed = ReplaceLayerST(gathered);
+            } else {
+                isIndexed = ReplaceLayerST(gathered);
+            }
+            if (isIndexed) {
+                return;
+            }
+        }
+    }
+
+    /*
+     * Returns false if layer is not mounted, or is already indexed when only pending layers are wanted
+     */
+    inline bool ReadLayerST(const IFileSystem& fs, bool isPendingOnly, GatheredLayer& outGathered)
+    {
+        uint16_t id = FindLayer(*m_State, &fs);
+        if (id == k_InvalidLayer || (isPendingOnly && !m_State->Layers[id].IsPending)) {
+            return false;
+        }
+
+        outGathered.Info = m_State->Layers[id];
+        outGathered.Sequence = m_Sequences[&fs];
+        return true;
+    }
+
+    /*
+     * Returns false if list has to be gathered again
+     */
+    inline bool ReplaceLayerST(const GatheredLayer& gathered)
+    {
+        // Layer may have been removed while its files were gathered
+        uint16_t id = FindLayer(*m_State, gathered.Info.FileSystem.get());
+        if (id == k_InvalidLayer) {
+            return true;
+        }
+        if (m_Sequences[gathered.Info.FileSystem.get()] != gathered.Sequence) {
+            return false;
+        }
+
+        StateEditor editor(*m_State);
+        ClearLayer(editor, id);
+        for (const eastl::string& relativePath : gathered.RelativePaths) {
+            AddFile(editor, id, relativePath);
+        }
+        editor.Get().Layers[id].IsPending = false;
+        PublishST(editor.Finish());
+        return true;
+    }
+
+    static inline void GatherFiles(const Layer& layer, eastl::vector<eastl::string>& outRelativePaths)
+    {
+        eastl::string_view prefix(layer.Prefix.data(), layer.Prefix.length());
+        layer.FileSystem->ForEachFile([&](eastl::string_view filePath) {
+            if (filePath.length() >= prefix.length() && filePath.substr(0, prefix.length()) == prefix) {
+                filePath.remove_prefix(prefix.length());
+                outRelativePaths.emplace_back(filePath.data(), filePath.length());
+            }
+        });
+    }
+
+    inline HFileSystem FindST(eastl::string_view relativePath, TProbeList& outProbes) const
+    {
+        const State& state = *m_State;
+        const Layer* winner = nullptr;
+        const Entry* entry = state.FindEntry(relativePath);
+        if (entry) {
+            // Entries without layers are erased, so there is always a winner
+            winner = &state.Winner(*entry);
+        }
+
+        for (const Layer& layer : state.Layers) {
+            if (layer.FileSystem && layer.IsPending && (!winner || layer.Rank > winner->Rank)) {
+                Probe probe;
+                probe.FileSystem = layer.FileSystem;
+                probe.Rank = layer.Rank;
+                probe.Path = layer.Prefix.c_str();
+                probe.Path.append(relativePath.data(), relativePath.length());
+                outProbes.push_back(eastl::move(probe));
+            }
+        }
+        eastl::sort(outProbes.begin(), outProbes.end(), [](const Probe& a, const Probe& b) {
+            return a.Rank > b.Rank;
+        });
+
+        return winner ? winner->FileSystem : nullptr;
+    }
+
+    inline void OnFileEventST(const IFileSystem& fs, const FileInfo& fileInfo, IFileSystem::FileEvent event)
+    {
+        // Staged layers count events too, their gathered lists may be outdated by them
+        auto sequence = m_Sequences.find(&fs);
+        if (sequence != m_Sequences.end()) {
+            ++sequence->second;
+        }
+
+        uint16_t id = FindLayer(*m_State, &fs);
+        if (id == k_InvalidLayer) {
+            return;
+        }
+
+        const eastl::string& prefix = m_State->Layers[id].Prefix;
+        const eastl::string& absolutePath = fileInfo.AbsolutePath();
+        if (!StringUtils::StartsWith(absolutePath, prefix)) {
+            return;
+        }
+
+        StateEditor editor(*m_State);
+        eastl::string_view relativePath(absolutePath.data() + prefix.length(), absolutePath.length() - prefix.length());
+        if (event == IFileSystem::FileEvent::Created) {
+            AddFile(editor, id, relativePath);
+        } else {
+            RemoveFile(editor, id, relativePath);
+        }
+
+        if (editor.IsChanged()) {
+            PublishST(editor.Finish());
+        }
+    }
+
+private:
+    // Current version, replaced under exclusive lock and read under shared lock
+    HState m_State;
+    mutable std::shared_mutex m_Mutex;
+    // Serializes changes, guards event sequences. Filesystems are never called while it is held
+    std::mutex m_WriteMutex;
+    // Events per layer, tells if gathered file list may be older than index
+    eastl::unordered_map<const IFileSystem*, uint64_t> m_Sequences;
+};
+
+} // namespace vfspp
+
+#endif // OVERLAYINDEX_HPP
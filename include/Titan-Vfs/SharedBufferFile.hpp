@@ -0,0 +1,374 @@
+#ifndef SHAREDBUFFERFILE_HPP
+#define SHAREDBUFFERFILE_HPP
+
+#include "IFile.h"
+
+namespace Titan::Vfs
+{
+
+using HSharedBufferFile = eastl::shared_ptr<class SharedBufferFile>;
+using HSharedBuffer = eastl::shared_ptr<const eastl::vector<uint8_t>>;
+
+/*
+ * Read-only file over a buffer that may be shared with other files, such as prefetched file data
+ */
+class SharedBufferFile final : public IFile
+{
+public:
+    /*
+     * 'reservedStats' owns reservation of buffer size, released when file is destroyed
+     */
+    SharedBufferFile(const FileInfo& fileInfo, HSharedBuffer data, const HFileSystemStats& reservedStats = nullptr)
+        : m_FileInfo(fileInfo)
+        , m_Data(eastl::move(data))
+        , m_IsOpened(false)
+        , m_SeekPos(0)
+        , m_ReservedStats(reservedStats)
+    {
+    }
+
+    ~SharedBufferFile()
+    {
+        Close();
+        if (m_ReservedStats && m_Data) {
+            m_ReservedStats->ReleaseFileData(m_Data->size());
+        }
+    }
+    
+    /*
+     * Get file information
+     */
+    virtual const FileInfo& GetFileInfo() const override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return GetFileInfoST();
+        } else {
+            return GetFileInfoST();
+        }
+    }
+    
+    /*
+     * Returns file size
+     */
+    virtual uint64_t Size() override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return SizeST();
+        } else {
+            return SizeST();
+        }
+    }
+    
+    /*
+     * Check is readonly filesystem
+     */
+    virtual bool IsReadOnly() const override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return IsReadOnlyST();
+        } else {
+            return IsReadOnlyST();
+        }
+    }
+    
+    /*
+     * Open file for reading/writting
+     */
+    virtual void Open(FileMode mode) override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            OpenST(mode);
+        } else {
+            OpenST(mode);
+        }
+    }
+    
+    /*
+     * Close file
+     */
+    virtual void Close() override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            CloseST();
+        } else {
+            CloseST();
+        }
+    }
+    
+    /*
+     * Check is file ready for reading/writing
+     */
+    virtual bool IsOpened() const override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return IsOpenedST();
+        } else {
+            return IsOpenedST();
+        }
+    }
+    
+    /*
+     * Seek on a file
+     */
+    virtual uint64_t Seek(uint64_t offset, Origin origin) override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return SeekST(offset, origin);
+        } else {
+            return SeekST(offset, origin);
+        }
+    }
+    /*
+     * Returns offset in file
+     */
+    virtual uint64_t Tell() override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return TellST();
+        } else {
+            return TellST();
+        }
+    }
+    
+    /*
+     * Read data from file to buffer
+     */
+    virtual uint64_t Read(uint8_t* buffer, uint64_t size) override
+    {
+        AllocationScope allocationScope(AllocOp::Read);
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return ReadST(buffer, size);
+        } else {
+            return ReadST(buffer, size);
+        }
+    }
+    /*
+     * Write buffer data to file
+     */
+    virtual uint64_t Write(const uint8_t* buffer, uint64_t size) override
+    {
+        AllocationScope allocationScope(AllocOp::Write);
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return WriteST(buffer, size);
+        } else {
+            return WriteST(buffer, size);
+        }
+    }
+
+    /*
+     * Read data from file to vector
+     */
+    virtual uint64_t Read(eastl::vector<uint8_t>& buffer, uint64_t size) override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return ReadST(buffer, size);
+        } else {
+            return ReadST(buffer, size);
+        }
+    }
+    
+    /*
+     * Write data from vector to file
+     */
+    virtual uint64_t Write(const eastl::vector<uint8_t>& buffer) override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return WriteST(buffer);
+        } else {
+            return WriteST(buffer);
+        }
+    }
+    
+    /*
+     * Read data from file to stream
+     */
+    virtual uint64_t Read(std::ostream& stream, uint64_t size, uint64_t bufferSize = 1024) override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return ReadST(stream, size, bufferSize);
+        } else {
+            return ReadST(stream, size, bufferSize);
+        }
+    }
+    
+    /*
+     * Write data from stream to file
+     */
+    virtual uint64_t Write(std::istream& stream, uint64_t size, uint64_t bufferSize = 1024) override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return WriteST(stream, size, bufferSize);
+        } else {
+            return WriteST(stream, size, bufferSize);
+        }
+    }
+
+    /*
+     * Get shared buffer without copying
+     */
+    virtual bool GetView(FileView& outView) override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return GetViewST(outView);
+        } else {
+            return GetViewST(outView);
+        }
+    }
+    
+private:
+    inline const FileInfo& GetFileInfoST() const
+    {
+        return m_FileInfo;
+    }
+    
+    inline uint64_t SizeST()
+    {
+        if (IsOpenedST() && m_Data) {
+            return m_Data->size();
+        }
+        
+        return 0;
+    }
+    
+    inline bool IsReadOnlyST() const
+    {
+        return true;
+    }
+    
+    inline void OpenST(FileMode mode)
+    {
+        bool requestWrite = ((mode & IFile::FileMode::Write) == IFile::FileMode::Write);
+        requestWrite |= ((mode & IFile::FileMode::Append) == IFile::FileMode::Append);
+        requestWrite |= ((mode & IFile::FileMode::Truncate) == IFile::FileMode::Truncate);
+
+        if (requestWrite) {
+            return;
+        }
+
+        m_SeekPos = 0;
+        m_IsOpened = true;
+    }
+    
+    inline void CloseST()
+    {
+        m_IsOpened = false;
+        m_SeekPos = 0;
+    }
+
+    inline bool GetViewST(FileView& outView) const
+    {
+        if (!IsOpenedST() || !m_Data) {
+            return false;
+        }
+
+        outView.Data = m_Data->data();
+        outView.Size = m_Data->size();
+        outView.Owner = m_Data;
+        return true;
+    }
+    
+    inline bool IsOpenedST() const
+    {
+        return m_IsOpened;
+    }
+    
+    inline uint64_t SeekST(uint64_t offset, Origin origin)
+    {
+        if (!IsOpenedST()) {
+            return 0;
+        }
+        
+        if (origin == IFile::Origin::Begin) {
+            m_SeekPos = offset;
+        } else if (origin == IFile::Origin::End) {
+            m_SeekPos = SizeST() - eastl::min(offset, SizeST());
+        } else if (origin == IFile::Origin::Set) {
+            m_SeekPos += offset;
+        }
+        m_SeekPos = eastl::min(m_SeekPos, SizeST());
+
+        return TellST();
+    }
+    
+    inline uint64_t TellST()
+    {
+        return m_SeekPos;
+    }
+    
+    inline uint64_t ReadST(uint8_t* buffer, uint64_t size)
+    {
+        if (!IsOpenedST()) {
+            return 0;
+        }
+        
+        uint64_t leftSize = SizeST() - TellST();
+        uint64_t maxSize = eastl::min(size, leftSize);
+        if (maxSize > 0) {
+            memcpy(buffer, m_Data->data() + m_SeekPos, static_cast<size_t>(maxSize));
+            m_SeekPos += maxSize;
+            return maxSize;
+        }
+
+        return 0;
+    }
+    
+    inline uint64_t WriteST(const uint8_t* buffer, uint64_t size)
+    {
+        return 0;
+    }
+
+    inline uint64_t ReadST(eastl::vector<uint8_t>& buffer, uint64_t size)
+    {
+        buffer.resize(size);
+        uint64_t bytesRead = ReadST(buffer.data(), size);
+        buffer.resize(bytesRead);
+        return bytesRead;
+    }
+    
+    inline uint64_t WriteST(const eastl::vector<uint8_t>& buffer)
+    {
+        return 0;
+    }
+    
+    inline uint64_t ReadST(std::ostream& stream, uint64_t size, uint64_t bufferSize = 1024)
+    {
+        uint64_t maxSize = eastl::min(size, SizeST() - TellST());
+        if (maxSize > 0) {
+            stream.write(reinterpret_cast<const char*>(m_Data->data() + m_SeekPos), static_cast<std::streamsize>(maxSize));
+            m_SeekPos += maxSize;
+        }
+        return maxSize;
+    }
+    
+    inline uint64_t WriteST(std::istream& stream, uint64_t size, uint64_t bufferSize = 1024)
+    {
+        return 0;
+    }
+
+private:
+    FileInfo m_FileInfo;
+    HSharedBuffer m_Data;
+    bool m_IsOpened;
+    uint64_t m_SeekPos;
+    HFileSystemStats m_ReservedStats;
+    mutable std::mutex m_Mutex;
+};
+    
+} // namespace vfspp
+
+#endif // SHAREDBUFFERFILE_HPP
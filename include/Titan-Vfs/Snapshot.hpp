@@ -0,0 +1,185 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include "Global.h"
+
+#include <thread>
+
+#include <EASTL/unique_ptr.h>
+
+namespace Titan::Vfs
+{
+
+/*
+ * Holder of an immutable object that is replaced as a whole (read-copy-update).
+ * Readers pick the current version with one atomic load and never block, writers
+ * publish a new version and must be serialized by the caller. Readers count
+ * themselves in per-thread stripes under the epoch they started in. Replaced
+ * version is freed once readers of its epoch have left, readers that started
+ * later never see it, so continuous reads don't hold it back.
+ */
+template<typename T>
+class Snapshot final
+{
+public:
+    /*
+     * Keeps acquired version alive while in scope
+     */
+    class ReadGuard final
+    {
+    public:
+        ReadGuard(const Snapshot* owner)
+        {
+            // Version is loaded after reader is counted, so writer either sees reader or reader sees newer version
+            uint64_t epoch = owner->m_Epoch.load();
+            m_Readers = &owner->m_Stripes[StripeIndex()].Readers[epoch & 1];
+            m_Readers->fetch_add(1);
+            m_Value = owner->m_Current.load();
+        }
+
+        ReadGuard(ReadGuard&& other)
+            : m_Readers(other.m_Readers)
+            , m_Value(other.m_Value)
+        {
+            other.m_Readers = nullptr;
+            other.m_Value = nullptr;
+        }
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ReadGuard& operator=(ReadGuard&&) = delete;
+
+        ~ReadGuard()
+        {
+            if (m_Readers) {
+                m_Readers->fetch_sub(1);
+            }
+        }
+
+        inline const T& operator*() const
+        {
+            return *m_Value;
+        }
+
+        inline const T* operator->() const
+        {
+            return m_Value;
+        }
+
+    private:
+        std::atomic<uint32_t>* m_Readers;
+        const T* m_Value;
+    };
+
+public:
+    Snapshot(eastl::unique_ptr<T> initial)
+        : m_Current(initial.release())
+    {
+    }
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    ~Snapshot()
+    {
+        Reclaim(true);
+        delete m_Current.load();
+    }
+
+    /*
+     * Get current version
+     */
+    ReadGuard Acquire() const
+    {
+        return ReadGuard(this);
+    }
+
+    /*
+     * Replace current version. Calls must be serialized by the caller
+     */
+    void Publish(eastl::unique_ptr<T> next)
+    {
+        T* previous = m_Current.exchange(next.release());
+        m_Retired.push_back(eastl::make_pair(previous, m_Epoch.load()));
+
+        // Two steps free the version replaced above right away when no older reader is active
+        TryAdvance();
+        TryAdvance();
+        Reclaim(false);
+    }
+
+    /*
+     * Number of replaced versions that are still waiting for readers to leave
+     */
+    size_t RetiredCount() const
+    {
+        return m_Retired.size();
+    }
+
+private:
+    // Stripes are picked by thread, so readers on different threads rarely share a cache line
+    static constexpr size_t k_Stripes = 16;
+
+    struct alignas(64) Stripe
+    {
+        // Readers that started in even and odd epochs
+        std::atomic<uint32_t> Readers[2] = {};
+    };
+
+    static inline size_t StripeIndex()
+    {
+        static thread_local size_t index = std::hash<std::thread::id>()(std::this_thread::get_id()) % k_Stripes;
+        return index;
+    }
+
+    inline uint32_t CountReaders(uint64_t epoch) const
+    {
+        uint32_t numReaders = 0;
+        for (const Stripe& stripe : m_Stripes) {
+            numReaders += stripe.Readers[epoch & 1].load();
+        }
+        return numReaders;
+    }
+
+    /*
+     * Move to next epoch once readers of previous one have left. Only readers of current and
+     * previous epoch can then be active, and next epoch reuses counters of previous one
+     */
+    inline void TryAdvance()
+    {
+        uint64_t epoch = m_Epoch.load();
+        if (CountReaders(epoch + 1) == 0) {
+            m_Epoch.store(epoch + 1);
+        }
+    }
+
+    /*
+     * Version replaced during epoch 'e' may be held only by readers of 'e' and earlier,
+     * they have all left once epoch advanced twice since
+     */
+    inline void Reclaim(bool force)
+    {
+        uint64_t epoch = m_Epoch.load();
+        auto isReclaimable = [&](const eastl::pair<T*, uint64_t>& retired) {
+            return force || retired.second + 2 <= epoch;
+        };
+
+        for (const auto& retired : m_Retired) {
+            if (isReclaimable(retired)) {
+                delete retired.first;
+            }
+        }
+        m_Retired.erase(eastl::remove_if(m_Retired.begin(), m_Retired.end(), isReclaimable), m_Retired.end());
+    }
+
+private:
+    std::atomic<T*> m_Current;
+    std::atomic<uint64_t> m_Epoch = 0;
+    mutable Stripe m_Stripes[k_Stripes];
+    // Replaced versions with epoch they were replaced in
+    eastl::vector<eastl::pair<T*, uint64_t>> m_Retired;
+};
+
+} // namespace vfspp
+
+#endif // SNAPSHOT_HPP
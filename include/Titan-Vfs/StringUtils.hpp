@@ -48,6 +48,72 @@ public:
         return false;
     }
 
+    /*
+     * 64-bit FNV-1a hash, stable across string types
+     */
+    static uint64_t Hash(eastl::string_view text)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : text) {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+};
+
+/*
+ * Hasher that gives equal results for eastl::string and eastl::string_view,
+ * so string keyed tables can be searched with a view via find_as
+ */
+struct StringHash
+{
+    size_t operator()(eastl::string_view text) const
+    {
+        return static_cast<size_t>(StringUtils::Hash(text));
+    }
+
+    size_t operator()(const eastl::string& text) const
+    {
+        return static_cast<size_t>(StringUtils::Hash(eastl::string_view(text.data(), text.length())));
+    }
+};
+
+/*
+ * Hasher for find_as when StringHash of the key is already known
+ */
+struct StringKnownHash
+{
+    explicit StringKnownHash(uint64_t hash)
+        : Hash(hash)
+    {
+    }
+
+    size_t operator()(eastl::string_view) const
+    {
+        return static_cast<size_t>(Hash);
+    }
+
+    uint64_t Hash;
+};
+
+struct StringEqual
+{
+    bool operator()(const eastl::string& a, eastl::string_view b) const
+    {
+        return eastl::string_view(a.data(), a.length()) == b;
+    }
+
+    bool operator()(eastl::string_view a, const eastl::string& b) const
+    {
+        return a == eastl::string_view(b.data(), b.length());
+    }
+
+    bool operator()(const eastl::string& a, const eastl::string& b) const
+    {
+        return a == b;
+    }
 };
 
 }; // namespace vfspp
@@ -3,28 +3,459 @@
 
 #include "IFileSystem.h"
 #include "IFile.h"
-#include "EASTL/sort.h"
+#include "AliasTrie.hpp"
+#include "OverlayIndex.hpp"
+#include "Snapshot.hpp"
+#include "Executor.hpp"
+#include "SharedBufferFile.hpp"
+#include "InstrumentedFile.hpp"
+
+#include <future>
+
+#include <EASTL/unordered_set.h>
 
 namespace Titan::Vfs
 {
 
 using HVirtualFileSystem = std::shared_ptr<class VirtualFileSystem>;
-    
-class VirtualFileSystem final
+
+class VirtualFileSystem final : public std::enable_shared_from_this<VirtualFileSystem>
 {
 public:
     typedef eastl::list<HFileSystem> TFileSystemList;
     typedef eastl::unordered_map<eastl::string, TFileSystemList> TFileSystemMap;
 
+    /*
+     * Layers mounted on one alias and their merged index
+     */
+    struct MountPoint
+    {
+        const TFileSystemList* FileSystems = nullptr;
+        OverlayIndex* Overlay = nullptr;
+        FileSystemStats* Stats = nullptr;
+    };
+
+    typedef AliasTrie<MountPoint> TAliasTrie;
+
+    /*
+     * Completion callbacks of asynchronous operations, invoked on executor thread
+     */
+    typedef eastl::function<void(HFile)> TOpenCallback;
+    typedef eastl::function<void(uint64_t)> TReadCallback;
+    typedef eastl::function<void(eastl::vector<BatchReadRequest>&, size_t)> TReadFilesCallback;
+
+    /*
+     * Prefetch counters. Held bytes are prefetched and not yet opened, wasted bytes were
+     * evicted, cleared or went stale before anyone opened them
+     */
+    struct PrefetchStats
+    {
+        uint64_t PrefetchedBytes = 0;
+        uint64_t UsedBytes = 0;
+        uint64_t WastedBytes = 0;
+        uint64_t HeldBytes = 0;
+    };
+
+    /*
+     * Resolution cache counters
+     */
+    struct ResolveCacheStats
+    {
+        uint64_t Hits = 0;
+        uint64_t Misses = 0;
+        uint64_t Invalidations = 0;
+    };
+
+    /*
+     * Counters of one alias. Opens and misses are counted on the alias that routed the
+     * request, layer counters are summed over its filesystems (shared ones are counted per alias)
+     */
+    struct MountStats
+    {
+        eastl::string Alias;
+        uint64_t Opens = 0;
+        uint64_t Misses = 0;
+        FileSystemStats::Snapshot Layers;
+    };
+
+    /*
+     * Latency percentiles of one alias. OpenFile is measured on the alias that routed the
+     * request and includes path resolution, layer histograms are merged over its filesystems
+     */
+    struct MountLatency
+    {
+        eastl::string Alias;
+        LatencyHistogram::Summary OpenFile;
+        LatencyHistogram::Summary Layers[static_cast<size_t>(LatencyOp::Count)];
+    };
+
+    /*
+     * Latency percentiles of one mounted filesystem, reported once even if mounted on several aliases
+     */
+    struct BackendLatency
+    {
+        HFileSystem FileSystem;
+        LatencyHistogram::Summary Ops[static_cast<size_t>(LatencyOp::Count)];
+    };
+
+    /*
+     * Memory of one alias. File data and indexes are summed over its filesystems
+     * (shared ones are counted per alias), budget is set by SetMountMemoryLimit
+     */
+    struct MountMemory
+    {
+        eastl::string Alias;
+        uint64_t FileDataBytes = 0;
+        uint64_t IndexBytes = 0;
+        uint64_t OverlayBytes = 0;
+        bool HasLimit = false;
+        MemoryBudget::Snapshot Budget;
+    };
+
+    /*
+     * Approximate memory held by virtual filesystem and its mounts
+     */
+    struct MemoryStats
+    {
+        eastl::vector<MountMemory> Mounts;
+        uint64_t ResolveCacheBytes = 0;
+        uint64_t PrefetchBytes = 0;
+    };
+
+    /*
+     * Time spent waiting on internal locks of virtual filesystem
+     */
+    struct LockStats
+    {
+        LockWaitStats::Snapshot MountTable;
+        LockWaitStats::Snapshot ResolveCache;
+        LockWaitStats::Snapshot Prefetch;
+    };
+
+private:
+    /*
+     * Immutable version of mount table, readers pick it up without locking
+     */
+    struct MountTable
+    {
+        TFileSystemMap FileSystems;
+        // Indexes are shared between versions, every change of one replaces its whole index version at once
+        eastl::unordered_map<eastl::string, HOverlayIndex> Overlays;
+        // Shared between versions like indexes, so counters survive remounts of other aliases
+        eastl::unordered_map<eastl::string, HFileSystemStats> MountStats;
+        TAliasTrie AliasTrie;
+    };
+
+    typedef Snapshot<MountTable>::ReadGuard TMountTableGuard;
+
+public:
+    /*
+     * File found by directory listing. Views point into listing and stay valid while it is alive
+     */
+    struct DirectoryEntry
+    {
+        // Listed directory
+        eastl::string_view Directory;
+        // Path from listed directory to a deeper alias, empty if file comes from alias above directory
+        eastl::string_view AliasPath;
+        // Rest of path below listed directory
+        eastl::string_view Path;
+        // Path inside owning layer
+        eastl::string_view LayerPath;
+        // Newest layer that has the file, for a directory one of layers that have files in it
+        const HFileSystem* FileSystem = nullptr;
+
+        /*
+         * File name with extension
+         */
+        eastl::string_view Name() const
+        {
+            eastl::string_view path = Path;
+            if (!path.empty() && path.back() == '/') {
+                path.remove_suffix(1);
+            }
+
+            size_t slash = path.rfind('/');
+            return (slash == eastl::string_view::npos) ? path : path.substr(slash + 1);
+        }
+
+        /*
+         * Path relative to listed directory
+         */
+        eastl::string RelativePath() const
+        {
+            eastl::string relativePath(AliasPath.data(), AliasPath.length());
+            relativePath.append(Path.data(), Path.length());
+            return relativePath;
+        }
+
+        /*
+         * Path that opens this file through virtual filesystem
+         */
+        FileInfo VirtualPath() const
+        {
+            eastl::string virtualPath(Directory.data(), Directory.length());
+            virtualPath.append(AliasPath.data(), AliasPath.length());
+            virtualPath.append(Path.data(), Path.length());
+            return FileInfo(virtualPath);
+        }
+
+        /*
+         * Path of file inside owning layer
+         */
+        FileInfo RealPath() const
+        {
+            return FileInfo((*FileSystem)->BasePath(), eastl::string(LayerPath.data(), LayerPath.length()), false);
+        }
+    };
+
+    /*
+     * Merged listing of one directory over all layers and aliases. Shadowed files are
+     * reported once, from the layer that OpenFile would use. Listing keeps the index
+     * versions that were current when it was made and walks them lazily without locks,
+     * so files and mounts may be changed while iterating, later changes are not reflected in it
+     */
+    class DirectoryRange final
+    {
+        friend class VirtualFileSystem;
+
+        /*
+         * Alias that contributes to listing
+         */
+        struct Source
+        {
+            OverlayIndex::HState State;
+            eastl::string Alias;
+            eastl::string AliasPath;
+            // Keys inside index that belong to listed directory start with it
+            eastl::string KeyPrefix;
+        };
+
+        typedef eastl::unordered_set<eastl::string, StringHash, StringEqual> TDirectorySet;
+
+    public:
+        class Iterator final
+        {
+            friend class DirectoryRange;
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef DirectoryEntry value_type;
+            typedef ptrdiff_t difference_type;
+            typedef const DirectoryEntry* pointer;
+            typedef const DirectoryEntry& reference;
+
+            inline reference operator*() const
+            {
+                return m_Entry;
+            }
+
+            inline pointer operator->() const
+            {
+                return &m_Entry;
+            }
+
+            inline Iterator& operator++()
+            {
+                ++m_It;
+                Settle();
+                return *this;
+            }
+
+            inline bool operator==(const Iterator& other) const
+            {
+                if (m_Source != other.m_Source || m_Shard != other.m_Shard) {
+                    return false;
+                }
+                return m_Source == m_Range->m_Sources.size() || m_It == other.m_It;
+            }
+
+            inline bool operator!=(const Iterator& other) const
+            {
+                return !(*this == other);
+            }
+
+        private:
+            Iterator(const DirectoryRange* range, uint32_t source)
+                : m_Range(range)
+                , m_Source(source)
+            {
+                m_It = FirstOfShard();
+                Settle();
+            }
+
+            inline OverlayIndex::TEntryMap::const_iterator FirstOfShard() const
+            {
+                if (m_Source < m_Range->m_Sources.size()) {
+                    const OverlayIndex::TEntryMap* shard = m_Range->m_Sources[m_Source].State->Shards[m_Shard].get();
+                    if (shard) {
+                        return shard->begin();
+                    }
+                }
+                return OverlayIndex::TEntryMap::const_iterator();
+            }
+
+            /*
+             * Move forward to the first listed entry at or after current position
+             */
+            inline void Settle()
+            {
+                while (m_Source < m_Range->m_Sources.size()) {
+                    const OverlayIndex::TEntryMap* shard = m_Range->m_Sources[m_Source].State->Shards[m_Shard].get();
+                    if (shard) {
+                        for (; m_It != shard->end(); ++m_It) {
+                            if (m_Range->Load(m_Source, *m_It, m_Directories, m_Entry)) {
+                                return;
+                            }
+                        }
+                    }
+
+                    if (++m_Shard == OverlayIndex::k_Shards) {
+                        m_Shard = 0;
+                        ++m_Source;
+                    }
+                    m_It = FirstOfShard();
+                }
+            }
+
+        private:
+            const DirectoryRange* m_Range;
+            uint32_t m_Source;
+            size_t m_Shard = 0;
+            OverlayIndex::TEntryMap::const_iterator m_It;
+            // Subdirectories already reported by non-recursive listing
+            TDirectorySet m_Directories;
+            DirectoryEntry m_Entry;
+        };
+
+    public:
+        DirectoryRange(const DirectoryRange&) = delete;
+        DirectoryRange& operator=(const DirectoryRange&) = delete;
+
+        Iterator begin() const
+        {
+            return Iterator(this, 0);
+        }
+
+        Iterator end() const
+        {
+            return Iterator(this, static_cast<uint32_t>(m_Sources.size()));
+        }
+
+    private:
+        DirectoryRange(const MountTable& table, eastl::string directory, bool isRecursive)
+            : m_Directory(eastl::move(directory))
+            , m_IsRecursive(isRecursive)
+        {
+            eastl::string_view directoryView(m_Directory.data(), m_Directory.length());
+            for (const auto& it : table.Overlays) {
+                eastl::string_view alias(it.first.data(), it.first.length());
+
+                Source source;
+                source.Alias = it.first;
+                if (directoryView.compare(0, alias.length(), alias) == 0) {
+                    eastl::string_view keyPrefix = directoryView.substr(alias.length());
+                    source.KeyPrefix.assign(keyPrefix.data(), keyPrefix.length());
+                } else if (m_IsRecursive && alias.compare(0, directoryView.length(), directoryView) == 0) {
+                    eastl::string_view aliasPath = alias.substr(directoryView.length());
+                    source.AliasPath.assign(aliasPath.data(), aliasPath.length());
+                } else {
+                    continue;
+                }
+                // Lazily listed layers are indexed before listing needs their files
+                it.second->IndexPendingLayers();
+                source.State = it.second->GetState();
+                m_Sources.push_back(eastl::move(source));
+            }
+
+            // Longer aliases win on lookup, so they are listed first and shadow shorter ones
+            eastl::sort(m_Sources.begin(), m_Sources.end(), [](const Source& a, const Source& b) {
+                return a.Alias.length() > b.Alias.length();
+            });
+        }
+
+        /*
+         * Fill entry if index entry is listed. Non-recursive listing reports files in
+         * subdirectories as their subdirectory, once per iterator
+         */
+        inline bool Load(uint32_t sourceIndex, const OverlayIndex::TEntryMap::value_type& value, TDirectorySet& directories, DirectoryEntry& outEntry) const
+        {
+            const Source& source = m_Sources[sourceIndex];
+            eastl::string_view key(value.first.data(), value.first.length());
+            eastl::string_view keyPrefix(source.KeyPrefix.data(), source.KeyPrefix.length());
+            if (key.compare(0, keyPrefix.length(), keyPrefix) != 0) {
+                return false;
+            }
+
+            eastl::string_view path = key.substr(keyPrefix.length());
+            if (path.empty()) {
+                return false;
+            }
+
+            size_t slash = m_IsRecursive ? eastl::string_view::npos : path.find('/');
+            if (slash != eastl::string_view::npos) {
+                // Layers without explicit directory entries only have files below it
+                path = path.substr(0, slash + 1);
+                key = key.substr(0, keyPrefix.length() + slash + 1);
+                if (!directories.insert(eastl::string(path.data(), path.length())).second) {
+                    return false;
+                }
+            } else if (IsShadowed(sourceIndex, key)) {
+                return false;
+            }
+
+            outEntry.Directory = eastl::string_view(m_Directory.data(), m_Directory.length());
+            outEntry.AliasPath = eastl::string_view(source.AliasPath.data(), source.AliasPath.length());
+            outEntry.Path = path;
+            outEntry.LayerPath = key;
+            outEntry.FileSystem = &source.State->Winner(value.second).FileSystem;
+            return true;
+        }
+
+        /*
+         * File is hidden if a longer alias on its path has it too
+         */
+        inline bool IsShadowed(uint32_t sourceIndex, eastl::string_view key) const
+        {
+            const Source& source = m_Sources[sourceIndex];
+            for (uint32_t i = 0; i < sourceIndex; ++i) {
+                const Source& other = m_Sources[i];
+                if (other.Alias.length() == source.Alias.length() || !StringUtils::StartsWith(other.Alias, source.Alias)) {
+                    continue;
+                }
+
+                eastl::string_view aliasTail(other.Alias.data() + source.Alias.length(), other.Alias.length() - source.Alias.length());
+                if (key.compare(0, aliasTail.length(), aliasTail) == 0 && other.State->FindEntry(key.substr(aliasTail.length()))) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+        eastl::string m_Directory;
+        bool m_IsRecursive;
+        eastl::fixed_vector<Source, 4, true> m_Sources;
+    };
+
 private:
     VirtualFileSystem()
+        : m_MountTable(eastl::make_unique<MountTable>())
     {
     }
 public:
 
     ~VirtualFileSystem()
     {
-        for (const auto& fs : m_FileSystems) {
+        for (const auto& listener : m_Listeners) {
+            listener.first->RemoveListener(listener.second.first);
+        }
+
+        for (const auto& it : m_MountBudgets) {
+            DetachMountBudgetST(it.second);
+        }
+
+        TMountTableGuard table = m_MountTable.Acquire();
+        for (const auto& fs : table->FileSystems) {
             for (const auto& f : fs.second) {
                 f->Shutdown();
             }
@@ -35,7 +466,7 @@ public:
     {
         return HVirtualFileSystem(new VirtualFileSystem());
     }
-    
+
     /*
      * Register new filesystem. Alias is a base prefix to file access.
      * For ex. registered filesystem has base path '/home/media', but registered
@@ -44,6 +475,7 @@ public:
      */
     void AddFileSystem(eastl::string alias, HFileSystem filesystem)
     {
+        AllocationScope allocationScope(AllocOp::Mount);
         if (!filesystem) {
             return;
         }
@@ -51,47 +483,56 @@ public:
         if (!StringUtils::EndsWith(alias, "/")) {
             alias += "/";
         }
-        
+
         eastl::function<void()> fn = [&]() {
-            m_FileSystems[alias].push_back(filesystem);
-            if (eastl::find(m_SortedAlias.begin(), m_SortedAlias.end(), alias) == m_SortedAlias.end()) {
-                m_SortedAlias.push_back(alias);
-            }
-            eastl::sort(m_SortedAlias.begin(), m_SortedAlias.end(), [](const eastl::string& a1, const eastl::string& a2) {
-                return a1.length() > a2.length();
+            UpdateMountTableST([&](TFileSystemMap& fileSystems) {
+                fileSystems[alias].push_back(filesystem);
+                SubscribeST(filesystem);
+                return true;
             });
         };
-        
+
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &m_MountLockStats);
             fn();
         } else {
             fn();
         }
     }
-    
+
     /*
      * Remove registered filesystem
      */
     void RemoveFileSystem(eastl::string alias, HFileSystem filesystem)
     {
+        AllocationScope allocationScope(AllocOp::Mount);
         if (!StringUtils::EndsWith(alias, "/")) {
             alias += "/";
         }
 
         eastl::function<void()> fn = [&]() {
-            auto it = m_FileSystems.find(alias);
-            if (it != m_FileSystems.end()) {
+            UpdateMountTableST([&](TFileSystemMap& fileSystems) {
+                auto it = fileSystems.find(alias);
+                if (it == fileSystems.end()) {
+                    return false;
+                }
+
+                size_t numRemoved = it->second.size();
                 it->second.remove(filesystem);
+                numRemoved -= it->second.size();
+                while (numRemoved-- > 0) {
+                    UnsubscribeST(filesystem);
+                }
+
                 if (it->second.empty()) {
-                    m_FileSystems.erase(it);
-                    m_SortedAlias.erase(std::remove(m_SortedAlias.begin(), m_SortedAlias.end(), alias), m_SortedAlias.end());
+                    fileSystems.erase(it);
                 }
-            }
+                return true;
+            });
         };
 
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &m_MountLockStats);
             fn();
         } else {
             fn();
@@ -99,28 +540,65 @@ public:
     }
 
     /*
-     * Check if filesystem with 'alias' added
+     * Atomically replace mounted filesystem keeping its position in layer order.
+     * Readers observe either old or new filesystem, never a missing layer
      */
-    bool HasFileSystem(eastl::string alias, HFileSystem fileSystem) const
+    bool ReplaceFileSystem(eastl::string alias, HFileSystem oldFilesystem, HFileSystem newFilesystem)
     {
+        if (!newFilesystem) {
+            return false;
+        }
+
         if (!StringUtils::EndsWith(alias, "/")) {
             alias += "/";
         }
 
-        eastl::function<bool()> fn = [&]() -> bool {
-            auto it = m_FileSystems.find(alias);
-            if (it != m_FileSystems.end()) {
-                return (std::find(it->second.begin(), it->second.end(), fileSystem) != it->second.end());
-            }
-            return false;
+        bool isReplaced = false;
+        eastl::function<void()> fn = [&]() {
+            UpdateMountTableST([&](TFileSystemMap& fileSystems) {
+                auto it = fileSystems.find(alias);
+                if (it == fileSystems.end()) {
+                    return false;
+                }
+
+                auto fsIt = eastl::find(it->second.begin(), it->second.end(), oldFilesystem);
+                if (fsIt == it->second.end()) {
+                    return false;
+                }
+
+                *fsIt = newFilesystem;
+                SubscribeST(newFilesystem);
+                UnsubscribeST(oldFilesystem);
+                isReplaced = true;
+                return true;
+            });
         };
 
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
-            return fn();
+            TimedLockGuard<std::mutex> lock(m_Mutex, &m_MountLockStats);
+            fn();
         } else {
-            return fn();
+            fn();
+        }
+
+        return isReplaced;
+    }
+
+    /*
+     * Check if filesystem with 'alias' added
+     */
+    bool HasFileSystem(eastl::string alias, HFileSystem fileSystem) const
+    {
+        if (!StringUtils::EndsWith(alias, "/")) {
+            alias += "/";
+        }
+
+        TMountTableGuard table = m_MountTable.Acquire();
+        auto it = table->FileSystems.find(alias);
+        if (it != table->FileSystems.end()) {
+            return (eastl::find(it->second.begin(), it->second.end(), fileSystem) != it->second.end());
         }
+        return false;
     }
 
     /*
@@ -133,18 +611,28 @@ public:
         }
 
         eastl::function<void()> fn = [&]() {
-            m_FileSystems.erase(alias);
-            m_SortedAlias.erase(eastl::remove(m_SortedAlias.begin(), m_SortedAlias.end(), alias), m_SortedAlias.end());
+            UpdateMountTableST([&](TFileSystemMap& fileSystems) {
+                auto it = fileSystems.find(alias);
+                if (it == fileSystems.end()) {
+                    return false;
+                }
+
+                for (const auto& fs : it->second) {
+                    UnsubscribeST(fs);
+                }
+                fileSystems.erase(it);
+                return true;
+            });
         };
 
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &m_MountLockStats);
             fn();
         } else {
             fn();
         }
     }
-    
+
     /*
      * Check if there any filesystem with 'alias' registered
      */
@@ -154,142 +642,1619 @@ public:
             alias += "/";
         }
 
-        if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
-            return (m_FileSystems.find(alias) != m_FileSystems.end());
-        } else {
-            return (m_FileSystems.find(alias) != m_FileSystems.end());
-        }
+        TMountTableGuard table = m_MountTable.Acquire();
+        return (table->FileSystems.find(alias) != table->FileSystems.end());
     }
-    
+
     /*
-     * Get all added filesystems with 'alias'
+     * Get all added filesystems with 'alias'. Returns a copy since mount table may be replaced at any time
      */
-    const TFileSystemList& GetFilesystems(eastl::string alias)
+    TFileSystemList GetFilesystems(eastl::string alias) const
     {
-        if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
-            return GetFilesystemsST(alias);
-        } else {
-            return GetFilesystemsST(alias);
+        if (!StringUtils::EndsWith(alias, "/")) {
+            alias += "/";
+        }
+
+        TMountTableGuard table = m_MountTable.Acquire();
+        auto it = table->FileSystems.find(alias);
+        if (it != table->FileSystems.end()) {
+            return it->second;
         }
+
+        return TFileSystemList();
     }
-    
+
     /*
-     * Iterate over all registered filesystems and find first ocurrences of file
+     * Iterate over all registered filesystems and find first ocurrences of file.
+     * Doesn't block on mount table changes
      */
     HFile OpenFile(const FileInfo& filePath, IFile::FileMode mode)
     {
-        eastl::function<HFile()> fn = [&]() -> HFile {
-            for (const eastl::string& alias : m_SortedAlias) {
-                if (!StringUtils::StartsWith(filePath.AbsolutePath(), alias)) {
-                    continue;
-                }
+        AllocationScope allocationScope(AllocOp::OpenFile);
+        TraceScope traceScope("vfs", "OpenFile", filePath.AbsolutePath());
+        // Generation is taken before mount table so a resolution made against a replaced table is never cached
+        uint64_t generation = m_ResolveGeneration.load();
+        TMountTableGuard table = m_MountTable.Acquire();
+        if (m_IsTracing.load(std::memory_order_relaxed)) {
+            return OpenFileTracedST(*table, generation, filePath.AbsolutePath(), filePath.PathId(), mode);
+        }
+        return OpenFileST(*table, generation, filePath.AbsolutePath(), filePath.PathId(), mode);
+    }
 
-                // Strip alias from file path
-                eastl::string relativePath = filePath.AbsolutePath().substr(alias.length());
-                
-                // Enumerate reverse to get filesystems in order of registration
-                const TFileSystemList& filesystems = GetFilesystemsST(alias);
-                if (filesystems.empty()) {
-                    continue;
-                }
-                
-                for (auto it = filesystems.rbegin(); it != filesystems.rend(); ++it) {
-                    // Is it last filesystem
-                    HFileSystem fs = *it;
-                    bool isMain = (fs == filesystems.front());
-
-                    // If file exists in filesystem we try to open it. 
-                    // In case file not exists and we are in first filesystem we try to create new file if mode allows it
-                    FileInfo realPath(fs->BasePath(), relativePath, false);
-                    if (fs->IsFileExists(realPath) || isMain) {
-                        HFile file = fs->OpenFile(realPath, mode);
-                        if (file) {
-                            return file;
-                        }
-                    }
-                }
-            }
-            
-            return nullptr;
-        };
+    /*
+     * Open file by virtual path. Path is normalized on stack, so opening an existing file doesn't allocate
+     */
+    HFile OpenFile(eastl::string_view filePath, IFile::FileMode mode)
+    {
+        AllocationScope allocationScope(AllocOp::OpenFile);
+        TraceScope traceScope("vfs", "OpenFile", filePath);
+        FileInfo::TPathBuffer buffer;
+        eastl::string_view absolutePath = FileInfo::Normalize(filePath, buffer);
 
-        if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
-            return fn();
-        } else {
-            return fn();
+        uint64_t generation = m_ResolveGeneration.load();
+        TMountTableGuard table = m_MountTable.Acquire();
+        if (m_IsTracing.load(std::memory_order_relaxed)) {
+            return OpenFileTracedST(*table, generation, absolutePath, StringUtils::Hash(absolutePath), mode);
         }
+        return OpenFileST(*table, generation, absolutePath, StringUtils::Hash(absolutePath), mode);
     }
 
-    eastl::string AbsolutePath(eastl::string_view relativePath)
+    /*
+     * Check if any mounted layer has file
+     */
+    bool IsFileExists(const FileInfo& filePath) const
     {
-        eastl::function<eastl::string()> fn = [&]() -> eastl::string {
-            eastl::string strRelativePath = eastl::string(relativePath);
-            for (const eastl::string& alias : m_SortedAlias) {
-                if (!StringUtils::StartsWith(strRelativePath, alias)) {
-                    continue;
-                }
+        return FindResolved(filePath.AbsolutePath(), filePath.PathId()) != nullptr;
+    }
 
-                // Strip alias from file path
-                eastl::string strippedRelativePath = strRelativePath.substr(alias.length());
+    bool IsFileExists(eastl::string_view filePath) const
+    {
+        FileInfo::TPathBuffer buffer;
+        eastl::string_view absolutePath = FileInfo::Normalize(filePath, buffer);
+        return FindResolved(absolutePath, StringUtils::Hash(absolutePath)) != nullptr;
+    }
 
-                // Enumerate reverse to get filesystems in order of registration
-                const TFileSystemList& filesystems = GetFilesystemsST(alias);
-                if (filesystems.empty()) {
-                    continue;
-                }
+    /*
+     * Check is file in the layer that owns path
+     */
+    bool IsFile(const FileInfo& filePath) const
+    {
+        HResolvedPath resolved = FindResolved(filePath.AbsolutePath(), filePath.PathId());
+        return resolved && resolved->FileSystem->IsFile(resolved->RealPath);
+    }
 
-                for (auto it = filesystems.rbegin(); it != filesystems.rend(); ++it) {
-                    // Is it last filesystem
-                    HFileSystem fs = *it;
-                    bool isMain = (fs == filesystems.front());
+    bool IsFile(eastl::string_view filePath) const
+    {
+        FileInfo::TPathBuffer buffer;
+        eastl::string_view absolutePath = FileInfo::Normalize(filePath, buffer);
+        HResolvedPath resolved = FindResolved(absolutePath, StringUtils::Hash(absolutePath));
+        return resolved && resolved->FileSystem->IsFile(resolved->RealPath);
+    }
 
-                    // If file exists in filesystem we try to open it. 
-                    // In case file not exists and we are in first filesystem we try to create new file if mode allows it
-                    FileInfo realPath(fs->BasePath(), strippedRelativePath, false);
-                    if (fs->IsFileExists(realPath) || isMain) {
-                        return realPath.AbsolutePath();
-                    }
-                }
-            }
+    /*
+     * Check is dir in the layer that owns path
+     */
+    bool IsDir(const FileInfo& dirPath) const
+    {
+        HResolvedPath resolved = FindResolved(dirPath.AbsolutePath(), dirPath.PathId());
+        return resolved && resolved->FileSystem->IsDir(resolved->RealPath);
+    }
 
-            return "";
-            };
+    bool IsDir(eastl::string_view dirPath) const
+    {
+        FileInfo::TPathBuffer buffer;
+        eastl::string_view absolutePath = FileInfo::Normalize(dirPath, buffer);
+        HResolvedPath resolved = FindResolved(absolutePath, StringUtils::Hash(absolutePath));
+        return resolved && resolved->FileSystem->IsDir(resolved->RealPath);
+    }
 
-        if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
-            return fn();
-        }
-        else {
-            return fn();
-        }
+    /*
+     * Strings convert both to FileInfo and to string_view, these pick the string_view lookups
+     * so calls with eastl::string or a literal are not ambiguous
+     */
+    HFile OpenFile(const eastl::string& filePath, IFile::FileMode mode)
+    {
+        return OpenFile(eastl::string_view(filePath.data(), filePath.length()), mode);
     }
 
-private:
-    inline const TFileSystemList& GetFilesystemsST(eastl::string alias)
+    HFile OpenFile(const char* filePath, IFile::FileMode mode)
     {
-        if (!StringUtils::EndsWith(alias, "/")) {
-            alias += "/";
-        }
+        return OpenFile(eastl::string_view(filePath), mode);
+    }
 
-        auto it = m_FileSystems.find(alias);
-        if (it != m_FileSystems.end()) {
-            return it->second;
-        }
-        
-        static TFileSystemList empty;
-        return empty;
+    bool IsFileExists(const eastl::string& filePath) const
+    {
+        return IsFileExists(eastl::string_view(filePath.data(), filePath.length()));
     }
 
-    
-private:
-    TFileSystemMap m_FileSystems;
-    eastl::vector<eastl::string> m_SortedAlias;
-    mutable std::mutex m_Mutex;
-};
-    
+    bool IsFileExists(const char* filePath) const
+    {
+        return IsFileExists(eastl::string_view(filePath));
+    }
+
+    bool IsFile(const eastl::string& filePath) const
+    {
+        return IsFile(eastl::string_view(filePath.data(), filePath.length()));
+    }
+
+    bool IsFile(const char* filePath) const
+    {
+        return IsFile(eastl::string_view(filePath));
+    }
+
+    bool IsDir(const eastl::string& dirPath) const
+    {
+        return IsDir(eastl::string_view(dirPath.data(), dirPath.length()));
+    }
+
+    bool IsDir(const char* dirPath) const
+    {
+        return IsDir(eastl::string_view(dirPath));
+    }
+
+    eastl::string AbsolutePath(eastl::string_view relativePath)
+    {
+        uint64_t generation = m_ResolveGeneration.load();
+        TMountTableGuard table = m_MountTable.Acquire();
+        return AbsolutePathST(*table, generation, relativePath);
+    }
+
+    /*
+     * Read many files at once into caller buffers. Requests are grouped by owning
+     * filesystem which orders and merges its reads. Returns number of files read
+     */
+    size_t ReadFiles(eastl::vector<BatchReadRequest>& requests)
+    {
+        AllocationScope allocationScope(AllocOp::ReadFiles);
+        uint64_t generation = m_ResolveGeneration.load();
+        TMountTableGuard table = m_MountTable.Acquire();
+        return ReadFilesST(*table, generation, requests);
+    }
+
+    /*
+     * Set executor that runs asynchronous operations. By default a thread pool is
+     * created on first use, or requests run inline when multithreading is disabled
+     */
+    void SetExecutor(HExecutor executor)
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_ExecutorMutex);
+            m_Executor = eastl::move(executor);
+        } else {
+            m_Executor = eastl::move(executor);
+        }
+    }
+
+    /*
+     * Get executor of asynchronous operations, creates default one if none set
+     */
+    HExecutor GetExecutor()
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_ExecutorMutex);
+            if (!m_Executor) {
+                m_Executor = ThreadPoolExecutor::Create();
+            }
+            return m_Executor;
+        } else {
+            if (!m_Executor) {
+                m_Executor = InlineExecutor::Create();
+            }
+            return m_Executor;
+        }
+    }
+
+    /*
+     * Open file on executor. Result is null if filesystem was destroyed before request ran
+     */
+    std::future<HFile> OpenFileAsync(const FileInfo& filePath, IFile::FileMode mode)
+    {
+        return SubmitAsync<HFile>(OpenFileTask(filePath, mode));
+    }
+
+    void OpenFileAsync(const FileInfo& filePath, IFile::FileMode mode, TOpenCallback callback)
+    {
+        SubmitAsync<HFile>(OpenFileTask(filePath, mode), eastl::move(callback));
+    }
+
+    /*
+     * Read from opened file on executor, buffer must stay alive until completion
+     */
+    std::future<uint64_t> ReadAsync(HFile file, uint8_t* buffer, uint64_t size)
+    {
+        return SubmitAsync<uint64_t>(ReadTask(eastl::move(file), buffer, size));
+    }
+
+    void ReadAsync(HFile file, uint8_t* buffer, uint64_t size, TReadCallback callback)
+    {
+        SubmitAsync<uint64_t>(ReadTask(eastl::move(file), buffer, size), eastl::move(callback));
+    }
+
+    /*
+     * Batch read on executor. Requests are handed back with results, buffers must stay alive until completion
+     */
+    std::future<eastl::vector<BatchReadRequest>> ReadFilesAsync(eastl::vector<BatchReadRequest> requests)
+    {
+        auto promise = eastl::make_shared<std::promise<eastl::vector<BatchReadRequest>>>();
+        std::future<eastl::vector<BatchReadRequest>> future = promise->get_future();
+        std::weak_ptr<VirtualFileSystem> weakSelf = weak_from_this();
+        auto sharedRequests = eastl::make_shared<eastl::vector<BatchReadRequest>>(eastl::move(requests));
+        GetExecutor()->Submit([weakSelf, sharedRequests, promise]() {
+            try {
+                if (HVirtualFileSystem self = weakSelf.lock()) {
+                    self->ReadFiles(*sharedRequests);
+                }
+                promise->set_value(eastl::move(*sharedRequests));
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+            }
+        });
+        return future;
+    }
+
+    void ReadFilesAsync(eastl::vector<BatchReadRequest> requests, TReadFilesCallback callback)
+    {
+        std::weak_ptr<VirtualFileSystem> weakSelf = weak_from_this();
+        auto sharedRequests = eastl::make_shared<eastl::vector<BatchReadRequest>>(eastl::move(requests));
+        GetExecutor()->Submit([weakSelf, sharedRequests, callback]() {
+            size_t numRead = 0;
+            try {
+                if (HVirtualFileSystem self = weakSelf.lock()) {
+                    numRead = self->ReadFiles(*sharedRequests);
+                }
+            } catch (...) {
+                // Exception must not escape worker, failed requests are reported as not read
+                numRead = 0;
+            }
+            callback(*sharedRequests, numRead);
+        });
+    }
+
+    /*
+     * List files in 'directory' over all mounted layers, recursive listing includes
+     * subdirectories. Listing doesn't block mounts or file changes. Non-recursive listing
+     * reports every subdirectory once, recursive listing reports directories only if a layer
+     * has an explicit entry for them
+     */
+    DirectoryRange ListDirectory(eastl::string_view directory, bool isRecursive = false) const
+    {
+        AllocationScope allocationScope(AllocOp::ListDirectory);
+        FileInfo::TPathBuffer buffer;
+        eastl::string_view normalizedDirectory = FileInfo::Normalize(directory, buffer);
+
+        eastl::string directoryPath(normalizedDirectory.data(), normalizedDirectory.length());
+        if (!StringUtils::EndsWith(directoryPath, "/")) {
+            directoryPath += "/";
+        }
+
+        TMountTableGuard table = m_MountTable.Acquire();
+        return DirectoryRange(*table, eastl::move(directoryPath), isRecursive);
+    }
+
+    /*
+     * Read files in background and keep their data, so a later OpenFile in read mode is served
+     * from memory. Data is handed out once, files that don't fit prefetch capacity are skipped.
+     * Data is dropped when its file is opened for writing through this filesystem or created or
+     * removed in its layer. Executors that run tasks inline ignore prefetch, it would only block caller
+     */
+    void Prefetch(const eastl::vector<FileInfo>& paths, TaskPriority priority = TaskPriority::Low)
+    {
+        HExecutor executor = GetExecutor();
+        if (executor->IsInline()) {
+            return;
+        }
+
+        std::weak_ptr<VirtualFileSystem> weakSelf = weak_from_this();
+        executor->Submit([weakSelf, paths]() {
+            try {
+                if (HVirtualFileSystem self = weakSelf.lock()) {
+                    self->PrefetchFiles(paths);
+                }
+            } catch (...) {
+                // Prefetch is only a hint, files that were not read are opened as usual
+            }
+        }, priority);
+    }
+
+    /*
+     * Limit memory held by prefetched files, oldest files are dropped first
+     */
+    void SetPrefetchCapacity(uint64_t capacity)
+    {
+        m_PrefetchCapacity.store(capacity, std::memory_order_relaxed);
+
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_PrefetchMutex, &m_PrefetchLockStats);
+            TrimPrefetchedST();
+        } else {
+            TrimPrefetchedST();
+        }
+    }
+
+    /*
+     * Drop all prefetched files that were not opened yet
+     */
+    void ClearPrefetched()
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_PrefetchMutex, &m_PrefetchLockStats);
+            ClearPrefetchedST();
+        } else {
+            ClearPrefetchedST();
+        }
+    }
+
+    /*
+     * Get prefetch used/wasted byte counters
+     */
+    PrefetchStats GetPrefetchStats() const
+    {
+        PrefetchStats stats;
+        stats.PrefetchedBytes = m_PrefetchedBytes.load(std::memory_order_relaxed);
+        stats.UsedBytes = m_PrefetchUsedBytes.load(std::memory_order_relaxed);
+        stats.WastedBytes = m_PrefetchWastedBytes.load(std::memory_order_relaxed);
+
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_PrefetchMutex, &m_PrefetchLockStats);
+            stats.HeldBytes = m_PrefetchHeldBytes;
+        } else {
+            stats.HeldBytes = m_PrefetchHeldBytes;
+        }
+        return stats;
+    }
+
+    /*
+     * Limit file data held by filesystems mounted on 'alias', counting open zip entries, memory
+     * file contents and prefetched files. Going over limit drops the oldest prefetched files of the
+     * alias, then cached data of its layers. If that is not enough, hard limit makes the open or
+     * write fail, soft limit lets it through and calls 'onOverLimit' with the bytes still over
+     * limit. Zero limit removes it. Budget follows layers mounted later, a filesystem mounted on
+     * several limited aliases uses the latest one
+     */
+    void SetMountMemoryLimit(eastl::string alias, uint64_t limit, MemoryLimitMode mode, MemoryBudget::TEvictCallback onOverLimit = nullptr)
+    {
+        if (!StringUtils::EndsWith(alias, "/")) {
+            alias += "/";
+        }
+
+        eastl::function<void()> fn = [&]() {
+            auto it = m_MountBudgets.find(alias);
+            if (it != m_MountBudgets.end()) {
+                DetachMountBudgetST(it->second);
+                m_MountBudgets.erase(it);
+            }
+
+            if (limit == 0) {
+                return;
+            }
+
+            MountBudget& mountBudget = m_MountBudgets[alias];
+            mountBudget.Budget = MemoryBudget::Create(limit, mode);
+            std::weak_ptr<VirtualFileSystem> weakSelf = weak_from_this();
+            eastl::weak_ptr<MemoryBudget> weakBudget = mountBudget.Budget;
+            mountBudget.Budget->SetEvictCallback([weakSelf, weakBudget, alias, mode, onOverLimit](uint64_t excess) {
+                HVirtualFileSystem self = weakSelf.lock();
+                HMemoryBudget budget = weakBudget.lock();
+                if (self && budget) {
+                    excess -= eastl::min(excess, self->EvictPrefetched(budget, excess));
+                    if (excess > 0) {
+                        excess -= eastl::min(excess, self->ReleaseMountMemory(budget, alias, excess));
+                    }
+                }
+                // Hard limit refuses what is still over
+                if (excess > 0 && mode == MemoryLimitMode::Soft && onOverLimit) {
+                    onOverLimit(excess);
+                }
+            });
+
+            TMountTableGuard table = m_MountTable.Acquire();
+            AttachMountBudgetST(*table, alias, mountBudget);
+        };
+
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &m_MountLockStats);
+            fn();
+        } else {
+            fn();
+        }
+    }
+
+    /*
+     * Get approximate memory of every mounted alias, resolution cache and prefetched files
+     */
+    MemoryStats GetMemoryStats() const
+    {
+        MemoryStats stats;
+
+        eastl::unordered_map<eastl::string, HMemoryBudget> budgets;
+        {
+            auto copyBudgets = [&]() {
+                for (const auto& it : m_MountBudgets) {
+                    budgets[it.first] = it.second.Budget;
+                }
+            };
+
+            if constexpr (g_MtSupportEnabled) {
+                TimedLockGuard<std::mutex> lock(m_Mutex, &m_MountLockStats);
+                copyBudgets();
+            } else {
+                copyBudgets();
+            }
+        }
+
+        {
+            TMountTableGuard table = m_MountTable.Acquire();
+            stats.Mounts.reserve(table->FileSystems.size());
+            for (const auto& it : table->FileSystems) {
+                MountMemory memory;
+                memory.Alias = it.first;
+                for (const HFileSystem& fs : it.second) {
+                    memory.FileDataBytes += fs->GetStats().FileDataBytes;
+                    memory.IndexBytes += fs->IndexBytes();
+                }
+
+                auto overlayIt = table->Overlays.find(it.first);
+                if (overlayIt != table->Overlays.end()) {
+                    memory.OverlayBytes = overlayIt->second->MemoryBytes();
+                }
+
+                auto budgetIt = budgets.find(it.first);
+                if (budgetIt != budgets.end()) {
+                    memory.HasLimit = true;
+                    memory.Budget = budgetIt->second->GetSnapshot();
+                }
+                stats.Mounts.push_back(eastl::move(memory));
+            }
+        }
+
+        for (ResolveCacheShard& shard : m_ResolveCache) {
+            auto estimate = [&]() {
+                stats.ResolveCacheBytes += shard.Entries.bucket_count() * sizeof(void*);
+                for (const auto& it : shard.Entries) {
+                    // Entries of one lookup may be shared, each is counted where it is cached
+                    stats.ResolveCacheBytes += sizeof(TResolveCache::node_type) + it.first.capacity() + 1 + sizeof(ResolvedPath);
+                }
+            };
+
+            if constexpr (g_MtSupportEnabled) {
+                TimedLockGuard<std::mutex> lock(shard.Mutex, &m_ResolveCacheLockStats);
+                estimate();
+            } else {
+                estimate();
+            }
+        }
+
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_PrefetchMutex, &m_PrefetchLockStats);
+            stats.PrefetchBytes = m_PrefetchHeldBytes;
+        } else {
+            stats.PrefetchBytes = m_PrefetchHeldBytes;
+        }
+        return stats;
+    }
+
+    /*
+     * Drop all cached path resolutions
+     */
+    void InvalidateResolveCache()
+    {
+        m_ResolveGeneration.fetch_add(1);
+        for (auto& shard : m_ResolveCache) {
+            if constexpr (g_MtSupportEnabled) {
+                TimedLockGuard<std::mutex> lock(shard.Mutex, &m_ResolveCacheLockStats);
+                shard.Entries.clear();
+            } else {
+                shard.Entries.clear();
+            }
+        }
+        m_ResolveCacheInvalidations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /*
+     * Limit number of cached resolutions, cache is flushed when limit is reached
+     */
+    void SetResolveCacheCapacity(size_t capacity)
+    {
+        m_ResolveCacheCapacity.store(capacity, std::memory_order_relaxed);
+        InvalidateResolveCache();
+    }
+
+    /*
+     * Get resolution cache hit/miss counters
+     */
+    ResolveCacheStats GetResolveCacheStats() const
+    {
+        ResolveCacheStats stats;
+        stats.Hits = m_ResolveCacheHits.load(std::memory_order_relaxed);
+        stats.Misses = m_ResolveCacheMisses.load(std::memory_order_relaxed);
+        stats.Invalidations = m_ResolveCacheInvalidations.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    /*
+     * Get counters of every mounted alias
+     */
+    eastl::vector<MountStats> GetMountStats() const
+    {
+        TMountTableGuard table = m_MountTable.Acquire();
+
+        eastl::vector<MountStats> result;
+        result.reserve(table->FileSystems.size());
+        for (const auto& it : table->FileSystems) {
+            MountStats stats;
+            stats.Alias = it.first;
+
+            auto statsIt = table->MountStats.find(it.first);
+            if (statsIt != table->MountStats.end()) {
+                FileSystemStats::Snapshot mountStats = statsIt->second->GetSnapshot();
+                stats.Opens = mountStats.Opens;
+                stats.Misses = mountStats.Misses;
+            }
+
+            for (const HFileSystem& fs : it.second) {
+                stats.Layers.Add(fs->GetStats());
+            }
+            result.push_back(eastl::move(stats));
+        }
+        return result;
+    }
+
+    /*
+     * Write resolution, backend opens, zip inflates, native reads and lock waits of all
+     * filesystems into Chrome trace 'trace'. Sink is process wide, null stops recording
+     */
+    void SetChromeTrace(HChromeTrace trace)
+    {
+        ChromeTrace::SetActive(eastl::move(trace));
+    }
+
+    /*
+     * Record latency histograms of opens, reads, seeks and initialization. Recording is
+     * process wide and off by default, while off operations don't read the clock
+     */
+    void SetLatencyRecording(bool isRecording)
+    {
+        LatencyHistogram::SetRecording(isRecording);
+    }
+
+    bool IsLatencyRecording() const
+    {
+        return LatencyHistogram::IsRecording();
+    }
+
+    /*
+     * Get latency percentiles of every mounted alias
+     */
+    eastl::vector<MountLatency> GetMountLatency() const
+    {
+        TMountTableGuard table = m_MountTable.Acquire();
+
+        eastl::vector<MountLatency> result;
+        result.reserve(table->FileSystems.size());
+        for (const auto& it : table->FileSystems) {
+            MountLatency latency;
+            latency.Alias = it.first;
+
+            auto statsIt = table->MountStats.find(it.first);
+            if (statsIt != table->MountStats.end()) {
+                latency.OpenFile = statsIt->second->GetLatency(LatencyOp::OpenFile).Summarize();
+            }
+
+            for (size_t op = 0; op < static_cast<size_t>(LatencyOp::Count); ++op) {
+                LatencyHistogram::Snapshot merged;
+                for (const HFileSystem& fs : it.second) {
+                    merged.Add(fs->GetLatency(static_cast<LatencyOp>(op)));
+                }
+                latency.Layers[op] = merged.Summarize();
+            }
+            result.push_back(eastl::move(latency));
+        }
+        return result;
+    }
+
+    /*
+     * Get latency percentiles of every mounted filesystem
+     */
+    eastl::vector<BackendLatency> GetBackendLatency() const
+    {
+        TMountTableGuard table = m_MountTable.Acquire();
+
+        eastl::vector<BackendLatency> result;
+        for (const auto& it : table->FileSystems) {
+            for (const HFileSystem& fs : it.second) {
+                auto isSame = [&fs](const BackendLatency& latency) {
+                    return latency.FileSystem == fs;
+                };
+                if (eastl::find_if(result.begin(), result.end(), isSame) != result.end()) {
+                    continue;
+                }
+
+                BackendLatency latency;
+                latency.FileSystem = fs;
+                for (size_t op = 0; op < static_cast<size_t>(LatencyOp::Count); ++op) {
+                    latency.Ops[op] = fs->GetLatency(static_cast<LatencyOp>(op)).Summarize();
+                }
+                result.push_back(eastl::move(latency));
+            }
+        }
+        return result;
+    }
+
+    /*
+     * Get time spent waiting on mount table writer lock, resolution cache and prefetch locks
+     */
+    LockStats GetLockStats() const
+    {
+        LockStats stats;
+        stats.MountTable = m_MountLockStats.GetSnapshot();
+        stats.ResolveCache = m_ResolveCacheLockStats.GetSnapshot();
+        stats.Prefetch = m_PrefetchLockStats.GetSnapshot();
+        return stats;
+    }
+
+    /*
+     * Record every open, read, seek and close of files opened after this call.
+     * Null stops recording, files opened while recording keep writing into their trace
+     */
+    void SetAccessTrace(HAccessTrace trace)
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_AccessTraceMutex);
+            m_IsTracing.store(trace != nullptr, std::memory_order_relaxed);
+            m_AccessTrace = eastl::move(trace);
+        } else {
+            m_IsTracing.store(trace != nullptr, std::memory_order_relaxed);
+            m_AccessTrace = eastl::move(trace);
+        }
+    }
+
+    HAccessTrace GetAccessTrace() const
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_AccessTraceMutex);
+            return m_AccessTrace;
+        } else {
+            return m_AccessTrace;
+        }
+    }
+
+private:
+    /*
+     * Layer that owns a virtual path. Negative entries have no filesystem
+     */
+    struct ResolvedPath
+    {
+        HFileSystem FileSystem;
+        FileInfo RealPath = FileInfo(fs::path(), false);
+        size_t AliasIndex = 0;
+    };
+
+    // Entries are shared so a cache hit copies no strings
+    typedef eastl::shared_ptr<const ResolvedPath> HResolvedPath;
+    typedef eastl::unordered_map<eastl::string, HResolvedPath, StringHash, StringEqual> TResolveCache;
+
+    /*
+     * Cache is split in shards so concurrent readers rarely meet on the same lock
+     */
+    struct ResolveCacheShard
+    {
+        TResolveCache Entries;
+        std::mutex Mutex;
+    };
+
+    static constexpr size_t k_ResolveCacheShards = 16;
+
+    /*
+     * Layer that owns 'absolutePath', null if none
+     */
+    inline HResolvedPath FindResolved(eastl::string_view absolutePath, uint64_t pathId) const
+    {
+        uint64_t generation = m_ResolveGeneration.load();
+        TMountTableGuard table = m_MountTable.Acquire();
+
+        TAliasTrie::TMatchList matches;
+        table->AliasTrie.FindMatches(absolutePath, matches);
+
+        HResolvedPath resolved;
+        if (!ResolveST(generation, absolutePath, pathId, matches, resolved)) {
+            return nullptr;
+        }
+        return resolved;
+    }
+
+    inline HFile OpenFileST(const MountTable& table, uint64_t generation, eastl::string_view absolutePath, uint64_t pathId, IFile::FileMode mode)
+    {
+        uint64_t latencyStart = LatencyHistogram::Start();
+
+        TAliasTrie::TMatchList matches;
+        table.AliasTrie.FindMatches(absolutePath, matches);
+
+        HResolvedPath resolved;
+        bool isFound = ResolveST(generation, absolutePath, pathId, matches, resolved);
+
+        // Misses are counted on the innermost alias
+        auto account = [&matches, latencyStart](size_t aliasIndex, HFile file, bool isOpened) {
+            if (!matches.empty()) {
+                FileSystemStats& stats = *matches[eastl::min(aliasIndex, matches.size() - 1)].Value->Stats;
+                if (isOpened) {
+                    stats.AddOpen();
+                } else {
+                    stats.AddMiss();
+                }
+                stats.Latency(LatencyOp::OpenFile).RecordSince(latencyStart);
+            }
+            return file;
+        };
+
+        // Prefetched data is only valid for plain reads of the layer it was read from
+        if (isFound && mode == IFile::FileMode::Read && m_NumPrefetched.load(std::memory_order_relaxed) > 0) {
+            HFile file = TakePrefetched(absolutePath, pathId, *resolved);
+            if (file) {
+                return account(resolved->AliasIndex, file, true);
+            }
+        }
+
+        // File may be changed through returned handle, data read ahead of it is stale
+        bool requestWrite = ((mode & IFile::FileMode::Write) == IFile::FileMode::Write);
+        requestWrite |= ((mode & IFile::FileMode::Append) == IFile::FileMode::Append);
+        requestWrite |= ((mode & IFile::FileMode::Truncate) == IFile::FileMode::Truncate);
+        if (requestWrite) {
+            DropPrefetched(absolutePath, pathId);
+        }
+
+        // Aliases before the owning one have no such file, so only their main filesystem may create it
+        size_t numFallbacks = isFound ? resolved->AliasIndex : matches.size();
+        for (size_t i = 0; i < numFallbacks; ++i) {
+            const TFileSystemList& filesystems = *matches[i].Value->FileSystems;
+            if (filesystems.empty()) {
+                continue;
+            }
+
+            const HFileSystem& fs = filesystems.front();
+            eastl::string relativePath(matches[i].RelativePath.data(), matches[i].RelativePath.length());
+            HFile file = fs->OpenFile(FileInfo(fs->BasePath(), relativePath, false), mode);
+            if (file) {
+                // Writable main filesystem hands out unopened files for missing paths
+                return account(i, file, file->IsOpened());
+            }
+        }
+
+        if (!isFound) {
+            return account(0, nullptr, false);
+        }
+
+        HFile file = resolved->FileSystem->OpenFile(resolved->RealPath, mode);
+        if (file) {
+            return account(resolved->AliasIndex, file, true);
+        }
+
+        // Owning layer refused to open, probe all layers the slow way
+        size_t aliasIndex = 0;
+        file = OpenFileUncachedST(matches, mode, aliasIndex);
+        return account(aliasIndex, file, file != nullptr);
+    }
+
+    inline HFile OpenFileTracedST(const MountTable& table, uint64_t generation, eastl::string_view absolutePath, uint64_t pathId, IFile::FileMode mode)
+    {
+        HAccessTrace trace = GetAccessTrace();
+        if (!trace) {
+            return OpenFileST(table, generation, absolutePath, pathId, mode);
+        }
+
+        uint64_t start = trace->Now();
+        HFile file = OpenFileST(table, generation, absolutePath, pathId, mode);
+        uint32_t fileId = trace->RecordOpen(absolutePath, mode, start, file && file->IsOpened());
+        if (!file) {
+            return nullptr;
+        }
+        return HFile(new InstrumentedFile(eastl::move(file), eastl::move(trace), fileId));
+    }
+
+    inline HFile OpenFileUncachedST(const TAliasTrie::TMatchList& matches, IFile::FileMode mode, size_t& outAliasIndex)
+    {
+        for (size_t i = 0; i < matches.size(); ++i) {
+            const auto& match = matches[i];
+            // Alias is already stripped from file path
+            eastl::string relativePath(match.RelativePath.data(), match.RelativePath.length());
+
+            // Enumerate reverse to get filesystems in order of registration
+            const TFileSystemList& filesystems = *match.Value->FileSystems;
+            if (filesystems.empty()) {
+                continue;
+            }
+
+            for (auto it = filesystems.rbegin(); it != filesystems.rend(); ++it) {
+                // Is it last filesystem
+                HFileSystem fs = *it;
+                bool isMain = (fs == filesystems.front());
+
+                // If file exists in filesystem we try to open it.
+                // In case file not exists and we are in first filesystem we try to create new file if mode allows it
+                FileInfo realPath(fs->BasePath(), relativePath, false);
+                if (fs->IsFileExists(realPath) || isMain) {
+                    HFile file = fs->OpenFile(realPath, mode);
+                    if (file) {
+                        outAliasIndex = i;
+                        return file;
+                    }
+                }
+            }
+        }
+
+        return nullptr;
+    }
+
+    inline eastl::function<HFile()> OpenFileTask(const FileInfo& filePath, IFile::FileMode mode)
+    {
+        // Pending requests don't keep filesystem alive
+        std::weak_ptr<VirtualFileSystem> weakSelf = weak_from_this();
+        return [weakSelf, filePath, mode]() -> HFile {
+            if (HVirtualFileSystem self = weakSelf.lock()) {
+                return self->OpenFile(filePath, mode);
+            }
+            return nullptr;
+        };
+    }
+
+    static inline eastl::function<uint64_t()> ReadTask(HFile file, uint8_t* buffer, uint64_t size)
+    {
+        return [file, buffer, size]() -> uint64_t {
+            return file ? file->Read(buffer, size) : 0;
+        };
+    }
+
+    template<typename TResult>
+    inline std::future<TResult> SubmitAsync(eastl::function<TResult()> task)
+    {
+        // Promise is move only while tasks must be copyable
+        auto promise = eastl::make_shared<std::promise<TResult>>();
+        std::future<TResult> future = promise->get_future();
+        GetExecutor()->Submit([promise, task]() {
+            try {
+                promise->set_value(task());
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+            }
+        });
+        return future;
+    }
+
+    template<typename TResult>
+    inline void SubmitAsync(eastl::function<TResult()> task, eastl::function<void(TResult)> callback)
+    {
+        GetExecutor()->Submit([task, callback]() {
+            // Exception must not escape worker, failed task is reported with empty result
+            TResult result = TResult();
+            try {
+                result = task();
+            } catch (...) {
+            }
+            callback(eastl::move(result));
+        });
+    }
+
+    /*
+     * File data read ahead of time
+     */
+    struct PrefetchedFile
+    {
+        HSharedBuffer Data;
+        HFileSystem FileSystem;
+        FileInfo RealPath = FileInfo(fs::path(), false);
+        uint64_t Sequence = 0;
+    };
+
+    /*
+     * File being prefetched
+     */
+    struct PendingPrefetch
+    {
+        FileInfo VirtualPath = FileInfo(fs::path(), false);
+        HResolvedPath Resolved;
+        eastl::shared_ptr<eastl::vector<uint8_t>> Data;
+    };
+
+    inline void PrefetchFiles(const eastl::vector<FileInfo>& paths)
+    {
+        // Reads that overlap a write or file event may be stale, they are not kept
+        uint64_t invalidations = m_PrefetchInvalidations.load();
+        eastl::vector<PendingPrefetch> pendingFiles;
+        {
+            uint64_t generation = m_ResolveGeneration.load();
+            TMountTableGuard table = m_MountTable.Acquire();
+            uint64_t capacity = m_PrefetchCapacity.load(std::memory_order_relaxed);
+
+            for (const FileInfo& path : paths) {
+                if (IsPrefetched(path)) {
+                    continue;
+                }
+
+                TAliasTrie::TMatchList matches;
+                table->AliasTrie.FindMatches(path.AbsolutePath(), matches);
+
+                HResolvedPath resolved;
+                if (!ResolveST(generation, path.AbsolutePath(), path.PathId(), matches, resolved)) {
+                    continue;
+                }
+
+                uint64_t size = 0;
+                if (!resolved->FileSystem->FileSize(resolved->RealPath, size) || size > capacity) {
+                    continue;
+                }
+
+                // Prefetched data is charged to layer it was read from, hard memory limit skips it
+                if (!resolved->FileSystem->SharedStats()->ReserveFileData(size)) {
+                    continue;
+                }
+
+                PendingPrefetch pending;
+                pending.VirtualPath = path;
+                pending.Resolved = resolved;
+                pending.Data = eastl::make_shared<eastl::vector<uint8_t>>(static_cast<size_t>(size));
+                pendingFiles.push_back(eastl::move(pending));
+            }
+        }
+
+        // One batch per filesystem, so reads are ordered and merged by the filesystem
+        eastl::sort(pendingFiles.begin(), pendingFiles.end(), [](const PendingPrefetch& a, const PendingPrefetch& b) {
+            return a.Resolved->FileSystem.get() < b.Resolved->FileSystem.get();
+        });
+
+        eastl::vector<BatchReadRequest> requests;
+        eastl::vector<BatchReadRequest*> batch;
+        for (size_t first = 0; first < pendingFiles.size();) {
+            size_t last = first;
+            requests.clear();
+            while (last < pendingFiles.size() && pendingFiles[last].Resolved->FileSystem == pendingFiles[first].Resolved->FileSystem) {
+                eastl::vector<uint8_t>& data = *pendingFiles[last].Data;
+                requests.push_back(BatchReadRequest(pendingFiles[last].Resolved->RealPath, data.data(), data.size()));
+                ++last;
+            }
+
+            batch.clear();
+            for (BatchReadRequest& request : requests) {
+                batch.push_back(&request);
+            }
+            pendingFiles[first].Resolved->FileSystem->ReadFiles(batch);
+
+            for (size_t i = first; i < last; ++i) {
+                const BatchReadRequest& request = requests[i - first];
+                const HFileSystemStats& stats = pendingFiles[i].Resolved->FileSystem->SharedStats();
+                uint64_t reservedSize = pendingFiles[i].Data->size();
+                if (request.IsSucceeded) {
+                    pendingFiles[i].Data->resize(static_cast<size_t>(request.BytesRead));
+                    stats->ReleaseFileData(reservedSize - pendingFiles[i].Data->size());
+                    if (!StorePrefetched(pendingFiles[i], invalidations)) {
+                        stats->ReleaseFileData(pendingFiles[i].Data->size());
+                    }
+                } else {
+                    stats->ReleaseFileData(reservedSize);
+                }
+            }
+
+            first = last;
+        }
+    }
+
+    inline bool IsPrefetched(const FileInfo& path) const
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_PrefetchMutex, &m_PrefetchLockStats);
+            return IsPrefetchedST(path);
+        } else {
+            return IsPrefetchedST(path);
+        }
+    }
+
+    inline bool IsPrefetchedST(const FileInfo& path) const
+    {
+        return m_Prefetched.find_as(path.AbsolutePath(), StringKnownHash(path.PathId()), StringEqual()) != m_Prefetched.end();
+    }
+
+    /*
+     * Returns false if file was prefetched or prefetched data was invalidated meanwhile, then caller keeps its reservation
+     */
+    inline bool StorePrefetched(const PendingPrefetch& pending, uint64_t invalidations)
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_PrefetchMutex, &m_PrefetchLockStats);
+            return StorePrefetchedST(pending, invalidations);
+        } else {
+            return StorePrefetchedST(pending, invalidations);
+        }
+    }
+
+    inline bool StorePrefetchedST(const PendingPrefetch& pending, uint64_t invalidations)
+    {
+        if (m_PrefetchInvalidations.load() != invalidations) {
+            return false;
+        }
+        if (m_Prefetched.find(pending.VirtualPath.AbsolutePath()) != m_Prefetched.end()) {
+            return false;
+        }
+
+        PrefetchedFile prefetched;
+        prefetched.Data = pending.Data;
+        prefetched.FileSystem = pending.Resolved->FileSystem;
+        prefetched.RealPath = pending.Resolved->RealPath;
+        prefetched.Sequence = ++m_PrefetchSequence;
+        m_Prefetched.insert(eastl::make_pair(pending.VirtualPath.AbsolutePath(), prefetched));
+        m_PrefetchOrder.push_back(eastl::make_pair(pending.VirtualPath.AbsolutePath(), prefetched.Sequence));
+
+        uint64_t size = pending.Data->size();
+        m_PrefetchHeldBytes += size;
+        m_PrefetchedBytes.fetch_add(size, std::memory_order_relaxed);
+        m_NumPrefetched.store(m_Prefetched.size(), std::memory_order_relaxed);
+
+        TrimPrefetchedST();
+        return true;
+    }
+
+    /*
+     * Hand out prefetched data of 'absolutePath' if it still comes from resolved layer
+     */
+    inline HFile TakePrefetched(eastl::string_view absolutePath, uint64_t pathId, const ResolvedPath& resolved)
+    {
+        HSharedBuffer data;
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_PrefetchMutex, &m_PrefetchLockStats);
+            data = TakePrefetchedST(absolutePath, pathId, resolved);
+        } else {
+            data = TakePrefetchedST(absolutePath, pathId, resolved);
+        }
+        if (!data) {
+            return nullptr;
+        }
+
+        // Reservation moves to file and is released once it is destroyed
+        HFile file(new SharedBufferFile(resolved.RealPath, eastl::move(data), resolved.FileSystem->SharedStats()));
+        file->Open(IFile::FileMode::Read);
+        return file;
+    }
+
+    inline HSharedBuffer TakePrefetchedST(eastl::string_view absolutePath, uint64_t pathId, const ResolvedPath& resolved)
+    {
+        auto it = m_Prefetched.find_as(absolutePath, StringKnownHash(pathId), StringEqual());
+        if (it == m_Prefetched.end()) {
+            return nullptr;
+        }
+
+        PrefetchedFile prefetched = eastl::move(it->second);
+        m_Prefetched.erase(it);
+        m_PrefetchHeldBytes -= prefetched.Data->size();
+        m_NumPrefetched.store(m_Prefetched.size(), std::memory_order_relaxed);
+
+        // Order records of taken files are skipped lazily, keep them from piling up
+        if (m_PrefetchOrder.size() > 2 * m_Prefetched.size() + 16) {
+            CompactPrefetchOrderST();
+        }
+
+        if (prefetched.FileSystem != resolved.FileSystem || !(prefetched.RealPath == resolved.RealPath)) {
+            DropPrefetchedST(prefetched);
+            return nullptr;
+        }
+
+        m_PrefetchUsedBytes.fetch_add(prefetched.Data->size(), std::memory_order_relaxed);
+        return eastl::move(prefetched.Data);
+    }
+
+    inline void ClearPrefetchedST()
+    {
+        for (const auto& it : m_Prefetched) {
+            DropPrefetchedST(it.second);
+        }
+        m_Prefetched.clear();
+        m_PrefetchOrder.clear();
+        m_PrefetchHeldBytes = 0;
+        m_NumPrefetched.store(0, std::memory_order_relaxed);
+    }
+
+    inline void TrimPrefetchedST()
+    {
+        uint64_t capacity = m_PrefetchCapacity.load(std::memory_order_relaxed);
+        while (m_PrefetchHeldBytes > capacity && !m_PrefetchOrder.empty()) {
+            auto record = eastl::move(m_PrefetchOrder.front());
+            m_PrefetchOrder.pop_front();
+
+            auto it = m_Prefetched.find(record.first);
+            if (it == m_Prefetched.end() || it->second.Sequence != record.second) {
+                continue;
+            }
+
+            m_PrefetchHeldBytes -= it->second.Data->size();
+            DropPrefetchedST(it->second);
+            m_Prefetched.erase(it);
+        }
+        m_NumPrefetched.store(m_Prefetched.size(), std::memory_order_relaxed);
+    }
+
+    /*
+     * Drop prefetched file of virtual 'absolutePath', it is about to be written
+     */
+    inline void DropPrefetched(eastl::string_view absolutePath, uint64_t pathId)
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_PrefetchMutex, &m_PrefetchLockStats);
+            DropPrefetchedST(absolutePath, pathId);
+        } else {
+            DropPrefetchedST(absolutePath, pathId);
+        }
+    }
+
+    inline void DropPrefetchedST(eastl::string_view absolutePath, uint64_t pathId)
+    {
+        m_PrefetchInvalidations.fetch_add(1);
+
+        auto it = m_Prefetched.find_as(absolutePath, StringKnownHash(pathId), StringEqual());
+        if (it != m_Prefetched.end()) {
+            m_PrefetchHeldBytes -= it->second.Data->size();
+            DropPrefetchedST(it->second);
+            m_Prefetched.erase(it);
+            m_NumPrefetched.store(m_Prefetched.size(), std::memory_order_relaxed);
+        }
+    }
+
+    /*
+     * Drop prefetched files read from 'fs' on its file event, Reset drops all of them
+     */
+    inline void DropPrefetchedOf(const IFileSystem& fs, const FileInfo& fileInfo, IFileSystem::FileEvent event)
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_PrefetchMutex, &m_PrefetchLockStats);
+            DropPrefetchedOfST(fs, fileInfo, event);
+        } else {
+            DropPrefetchedOfST(fs, fileInfo, event);
+        }
+    }
+
+    inline void DropPrefetchedOfST(const IFileSystem& fs, const FileInfo& fileInfo, IFileSystem::FileEvent event)
+    {
+        m_PrefetchInvalidations.fetch_add(1);
+
+        for (auto it = m_Prefetched.begin(); it != m_Prefetched.end();) {
+            const PrefetchedFile& prefetched = it->second;
+            if (prefetched.FileSystem.get() == &fs && (event == IFileSystem::FileEvent::Reset || prefetched.RealPath.AbsolutePath() == fileInfo.AbsolutePath())) {
+                m_PrefetchHeldBytes -= prefetched.Data->size();
+                DropPrefetchedST(prefetched);
+                it = m_Prefetched.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        // Order records of dropped files are skipped lazily like taken ones
+        if (m_PrefetchOrder.size() > 2 * m_Prefetched.size() + 16) {
+            CompactPrefetchOrderST();
+        }
+        m_NumPrefetched.store(m_Prefetched.size(), std::memory_order_relaxed);
+    }
+
+    /*
+     * Count data of prefetched file that nobody opened as wasted and release its reservation
+     */
+    inline void DropPrefetchedST(const PrefetchedFile& prefetched)
+    {
+        uint64_t size = prefetched.Data->size();
+        m_PrefetchWastedBytes.fetch_add(size, std::memory_order_relaxed);
+        prefetched.FileSystem->SharedStats()->ReleaseFileData(size);
+    }
+
+    /*
+     * Drop oldest prefetched files of filesystems charged to 'budget' until 'excess' bytes are
+     * freed. Returns number of bytes freed
+     */
+    inline uint64_t EvictPrefetched(const HMemoryBudget& budget, uint64_t excess)
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_PrefetchMutex, &m_PrefetchLockStats);
+            return EvictPrefetchedST(budget, excess);
+        } else {
+            return EvictPrefetchedST(budget, excess);
+        }
+    }
+
+    inline uint64_t EvictPrefetchedST(const HMemoryBudget& budget, uint64_t excess)
+    {
+        uint64_t freed = 0;
+        for (auto record = m_PrefetchOrder.begin(); record != m_PrefetchOrder.end() && freed < excess; ++record) {
+            auto it = m_Prefetched.find(record->first);
+            if (it == m_Prefetched.end() || it->second.Sequence != record->second) {
+                continue;
+            }
+            if (it->second.FileSystem->GetMemoryBudget() != budget) {
+                continue;
+            }
+
+            uint64_t size = it->second.Data->size();
+            m_PrefetchHeldBytes -= size;
+            freed += size;
+            DropPrefetchedST(it->second);
+            m_Prefetched.erase(it);
+        }
+
+        // Order records of dropped files are skipped lazily like taken ones
+        if (m_PrefetchOrder.size() > 2 * m_Prefetched.size() + 16) {
+            CompactPrefetchOrderST();
+        }
+        m_NumPrefetched.store(m_Prefetched.size(), std::memory_order_relaxed);
+        return freed;
+    }
+
+    /*
+     * Drop data cached by layers of 'alias' that are charged to 'budget' until 'excess' bytes are
+     * freed. Layers come from current mount table, mount lock is not taken. Returns number of bytes freed
+     */
+    inline uint64_t ReleaseMountMemory(const HMemoryBudget& budget, const eastl::string& alias, uint64_t excess)
+    {
+        TMountTableGuard table = m_MountTable.Acquire();
+        auto it = table->FileSystems.find(alias);
+        if (it == table->FileSystems.end()) {
+            return 0;
+        }
+
+        uint64_t freed = 0;
+        for (const HFileSystem& fs : it->second) {
+            if (freed >= excess) {
+                break;
+            }
+            if (fs->GetMemoryBudget() == budget) {
+                freed += fs->ReleaseMemory(excess - freed);
+            }
+        }
+        return freed;
+    }
+
+    /*
+     * Memory limit of one alias and layers it is attached to
+     */
+    struct MountBudget
+    {
+        HMemoryBudget Budget;
+        TFileSystemList Layers;
+    };
+
+    /*
+     * Attach budget to current layers of 'alias' and start it from data they already hold
+     */
+    inline void AttachMountBudgetST(const MountTable& table, const eastl::string& alias, MountBudget& mountBudget)
+    {
+        mountBudget.Layers.clear();
+        auto it = table.FileSystems.find(alias);
+        if (it != table.FileSystems.end()) {
+            mountBudget.Layers = it->second;
+        }
+
+        uint64_t usedBytes = 0;
+        for (const HFileSystem& fs : mountBudget.Layers) {
+            fs->SetMemoryBudget(mountBudget.Budget);
+            usedBytes += fs->GetStats().FileDataBytes;
+        }
+        mountBudget.Budget->SetUsedBytes(usedBytes);
+    }
+
+    inline void DetachMountBudgetST(const MountBudget& mountBudget)
+    {
+        for (const HFileSystem& fs : mountBudget.Layers) {
+            // Layer may have been attached to budget of another alias since
+            if (fs->GetMemoryBudget() == mountBudget.Budget) {
+                fs->SetMemoryBudget(nullptr);
+            }
+        }
+    }
+
+    inline void CompactPrefetchOrderST()
+    {
+        m_PrefetchOrder.erase(eastl::remove_if(m_PrefetchOrder.begin(), m_PrefetchOrder.end(), [this](const auto& record) {
+            auto it = m_Prefetched.find(record.first);
+            return it == m_Prefetched.end() || it->second.Sequence != record.second;
+        }), m_PrefetchOrder.end());
+    }
+
+    /*
+     * Requests owned by one filesystem, rewritten to real paths
+     */
+    struct BatchGroup
+    {
+        HFileSystem FileSystem;
+        eastl::vector<BatchReadRequest> Requests;
+        eastl::vector<BatchReadRequest*> Callers;
+    };
+
+    inline size_t ReadFilesST(const MountTable& table, uint64_t generation, eastl::vector<BatchReadRequest>& requests)
+    {
+        eastl::vector<BatchGroup> groups;
+        for (BatchReadRequest& request : requests) {
+            request.BytesRead = 0;
+            request.IsSucceeded = false;
+
+            const eastl::string& absolutePath = request.FilePath.AbsolutePath();
+
+            TAliasTrie::TMatchList matches;
+            table.AliasTrie.FindMatches(absolutePath, matches);
+
+            HResolvedPath resolved;
+            if (!ResolveST(generation, absolutePath, request.FilePath.PathId(), matches, resolved)) {
+                continue;
+            }
+
+            auto group = eastl::find_if(groups.begin(), groups.end(), [&](const BatchGroup& g) {
+                return g.FileSystem == resolved->FileSystem;
+            });
+            if (group == groups.end()) {
+                groups.push_back(BatchGroup());
+                group = groups.end() - 1;
+                group->FileSystem = resolved->FileSystem;
+            }
+
+            group->Requests.push_back(BatchReadRequest(resolved->RealPath, request.Buffer, request.BufferSize));
+            group->Callers.push_back(&request);
+        }
+
+        size_t numRead = 0;
+        eastl::vector<BatchReadRequest*> batch;
+        for (BatchGroup& group : groups) {
+            batch.clear();
+            for (BatchReadRequest& request : group.Requests) {
+                batch.push_back(&request);
+            }
+
+            group.FileSystem->ReadFiles(batch);
+
+            for (size_t i = 0; i < group.Requests.size(); ++i) {
+                group.Callers[i]->BytesRead = group.Requests[i].BytesRead;
+                group.Callers[i]->IsSucceeded = group.Requests[i].IsSucceeded;
+                numRead += group.Requests[i].IsSucceeded ? 1 : 0;
+            }
+        }
+
+        return numRead;
+    }
+
+    inline eastl::string AbsolutePathST(const MountTable& table, uint64_t generation, eastl::string_view relativePath)
+    {
+        eastl::string absolutePath(relativePath.data(), relativePath.length());
+
+        TAliasTrie::TMatchList matches;
+        table.AliasTrie.FindMatches(absolutePath, matches);
+
+        HResolvedPath resolved;
+        bool isFound = ResolveST(generation, absolutePath, StringUtils::Hash(absolutePath), matches, resolved);
+
+        // Path lands in the main filesystem of the first alias unless a layer already owns it
+        for (size_t i = 0; i < matches.size(); ++i) {
+            const TFileSystemList& filesystems = *matches[i].Value->FileSystems;
+            if (filesystems.empty()) {
+                continue;
+            }
+
+            if (isFound && i == resolved->AliasIndex) {
+                return resolved->RealPath.AbsolutePath();
+            }
+
+            const HFileSystem& fs = filesystems.front();
+            eastl::string strippedRelativePath(matches[i].RelativePath.data(), matches[i].RelativePath.length());
+            return FileInfo(fs->BasePath(), strippedRelativePath, false).AbsolutePath();
+        }
+
+        return "";
+    }
+
+    /*
+     * Find newest layer that contains 'absolutePath'. Returns false if no layer has it.
+     * 'pathId' is StringHash of 'absolutePath' and is reused for cache lookup
+     */
+    inline bool ResolveST(uint64_t generation, eastl::string_view absolutePath, uint64_t pathId, const TAliasTrie::TMatchList& matches, HResolvedPath& outResolved) const
+    {
+        TraceScope traceScope("vfs", "ResolvePath", absolutePath);
+
+        // Shard is picked by high bits, low bits select bucket inside shard
+        ResolveCacheShard& shard = m_ResolveCache[(pathId >> 32) % k_ResolveCacheShards];
+
+        bool isCached = false;
+        auto lookup = [&]() {
+            auto it = shard.Entries.find_as(absolutePath, StringKnownHash(pathId), StringEqual());
+            if (it != shard.Entries.end()) {
+                outResolved = it->second;
+                isCached = true;
+            }
+        };
+
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(shard.Mutex, &m_ResolveCacheLockStats);
+            lookup();
+        } else {
+            lookup();
+        }
+
+        if (isCached) {
+            m_ResolveCacheHits.fetch_add(1, std::memory_order_relaxed);
+            return outResolved->FileSystem != nullptr;
+        }
+        m_ResolveCacheMisses.fetch_add(1, std::memory_order_relaxed);
+
+        // Merged index gives the newest layer that has the file with a single lookup per alias
+        eastl::shared_ptr<ResolvedPath> resolved = eastl::make_shared<ResolvedPath>();
+        for (size_t i = 0; i < matches.size(); ++i) {
+            HFileSystem fs = matches[i].Value->Overlay->Find(matches[i].RelativePath);
+            if (fs) {
+                eastl::string relativePath(matches[i].RelativePath.data(), matches[i].RelativePath.length());
+                resolved->FileSystem = fs;
+                resolved->RealPath = FileInfo(fs->BasePath(), relativePath, false);
+                resolved->AliasIndex = i;
+                break;
+            }
+        }
+        outResolved = resolved;
+
+        // Mounts or file lists may have changed while probing, in that case result is not cached
+        auto store = [&]() {
+            if (generation != m_ResolveGeneration.load()) {
+                return;
+            }
+            if (shard.Entries.size() >= m_ResolveCacheCapacity.load(std::memory_order_relaxed) / k_ResolveCacheShards) {
+                shard.Entries.clear();
+            }
+            shard.Entries[eastl::string(absolutePath.data(), absolutePath.length())] = outResolved;
+        };
+
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(shard.Mutex, &m_ResolveCacheLockStats);
+            store();
+        } else {
+            store();
+        }
+
+        return outResolved->FileSystem != nullptr;
+    }
+
+    /*
+     * Copy current mount table, let 'fn' modify it and publish result if 'fn' returns true.
+     * Must be called with writer mutex held
+     */
+    template<typename TFunc>
+    inline void UpdateMountTableST(TFunc fn)
+    {
+        eastl::unique_ptr<MountTable> next = eastl::make_unique<MountTable>();
+        {
+            TMountTableGuard current = m_MountTable.Acquire();
+            next->FileSystems = current->FileSystems;
+            next->Overlays = current->Overlays;
+            next->MountStats = current->MountStats;
+        }
+
+        if (!fn(next->FileSystems)) {
+            return;
+        }
+
+        // Bring merged indexes in line with new layer lists, only changed layers are reindexed
+        for (auto it = next->Overlays.begin(); it != next->Overlays.end();) {
+            if (next->FileSystems.find(it->first) == next->FileSystems.end()) {
+                it = next->Overlays.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (auto it = next->MountStats.begin(); it != next->MountStats.end();) {
+            if (next->FileSystems.find(it->first) == next->FileSystems.end()) {
+                it = next->MountStats.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        for (const auto& it : next->FileSystems) {
+            HOverlayIndex& overlay = next->Overlays[it.first];
+            if (!overlay) {
+                overlay = eastl::make_shared<OverlayIndex>();
+            }
+            overlay->SetLayers(it.second);
+
+            HFileSystemStats& stats = next->MountStats[it.first];
+            if (!stats) {
+                stats = FileSystemStats::Create();
+            }
+
+            MountPoint mountPoint;
+            mountPoint.FileSystems = &it.second;
+            mountPoint.Overlay = overlay.get();
+            mountPoint.Stats = stats.get();
+            next->AliasTrie.Insert(it.first, mountPoint);
+        }
+
+        m_MountTable.Publish(eastl::move(next));
+        InvalidateResolveCache();
+
+        // Budgets follow layers of their alias
+        if (!m_MountBudgets.empty()) {
+            TMountTableGuard table = m_MountTable.Acquire();
+            for (auto& it : m_MountBudgets) {
+                DetachMountBudgetST(it.second);
+                AttachMountBudgetST(*table, it.first, it.second);
+            }
+        }
+    }
+
+    /*
+     * Listen for file creation/removal on mounted filesystem, once per filesystem
+     */
+    inline void SubscribeST(const HFileSystem& filesystem)
+    {
+        auto it = m_Listeners.find(filesystem);
+        if (it != m_Listeners.end()) {
+            ++it->second.second;
+            return;
+        }
+
+        uint32_t listenerId = filesystem->AddListener([this](const IFileSystem& fs, const FileInfo& fileInfo, IFileSystem::FileEvent event) {
+            {
+                TMountTableGuard table = m_MountTable.Acquire();
+                for (const auto& it : table->Overlays) {
+                    it.second->OnFileEvent(fs, fileInfo, event);
+                }
+            }
+            DropPrefetchedOf(fs, fileInfo, event);
+            InvalidateResolveCache();
+        });
+        m_Listeners[filesystem] = eastl::make_pair(listenerId, 1u);
+    }
+
+    inline void UnsubscribeST(const HFileSystem& filesystem)
+    {
+        auto it = m_Listeners.find(filesystem);
+        if (it == m_Listeners.end()) {
+            return;
+        }
+
+        if (--it->second.second == 0) {
+            filesystem->RemoveListener(it->second.first);
+            m_Listeners.erase(it);
+        }
+    }
+
+private:
+    Snapshot<MountTable> m_MountTable;
+    // Serializes writers, readers never take it
+    mutable std::mutex m_Mutex;
+    mutable LockWaitStats m_MountLockStats;
+
+    // Listener id and mount count per subscribed filesystem
+    eastl::unordered_map<HFileSystem, eastl::pair<uint32_t, uint32_t>> m_Listeners;
+    // Memory limits by alias, guarded by writer mutex
+    eastl::unordered_map<eastl::string, MountBudget> m_MountBudgets;
+
+    mutable ResolveCacheShard m_ResolveCache[k_ResolveCacheShards];
+    std::atomic<size_t> m_ResolveCacheCapacity = 16384;
+    std::atomic<uint64_t> m_ResolveGeneration = 0;
+    mutable std::atomic<uint64_t> m_ResolveCacheHits = 0;
+    mutable std::atomic<uint64_t> m_ResolveCacheMisses = 0;
+    std::atomic<uint64_t> m_ResolveCacheInvalidations = 0;
+    mutable LockWaitStats m_ResolveCacheLockStats;
+
+    HExecutor m_Executor;
+    std::mutex m_ExecutorMutex;
+
+    HAccessTrace m_AccessTrace;
+    mutable std::mutex m_AccessTraceMutex;
+    // Lets OpenFile skip trace lookup while not recording
+    std::atomic<bool> m_IsTracing = false;
+
+    // Prefetched files by virtual path and their insertion order for eviction
+    eastl::unordered_map<eastl::string, PrefetchedFile, StringHash, StringEqual> m_Prefetched;
+    eastl::deque<eastl::pair<eastl::string, uint64_t>> m_PrefetchOrder;
+    uint64_t m_PrefetchHeldBytes = 0;
+    uint64_t m_PrefetchSequence = 0;
+    mutable std::mutex m_PrefetchMutex;
+    mutable LockWaitStats m_PrefetchLockStats;
+    // Lets OpenFile skip prefetch lookup while nothing is prefetched
+    std::atomic<size_t> m_NumPrefetched = 0;
+    // Bumped whenever prefetched data may have become stale
+    std::atomic<uint64_t> m_PrefetchInvalidations = 0;
+    std::atomic<uint64_t> m_PrefetchCapacity = 64 * 1024 * 1024;
+    std::atomic<uint64_t> m_PrefetchedBytes = 0;
+    std::atomic<uint64_t> m_PrefetchUsedBytes = 0;
+    std::atomic<uint64_t> m_PrefetchWastedBytes = 0;
+};
+
 }; // namespace vfspp
 
 #endif // VIRTUALFILESYSTEM_HPP
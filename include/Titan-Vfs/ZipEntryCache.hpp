@@ -0,0 +1,222 @@
+#ifndef ZIPENTRYCACHE_HPP
+#define ZIPENTRYCACHE_HPP
+
+#include "Global.h"
+#include "SharedBufferFile.hpp"
+
+namespace Titan::Vfs
+{
+
+using HZipEntryCache = eastl::shared_ptr<class ZipEntryCache>;
+
+/*
+ * Inflated entries of one archive kept after their files are closed, least recently used
+ * entries are dropped first once held bytes exceed capacity. Buffers are shared, so a file
+ * that is open keeps its data alive even after the cache dropped it
+ */
+class ZipEntryCache final
+{
+public:
+    struct Stats
+    {
+        uint64_t Hits = 0;
+        uint64_t Misses = 0;
+        uint64_t Insertions = 0;
+        uint64_t Evictions = 0;
+        uint64_t EvictedBytes = 0;
+        uint64_t HeldBytes = 0;
+        uint64_t Entries = 0;
+        uint64_t Capacity = 0;
+    };
+
+public:
+    ZipEntryCache(uint64_t capacity)
+        : m_Capacity(capacity)
+    {
+    }
+
+    ZipEntryCache(const ZipEntryCache&) = delete;
+    ZipEntryCache& operator=(const ZipEntryCache&) = delete;
+
+    /*
+     * Data of entry 'entryID' if cached. Lookups are skipped and not counted while capacity is zero
+     */
+    HSharedBuffer Find(uint32_t entryID)
+    {
+        if (m_Capacity.load(std::memory_order_relaxed) == 0) {
+            return nullptr;
+        }
+
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return FindST(entryID);
+        } else {
+            return FindST(entryID);
+        }
+    }
+
+    /*
+     * Keep 'data' of entry 'entryID', entries larger than capacity are not kept
+     */
+    void Insert(uint32_t entryID, const HSharedBuffer& data)
+    {
+        if (!data || data->size() > m_Capacity.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            InsertST(entryID, data);
+        } else {
+            InsertST(entryID, data);
+        }
+    }
+
+    /*
+     * Limit bytes held by cache, zero disables it and drops all entries
+     */
+    void SetCapacity(uint64_t capacity)
+    {
+        m_Capacity.store(capacity, std::memory_order_relaxed);
+
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            TrimST();
+        } else {
+            TrimST();
+        }
+    }
+
+    /*
+     * Drop least recently used entries that no open file holds until 'bytes' are freed.
+     * Returns number of bytes freed
+     */
+    uint64_t FreeBytes(uint64_t bytes)
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return FreeBytesST(bytes);
+        } else {
+            return FreeBytesST(bytes);
+        }
+    }
+
+    void Clear()
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            ClearST();
+        } else {
+            ClearST();
+        }
+    }
+
+    Stats GetStats() const
+    {
+        if constexpr (g_MtSupportEnabled) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return GetStatsST();
+        } else {
+            return GetStatsST();
+        }
+    }
+
+private:
+    typedef eastl::list<eastl::pair<uint32_t, HSharedBuffer>> TEntryList;
+
+    inline HSharedBuffer FindST(uint32_t entryID)
+    {
+        auto it = m_Entries.find(entryID);
+        if (it == m_Entries.end()) {
+            ++m_Stats.Misses;
+            return nullptr;
+        }
+
+        // Move to front, most recently used entries are kept longest
+        m_Order.splice(m_Order.begin(), m_Order, it->second);
+        ++m_Stats.Hits;
+        return it->second->second;
+    }
+
+    inline void InsertST(uint32_t entryID, const HSharedBuffer& data)
+    {
+        auto it = m_Entries.find(entryID);
+        if (it != m_Entries.end()) {
+            m_HeldBytes -= it->second->second->size();
+            m_Order.erase(it->second);
+            m_Entries.erase(it);
+        }
+
+        m_Order.push_front(eastl::make_pair(entryID, data));
+        m_Entries[entryID] = m_Order.begin();
+        m_HeldBytes += data->size();
+        ++m_Stats.Insertions;
+
+        TrimST();
+    }
+
+    inline void TrimST()
+    {
+        uint64_t capacity = m_Capacity.load(std::memory_order_relaxed);
+        while (m_HeldBytes > capacity && !m_Order.empty()) {
+            uint64_t size = m_Order.back().second->size();
+            m_Entries.erase(m_Order.back().first);
+            m_Order.pop_back();
+
+            m_HeldBytes -= size;
+            ++m_Stats.Evictions;
+            m_Stats.EvictedBytes += size;
+        }
+    }
+
+    inline uint64_t FreeBytesST(uint64_t bytes)
+    {
+        uint64_t freed = 0;
+        for (auto it = m_Order.end(); it != m_Order.begin() && freed < bytes;) {
+            --it;
+            // Buffer of an open file stays allocated, dropping it would free nothing
+            if (it->second.use_count() > 1) {
+                continue;
+            }
+
+            uint64_t size = it->second->size();
+            m_Entries.erase(it->first);
+            it = m_Order.erase(it);
+
+            m_HeldBytes -= size;
+            freed += size;
+            ++m_Stats.Evictions;
+            m_Stats.EvictedBytes += size;
+        }
+        return freed;
+    }
+
+    inline void ClearST()
+    {
+        m_Entries.clear();
+        m_Order.clear();
+        m_HeldBytes = 0;
+    }
+
+    inline Stats GetStatsST() const
+    {
+        Stats stats = m_Stats;
+        stats.HeldBytes = m_HeldBytes;
+        stats.Entries = m_Entries.size();
+        stats.Capacity = m_Capacity.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    std::atomic<uint64_t> m_Capacity;
+    // Most recently used entry first
+    TEntryList m_Order;
+    eastl::unordered_map<uint32_t, TEntryList::iterator> m_Entries;
+    uint64_t m_HeldBytes = 0;
+    Stats m_Stats;
+    mutable std::mutex m_Mutex;
+};
+
+} // namespace vfspp
+
+#endif // ZIPENTRYCACHE_HPP
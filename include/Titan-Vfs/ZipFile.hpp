@@ -2,6 +2,10 @@
 #define ZIPFILE_HPP
 
 #include "IFile.h"
+#include "ZipFormat.hpp"
+#include "MappedFile.hpp"
+#include "ZipInflateStream.hpp"
+#include "ZipEntryCache.hpp"
 #include "zip_file.hpp"
 
 namespace Titan::Vfs
@@ -11,14 +15,16 @@ using HZipFile = eastl::shared_ptr<class ZipFile>;
 
 class ZipFile final : public IFile
 {
+    friend class ZipFileSystem;
 public:
-    ZipFile(const FileInfo& fileInfo, uint32_t entryID, uint64_t size, eastl::weak_ptr<mz_zip_archive> zipArchive)
+    ZipFile(const FileInfo& fileInfo, uint32_t entryID, uint64_t size, eastl::weak_ptr<mz_zip_archive> zipArchive, const HFileSystemStats& stats = nullptr)
         : m_FileInfo(fileInfo)
         , m_EntryID(entryID)
         , m_Size(size)
         , m_ZipArchive(zipArchive)
         , m_IsOpened(false)
         , m_SeekPos(0)
+        , m_Stats(stats)
     {
     }   
 
@@ -33,7 +39,7 @@ public:
     virtual const FileInfo& GetFileInfo() const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return GetFileInfoST();
         } else {
             return GetFileInfoST();
@@ -46,7 +52,7 @@ public:
     virtual uint64_t Size() override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return SizeST();
         } else {
             return SizeST();
@@ -59,7 +65,7 @@ public:
     virtual bool IsReadOnly() const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return IsReadOnlyST();
         } else {
             return IsReadOnlyST();
@@ -72,7 +78,7 @@ public:
     virtual void Open(FileMode mode) override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             OpenST(mode);
         } else {
             OpenST(mode);
@@ -85,7 +91,7 @@ public:
     virtual void Close() override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             CloseST();
         } else {
             CloseST();
@@ -98,7 +104,7 @@ public:
     virtual bool IsOpened() const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return IsOpenedST();
         } else {
             return IsOpenedST();
@@ -110,8 +116,9 @@ public:
      */
     virtual uint64_t Seek(uint64_t offset, Origin origin) override
     {
+        LatencyTimer latencyTimer(Latency(LatencyOp::Seek));
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return SeekST(offset, origin);
         } else {
             return SeekST(offset, origin);
@@ -123,7 +130,7 @@ public:
     virtual uint64_t Tell() override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return TellST();
         } else {
             return TellST();
@@ -135,8 +142,10 @@ public:
      */
     virtual uint64_t Read(uint8_t* buffer, uint64_t size) override
     {
+        LatencyTimer latencyTimer(Latency(LatencyOp::Read));
+        AllocationScope allocationScope(AllocOp::Read);
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return ReadST(buffer, size);
         } else {
             return ReadST(buffer, size);
@@ -147,8 +156,9 @@ public:
      */
     virtual uint64_t Write(const uint8_t* buffer, uint64_t size) override
     {
+        AllocationScope allocationScope(AllocOp::Write);
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return WriteST(buffer, size);
         } else {
             return WriteST(buffer, size);
@@ -160,8 +170,9 @@ public:
      */
     virtual uint64_t Read(eastl::vector<uint8_t>& buffer, uint64_t size) override
     {
+        LatencyTimer latencyTimer(Latency(LatencyOp::Read));
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return ReadST(buffer, size);
         } else {
             return ReadST(buffer, size);
@@ -174,7 +185,7 @@ public:
     virtual uint64_t Write(const eastl::vector<uint8_t>& buffer) override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return WriteST(buffer);
         } else {
             return WriteST(buffer);
@@ -186,8 +197,9 @@ public:
      */
     virtual uint64_t Read(std::ostream& stream, uint64_t size, uint64_t bufferSize = 1024) override
     {
+        LatencyTimer latencyTimer(Latency(LatencyOp::Read));
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return ReadST(stream, size, bufferSize);
         } else {
             return ReadST(stream, size, bufferSize);
@@ -200,14 +212,38 @@ public:
     virtual uint64_t Write(std::istream& stream, uint64_t size, uint64_t bufferSize = 1024) override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
             return WriteST(stream, size, bufferSize);
         } else {
             return WriteST(stream, size, bufferSize);
         }
     }
+
+    /*
+     * Get entry data without copying. Stored entries of a mapped archive point into mapping,
+     * other entries into data extracted on open
+     */
+    virtual bool GetView(FileView& outView) override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, LockStats());
+            return GetViewST(outView);
+        } else {
+            return GetViewST(outView);
+        }
+    }
     
 private:
+    inline LockWaitStats* LockStats() const
+    {
+        return m_Stats ? &m_Stats->FileLock() : nullptr;
+    }
+
+    inline LatencyHistogram* Latency(LatencyOp op) const
+    {
+        return m_Stats ? &m_Stats->Latency(op) : nullptr;
+    }
+
     inline const FileInfo& GetFileInfoST() const
     {
         return m_FileInfo;
@@ -248,17 +284,173 @@ private:
         }
         
         m_SeekPos = 0;
-        
-        m_Data.resize(m_Size);
-        m_IsOpened = mz_zip_reader_extract_to_mem_no_alloc(zipArchive.get(), m_EntryID, m_Data.data(), static_cast<size_t>(m_Size), 0, 0, 0);
+
+        // Stored entry of a mapped archive is served from mapping, no heap and no copy
+        if (m_IsViewable && OpenViewST()) {
+            m_IsOpened = true;
+            return;
+        }
+
+        // Large entries are inflated as they are read, only window and input chunk are held
+        if (m_IsStreamed && OpenStreamST()) {
+            m_IsOpened = true;
+            return;
+        }
+
+        // Entry inflated earlier by any file of this archive is shared
+        HZipEntryCache cache = m_Cache.lock();
+        if (cache) {
+            m_Data = cache->Find(m_EntryID);
+        }
+
+        if (!m_Data) {
+            m_Data = ExtractST(zipArchive.get());
+            if (!m_Data) {
+                return;
+            }
+            if (cache) {
+                cache->Insert(m_EntryID, m_Data);
+            }
+        }
+        m_IsOpened = true;
+    }
+
+    /*
+     * Inflate whole entry into a new buffer. Buffer is charged to filesystem until its last
+     * holder, this file or entry cache, releases it
+     */
+    inline HSharedBuffer ExtractST(mz_zip_archive* zipArchive)
+    {
+        // Hard memory limit of mount may refuse it
+        if (m_Stats && !m_Stats->ReserveFileData(m_Size)) {
+            return nullptr;
+        }
+
+        HFileSystemStats stats = m_Stats;
+        eastl::vector<uint8_t>* data = new eastl::vector<uint8_t>(static_cast<size_t>(m_Size));
+        HSharedBuffer buffer(data, [stats](const eastl::vector<uint8_t>* data) {
+            if (stats) {
+                stats->ReleaseFileData(data->size());
+            }
+            delete data;
+        });
+
+        TraceScope traceScope("zip", "Inflate", GetFileInfoST().AbsolutePath());
+        if (!mz_zip_reader_extract_to_mem_no_alloc(zipArchive, m_EntryID, data->data(), static_cast<size_t>(m_Size), 0, 0, 0)) {
+            return nullptr;
+        }
+        if (m_IsCompressed && m_Stats) {
+            m_Stats->AddBytesDecompressed(m_Size);
+        }
+        return buffer;
     }
     
     inline void CloseST()
     {
         m_IsOpened = false;
         m_SeekPos = 0;
+        m_View = nullptr;
+        m_OpenMapping = nullptr;
+        if (m_Stream) {
+            if (m_Stats) {
+                m_Stats->ReleaseFileData(m_Stream->MemoryBytes());
+            }
+            m_Stream = nullptr;
+        }
+
+        FreeDataST();
+    }
 
-        m_Data.clear();
+    inline bool OpenStreamST()
+    {
+        HZipInflateStream stream = eastl::make_unique<ZipInflateStream>(m_StreamChunkSize);
+        if (!stream->Open(m_Mapping.lock(), m_ArchivePath ? *m_ArchivePath : eastl::string(), m_LocalHeaderOffset, m_CompressedSize, m_Size, m_Crc32, m_IsCompressed)) {
+            return false;
+        }
+
+        if (m_Stats && !m_Stats->ReserveFileData(stream->MemoryBytes())) {
+            return false;
+        }
+
+        m_Stream = eastl::move(stream);
+        return true;
+    }
+
+    /*
+     * Read from stream at seek position. Seeking forward inflates and skips data in between,
+     * seeking backward inflates entry again from its beginning
+     */
+    inline uint64_t ReadStreamST(uint8_t* buffer, uint64_t size)
+    {
+        TraceScope traceScope("zip", "Inflate", GetFileInfoST().AbsolutePath());
+
+        uint64_t produced = 0;
+        if (m_Stream->Tell() != m_SeekPos) {
+            if (m_SeekPos < m_Stream->Tell()) {
+                m_Stream->Rewind();
+            }
+            produced += m_Stream->Read(nullptr, m_SeekPos - m_Stream->Tell());
+        }
+
+        uint64_t bytesRead = m_Stream->Tell() == m_SeekPos ? m_Stream->Read(buffer, size) : 0;
+        produced += bytesRead;
+        m_SeekPos += bytesRead;
+
+        if (m_Stats) {
+            m_Stats->AddBytesRead(bytesRead);
+            if (m_IsCompressed) {
+                m_Stats->AddBytesDecompressed(produced);
+            }
+        }
+        return bytesRead;
+    }
+
+    /*
+     * Point view at entry data inside mapping. Returns false if mapping is gone or local header
+     * doesn't match central directory, then entry is extracted by miniz
+     */
+    inline bool OpenViewST()
+    {
+        HMappedFile mapping = m_Mapping.lock();
+        if (!mapping || m_LocalHeaderOffset >= mapping->Size()) {
+            return false;
+        }
+
+        const uint8_t* header = mapping->Data() + m_LocalHeaderOffset;
+        uint64_t available = mapping->Size() - m_LocalHeaderOffset;
+        uint64_t dataOffset = ZipFormat::LocalDataOffset(header, available);
+        if (dataOffset == 0 || dataOffset + m_Size > available) {
+            return false;
+        }
+
+        m_View = header + dataOffset;
+        m_OpenMapping = eastl::move(mapping);
+        return true;
+    }
+
+    inline bool GetViewST(FileView& outView) const
+    {
+        // Streamed entry is never whole in memory
+        if (!IsOpenedST() || m_Stream) {
+            return false;
+        }
+
+        // File object is shared by all openers of entry, view holds its own reference to data
+        if (m_View) {
+            outView.Data = m_View;
+            outView.Owner = m_OpenMapping;
+        } else {
+            outView.Data = m_Data->data();
+            outView.Owner = m_Data;
+        }
+        outView.Size = m_Size;
+        return true;
+    }
+
+    inline void FreeDataST()
+    {
+        // Released by buffer itself once entry cache doesn't hold it either
+        m_Data = nullptr;
     }
     
     inline bool IsOpenedST() const
@@ -297,8 +489,16 @@ private:
         
         uint64_t leftSize = SizeST() - TellST();
         uint64_t maxSize = eastl::min(size, leftSize);
+        if (maxSize > 0 && m_Stream) {
+            return ReadStreamST(buffer, maxSize);
+        }
         if (maxSize > 0) {
-            memcpy(buffer, m_Data.data(), static_cast<size_t>(maxSize));
+            const uint8_t* data = m_View ? m_View : m_Data->data();
+            memcpy(buffer, data + m_SeekPos, static_cast<size_t>(maxSize));
+            m_SeekPos += maxSize;
+            if (m_Stats) {
+                m_Stats->AddBytesRead(maxSize);
+            }
             return maxSize;
         }
 
@@ -373,9 +573,28 @@ private:
     uint32_t m_EntryID;
     uint64_t m_Size;
     eastl::weak_ptr<mz_zip_archive> m_ZipArchive;
-    eastl::vector<uint8_t> m_Data;
+    HSharedBuffer m_Data;
     bool m_IsOpened;
+    // Stored entries are only copied on extraction, set by ZipFileSystem
+    bool m_IsCompressed = true;
+    // Stored and unencrypted entry of a mapped archive, set by ZipFileSystem
+    bool m_IsViewable = false;
+    uint64_t m_LocalHeaderOffset = 0;
+    eastl::weak_ptr<MappedFile> m_Mapping;
+    // Mapping is held while view into it is open
+    HMappedFile m_OpenMapping;
+    const uint8_t* m_View = nullptr;
+    // Entry large enough to be inflated while reading, set by ZipFileSystem
+    bool m_IsStreamed = false;
+    uint64_t m_CompressedSize = 0;
+    uint32_t m_Crc32 = 0;
+    uint64_t m_StreamChunkSize = 0;
+    eastl::shared_ptr<const eastl::string> m_ArchivePath;
+    HZipInflateStream m_Stream;
+    // Inflated entries shared by files of archive, set by ZipFileSystem
+    eastl::weak_ptr<ZipEntryCache> m_Cache;
     uint64_t m_SeekPos;
+    HFileSystemStats m_Stats;
     mutable std::mutex m_Mutex;
 };
     
@@ -5,8 +5,12 @@
 #include "Global.h"
 #include "StringUtils.hpp"
 #include "ZipFile.hpp"
+#include "ZipFormat.hpp"
+#include "MappedFile.hpp"
 #include "zip_file.hpp"
 
+#include <thread>
+
 namespace fs = std::filesystem;
 
 namespace Titan::Vfs
@@ -16,22 +20,54 @@ using HZipFileSystem = eastl::shared_ptr<class ZipFileSystem>;
 
 class ZipFileSystem final : public IFileSystem
 {
-    ZipFileSystem(const eastl::string& zipPath)
+public:
+    /*
+     * How archive is accessed
+     */
+    struct Options
+    {
+        // Map whole archive and let miniz parse and inflate straight from mapping
+        bool IsMapped = false;
+        // Larger archives are read through stdio even if mapping is requested
+        uint64_t MaxMappedSize = sizeof(void*) >= 8 ? (uint64_t(1) << 40) : (uint64_t(512) << 20);
+        // Entries of at least this size are inflated in chunks as they are read instead of whole on open, 0 disables
+        uint64_t StreamingMinSize = 0;
+        // Compressed input read at once by a streamed entry of an archive that is not mapped
+        uint64_t StreamingChunkSize = 64 * 1024;
+        // Bytes of inflated entries kept after their files are closed, 0 disables entry cache
+        uint64_t EntryCacheCapacity = 0;
+        // Index central directory into a compact table on Initialize, file objects are created on first open.
+        // miniz reads no zip64 records, so an archive holds at most 65535 entries
+        bool IsFastMount = false;
+        // Threads parsing central directory of large archives on fast mount, 0 uses all cores
+        uint32_t MountThreads = 0;
+    };
+
+private:
+    ZipFileSystem(const eastl::string& zipPath, const Options& options)
        : m_ZipPath(zipPath)
+       , m_Options(options)
+       , m_EntryCache(eastl::make_shared<ZipEntryCache>(options.EntryCacheCapacity))
        , m_ZipArchive(nullptr)
        , m_IsInitialized(false)
     {
     }
 public:
+    // Overrides below would hide string lookups of IFileSystem
+    using IFileSystem::OpenFile;
+    using IFileSystem::IsFileExists;
+    using IFileSystem::IsFile;
+    using IFileSystem::IsDir;
+
     ~ZipFileSystem()
     {
         Shutdown();
     }
 
 
-    static HFileSystem Create(const eastl::string& zipPath)
+    static HFileSystem Create(const eastl::string& zipPath, const Options& options = Options())
     {
-        return HFileSystem(new ZipFileSystem(zipPath));
+        return HFileSystem(new ZipFileSystem(zipPath, options));
     }
     
     /*
@@ -39,11 +75,17 @@ public:
      */
     virtual void Initialize() override
     {
+        LatencyTimer latencyTimer(&Stats().Latency(LatencyOp::Initialize));
+        TraceScope traceScope("zip", "Initialize");
+        bool isReset = false;
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
-            InitializeST();
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            isReset = InitializeST();
         } else {
-            InitializeST();
+            isReset = InitializeST();
+        }
+        if (isReset) {
+            NotifyReset();
         }
     }
 
@@ -52,11 +94,15 @@ public:
      */
     virtual void Shutdown() override
     {
+        bool isReset = false;
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
-            ShutdownST();
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            isReset = ShutdownST();
         } else {
-            ShutdownST();
+            isReset = ShutdownST();
+        }
+        if (isReset) {
+            NotifyReset();
         }
     }
     
@@ -67,14 +113,51 @@ public:
     {
         return m_IsInitialized;
     }
+
+    /*
+     * Check if archive is served from a memory mapping
+     */
+    bool IsMapped() const
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return m_Mapping != nullptr;
+        } else {
+            return m_Mapping != nullptr;
+        }
+    }
     
+    /*
+     * Limit bytes of inflated entries kept for later opens, zero disables entry cache
+     */
+    void SetEntryCacheCapacity(uint64_t capacity)
+    {
+        m_EntryCache->SetCapacity(capacity);
+    }
+
+    /*
+     * Drop least recently used cached entries, entry cache has its own lock so filesystem lock is not taken
+     */
+    virtual uint64_t ReleaseMemory(uint64_t bytes) override
+    {
+        return m_EntryCache->FreeBytes(bytes);
+    }
+
+    /*
+     * Get entry cache hit, miss and eviction counters
+     */
+    ZipEntryCache::Stats GetEntryCacheStats() const
+    {
+        return m_EntryCache->GetStats();
+    }
+
     /*
      * Get base path
      */
     virtual const eastl::string& BasePath() const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return BasePathST();
         } else {
             return BasePathST();
@@ -87,12 +170,34 @@ public:
     virtual const TFileList& FileList() const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return FileListST();
         } else {
             return FileListST();
         }
     }
+
+    /*
+     * Visit absolute path of every file, fast mounted archive lists them without creating file objects.
+     * Callback is invoked while filesystem is locked, it must not call back into filesystem
+     */
+    virtual void ForEachFile(const eastl::function<void(eastl::string_view)>& callback) const override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            ForEachFileST(callback);
+        } else {
+            ForEachFileST(callback);
+        }
+    }
+
+    /*
+     * Fast mounted archive is probed by merged indexes, its table answers lookups without file objects
+     */
+    virtual bool IsListedLazily() const override
+    {
+        return m_Options.IsFastMount;
+    }
     
     /*
      * Check is readonly filesystem
@@ -108,8 +213,10 @@ public:
      */
     virtual HFile OpenFile(const FileInfo& filePath, IFile::FileMode mode) override
     {
+        LatencyTimer latencyTimer(&Stats().Latency(LatencyOp::OpenFile));
+        TraceScope traceScope("zip", "OpenFile", filePath.AbsolutePath());
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return OpenFileST(filePath, mode);
         } else {
             return OpenFileST(filePath, mode);
@@ -160,7 +267,7 @@ public:
     virtual bool IsFileExists(const FileInfo& filePath) const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
             return IsFileExistsST(filePath);
         } else {
             return IsFileExistsST(filePath);
@@ -173,10 +280,10 @@ public:
     virtual bool IsFile(const FileInfo& filePath) const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
-            return IFileSystem::IsFile(filePath, m_FileList);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return IsFileST(filePath);
         } else {
-            return IFileSystem::IsFile(filePath, m_FileList);
+            return IsFileST(filePath);
         }
     }
     
@@ -186,51 +293,173 @@ public:
     virtual bool IsDir(const FileInfo& dirPath) const override
     {
         if constexpr (g_MtSupportEnabled) {
-            std::lock_guard<std::mutex> lock(m_Mutex);
-            return IFileSystem::IsDir(dirPath, m_FileList);
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return IsDirST(dirPath);
+        } else {
+            return IsDirST(dirPath);
+        }
+    }
+
+    /*
+     * Get size of existing file without opening it
+     */
+    virtual bool FileSize(const FileInfo& filePath, uint64_t& outSize) override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return FileSizeST(filePath, outSize);
+        } else {
+            return FileSizeST(filePath, outSize);
+        }
+    }
+
+    /*
+     * Open file by absolute path, existing files are found without building FileInfo
+     */
+    virtual HFile OpenFile(eastl::string_view filePath, IFile::FileMode mode) override
+    {
+        LatencyTimer latencyTimer(&Stats().Latency(LatencyOp::OpenFile));
+        TraceScope traceScope("zip", "OpenFile", filePath);
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return OpenFileST(filePath, mode);
+        } else {
+            return OpenFileST(filePath, mode);
+        }
+    }
+
+    /*
+     * Check if file exists on filesystem by absolute path
+     */
+    virtual bool IsFileExists(eastl::string_view filePath) const override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return IsFileExistsST(filePath);
+        } else {
+            return IsFileExistsST(filePath);
+        }
+    }
+
+    /*
+     * Check is file by absolute path
+     */
+    virtual bool IsFile(eastl::string_view filePath) const override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return IsFileST(filePath);
+        } else {
+            return IsFileST(filePath);
+        }
+    }
+
+    /*
+     * Check is dir by absolute path
+     */
+    virtual bool IsDir(eastl::string_view dirPath) const override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return IsDirST(dirPath);
+        } else {
+            return IsDirST(dirPath);
+        }
+    }
+
+    /*
+     * Read entries in archive order. Neighbouring entries are fetched with one
+     * sequential read and extracted from memory
+     */
+    virtual void ReadFiles(const eastl::vector<BatchReadRequest*>& requests) override
+    {
+        // Archive stream is shared by all entries so the whole batch is read under lock
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            ReadFilesST(requests);
+        } else {
+            ReadFilesST(requests);
+        }
+    }
+
+    /*
+     * Approximate heap held by file list
+     */
+    virtual uint64_t IndexBytes() const override
+    {
+        if constexpr (g_MtSupportEnabled) {
+            TimedLockGuard<std::mutex> lock(m_Mutex, &Stats().FileSystemLock());
+            return EstimateIndexBytes(m_FileList, sizeof(ZipFile)) + EntryTableBytesST();
         } else {
-            return IFileSystem::IsDir(dirPath, m_FileList);
+            return EstimateIndexBytes(m_FileList, sizeof(ZipFile)) + EntryTableBytesST();
         }
     }
 
 private:
-    inline void InitializeST()
+    inline bool InitializeST()
     {
         if (m_IsInitialized) {
-            return;
+            return false;
         }
 
         if (!fs::is_regular_file(m_ZipPath.c_str())) {
-            return;
+            return false;
         }
 
         m_ZipArchive = eastl::make_shared<mz_zip_archive>();
 
-        mz_bool status = mz_zip_reader_init_file(m_ZipArchive.get(), m_ZipPath.c_str(), 0);
+        // Archives that can't be mapped are read through stdio
+        if (m_Options.IsMapped) {
+            m_Mapping = MappedFile::Open(m_ZipPath, m_Options.MaxMappedSize);
+        }
+
+        // Entries are looked up through own index, sorting miniz directory by name is wasted work
+        mz_uint32 flags = m_Options.IsFastMount ? MZ_ZIP_FLAG_DO_NOT_SORT_CENTRAL_DIRECTORY : 0;
+        mz_bool status = false;
+        if (m_Mapping) {
+            status = mz_zip_reader_init_mem(m_ZipArchive.get(), m_Mapping->Data(), static_cast<size_t>(m_Mapping->Size()), flags);
+        } else {
+            status = mz_zip_reader_init_file(m_ZipArchive.get(), m_ZipPath.c_str(), flags);
+        }
         if (!status) {
-            return;
+            m_Mapping = nullptr;
+            return false;
         }
 
-        BuildFilelist(m_ZipArchive, m_FileList);
+        // Streamed entries open their own handle to archive
+        m_SharedZipPath = eastl::make_shared<const eastl::string>(m_ZipPath);
+
+        if (m_Options.IsFastMount) {
+            BuildEntryTableST();
+        } else {
+            BuildFilelist(m_ZipArchive, m_FileList);
+        }
         m_IsInitialized = true;
+        return true;
     }
 
-    inline void ShutdownST()
+    inline bool ShutdownST()
     {
+        bool isReset = m_IsInitialized;
         m_ZipPath = "";
         // close all files
         for (auto& file : m_FileList) {
             file.second->Close();
         }
         m_FileList.clear();
+        ClearEntryTableST();
+        m_EntryCache->Clear();
 
-        // close zip archive
+        // close zip archive, mapping is released after reader that points into it
         if (m_ZipArchive) {
             mz_zip_reader_end(m_ZipArchive.get());
             m_ZipArchive = nullptr;
         }
+        m_Mapping = nullptr;
+        m_SharedZipPath = nullptr;
 
         m_IsInitialized = false;
+        return isReset;
     }
     
     inline bool IsInitializedST() const
@@ -246,8 +475,29 @@ private:
 
     inline const TFileList& FileListST() const
     {
+        // Whole list is asked for, remaining file objects of fast mounted archive are created once
+        if (!m_EntrySlots.empty()) {
+            const_cast<ZipFileSystem*>(this)->CreateRemainingFilesST();
+        }
         return m_FileList;
     }
+
+    inline void ForEachFileST(const eastl::function<void(eastl::string_view)>& callback) const
+    {
+        // Table of fast mounted archive has every file, created or not
+        if (!m_EntrySlots.empty()) {
+            for (uint32_t slot : m_EntrySlots) {
+                if (slot != 0) {
+                    callback(EntryPathST(m_EntryTable.Entries[slot - 1]));
+                }
+            }
+            return;
+        }
+
+        for (const auto& file : m_FileList) {
+            callback(eastl::string_view(file.first.data(), file.first.length()));
+        }
+    }
     
     inline HFile OpenFileST(const FileInfo& filePath, IFile::FileMode mode)
     {
@@ -258,20 +508,321 @@ private:
 
         // Note 'IsReadOnly()' is safe to call on any thread
         if (IsReadOnly() && requestWrite) {
+            Stats().AddMiss();
             return nullptr;
         }
 
-        HFile file = FindFile(filePath, m_FileList);
+        HFile file = FindOrCreateFileST(filePath);
         if (file) {
             file->Open(mode);
         }
+
+        if (file && file->IsOpened()) {
+            Stats().AddOpen();
+        } else {
+            Stats().AddMiss();
+        }
         
         return file;
     }
 
-    inline bool IsFileExistsST(const FileInfo& filePath) const
+    inline HFile OpenFileST(eastl::string_view filePath, IFile::FileMode mode)
+    {
+        HFile file = FindOrCreateFileST(filePath);
+        if (!file) {
+            Stats().AddMiss();
+            return nullptr;
+        }
+        return OpenFileST(file->GetFileInfo(), mode);
+    }
+
+    inline bool FileSizeST(const FileInfo& filePath, uint64_t& outSize) const
+    {
+        HFile file = FindFile(filePath, m_FileList);
+        if (file) {
+            // Uncompressed size is known from central directory
+            outSize = static_cast<ZipFile&>(*file).m_Size;
+            return true;
+        }
+
+        const CompactEntry* entry = FindEntryST(filePath);
+        mz_zip_archive_file_stat stat;
+        if (!entry || !mz_zip_reader_file_stat(m_ZipArchive.get(), entry->FileIndex, &stat)) {
+            return false;
+        }
+        outSize = stat.m_uncomp_size;
+        return true;
+    }
+
+    template<typename TPath>
+    inline bool IsFileExistsST(const TPath& filePath) const
+    {
+        return FindFile(filePath, m_FileList) != nullptr || FindEntryST(filePath) != nullptr;
+    }
+
+    /*
+     * Fast mounted entries without file object are answered from central directory, the way NewFile marks them
+     */
+    template<typename TPath>
+    inline bool IsFileST(const TPath& filePath) const
+    {
+        HFile file = FindFile(filePath, m_FileList);
+        if (file) {
+            return !file->GetFileInfo().IsDir();
+        }
+
+        const CompactEntry* entry = FindEntryST(filePath);
+        return entry && !mz_zip_reader_is_file_a_directory(m_ZipArchive.get(), entry->FileIndex);
+    }
+
+    template<typename TPath>
+    inline bool IsDirST(const TPath& dirPath) const
+    {
+        HFile file = FindFile(dirPath, m_FileList);
+        if (file) {
+            return file->GetFileInfo().IsDir();
+        }
+
+        const CompactEntry* entry = FindEntryST(dirPath);
+        return entry && mz_zip_reader_is_file_a_directory(m_ZipArchive.get(), entry->FileIndex);
+    }
+
+    /*
+     * Central directory index of file, file object is not created
+     */
+    template<typename TPath>
+    inline bool FindFileIndexST(const TPath& filePath, mz_uint& outIndex) const
+    {
+        HFile file = FindFile(filePath, m_FileList);
+        if (file) {
+            outIndex = static_cast<ZipFile&>(*file).m_EntryID;
+            return true;
+        }
+
+        const CompactEntry* entry = FindEntryST(filePath);
+        if (!entry) {
+            return false;
+        }
+        outIndex = entry->FileIndex;
+        return true;
+    }
+
+    /*
+     * File object of existing file, fast mounted archive creates it on first lookup
+     */
+    template<typename TPath>
+    inline HFile FindOrCreateFileST(const TPath& filePath)
+    {
+        HFile file = FindFile(filePath, m_FileList);
+        if (file) {
+            return file;
+        }
+
+        const CompactEntry* entry = FindEntryST(filePath);
+        if (!entry) {
+            return nullptr;
+        }
+        return CreateEntryFileST(*entry);
+    }
+
+    /*
+     * Entry of a batch with its central directory record
+     */
+    struct PendingRead
+    {
+        BatchReadRequest* Request = nullptr;
+        mz_zip_archive_file_stat Stat;
+    };
+
+    // Entries that are closer than this are read together with the gap between them
+    static constexpr uint64_t k_BatchMaxGap = 64 * 1024;
+    // Upper bound of one merged read
+    static constexpr uint64_t k_BatchMaxSpan = 8 * 1024 * 1024;
+    // Local header extra field is not known up front, reserve room for a typical one
+    static constexpr uint64_t k_BatchExtraReserve = 256;
+
+    inline void ReadFilesST(const eastl::vector<BatchReadRequest*>& requests)
+    {
+        if (!m_ZipArchive) {
+            return;
+        }
+
+        eastl::vector<PendingRead> pendingReads;
+        pendingReads.reserve(requests.size());
+        for (BatchReadRequest* request : requests) {
+            mz_uint fileIndex = 0;
+            if (!FindFileIndexST(request->FilePath, fileIndex)) {
+                Stats().AddMiss();
+                continue;
+            }
+
+            PendingRead pendingRead;
+            pendingRead.Request = request;
+            if (mz_zip_reader_file_stat(m_ZipArchive.get(), fileIndex, &pendingRead.Stat)) {
+                pendingReads.push_back(pendingRead);
+            } else {
+                Stats().AddMiss();
+            }
+        }
+
+        eastl::sort(pendingReads.begin(), pendingReads.end(), [](const PendingRead& a, const PendingRead& b) {
+            return a.Stat.m_local_header_ofs < b.Stat.m_local_header_ofs;
+        });
+
+        eastl::vector<uint8_t> span;
+        eastl::vector<uint8_t> scratch;
+        for (size_t first = 0; first < pendingReads.size();) {
+            uint64_t spanBegin = pendingReads[first].Stat.m_local_header_ofs;
+            uint64_t spanEnd = EstimateEntryEnd(pendingReads[first].Stat);
+
+            // Large entries gain nothing from merging and are extracted on their own
+            if (spanEnd - spanBegin > k_BatchMaxSpan) {
+                ExtractEntryST(pendingReads[first++], scratch);
+                continue;
+            }
+
+            size_t last = first + 1;
+            for (; last < pendingReads.size(); ++last) {
+                const mz_zip_archive_file_stat& stat = pendingReads[last].Stat;
+                uint64_t entryEnd = EstimateEntryEnd(stat);
+                if (stat.m_local_header_ofs > spanEnd + k_BatchMaxGap || entryEnd - spanBegin > k_BatchMaxSpan) {
+                    break;
+                }
+                spanEnd = eastl::max(spanEnd, entryEnd);
+            }
+
+            spanEnd = eastl::min(spanEnd, static_cast<uint64_t>(m_ZipArchive->m_archive_size));
+
+            // Mapped archive is decoded in place, otherwise span is read in one go
+            const uint8_t* spanData = nullptr;
+            size_t spanSize = 0;
+            if (m_Mapping) {
+                spanData = m_Mapping->Data() + eastl::min(spanBegin, m_Mapping->Size());
+                spanSize = static_cast<size_t>(eastl::min(spanEnd, m_Mapping->Size()) - eastl::min(spanBegin, m_Mapping->Size()));
+            } else {
+                span.resize(static_cast<size_t>(spanEnd - spanBegin));
+                spanSize = m_ZipArchive->m_pRead(m_ZipArchive->m_pIO_opaque, spanBegin, span.data(), span.size());
+                spanData = span.data();
+            }
+
+            for (size_t i = first; i < last; ++i) {
+                const PendingRead& pendingRead = pendingReads[i];
+                uint64_t headerOffset = pendingRead.Stat.m_local_header_ofs - spanBegin;
+                if (!ExtractFromSpan(pendingRead, spanData + headerOffset, spanSize - eastl::min<uint64_t>(headerOffset, spanSize), scratch)) {
+                    ExtractEntryST(pendingRead, scratch);
+                }
+            }
+
+            first = last;
+        }
+
+        for (const PendingRead& pendingRead : pendingReads) {
+            if (!pendingRead.Request->IsSucceeded) {
+                Stats().AddMiss();
+                continue;
+            }
+
+            Stats().AddBytesRead(pendingRead.Request->BytesRead);
+            if (pendingRead.Stat.m_method != ZipFormat::k_MethodStored) {
+                Stats().AddBytesDecompressed(pendingRead.Stat.m_uncomp_size);
+            }
+        }
+    }
+
+    static inline uint64_t EstimateEntryEnd(const mz_zip_archive_file_stat& stat)
     {
-        return FindFile(filePath, m_FileList) != nullptr;
+        return stat.m_local_header_ofs + ZipFormat::k_LocalHeaderSize + strlen(stat.m_filename) + k_BatchExtraReserve + stat.m_comp_size;
+    }
+
+    /*
+     * Decode entry from already read archive bytes. Returns false if entry has to be extracted by miniz
+     */
+    static inline bool ExtractFromSpan(const PendingRead& pendingRead, const uint8_t* header, uint64_t available, eastl::vector<uint8_t>& scratch)
+    {
+        const mz_zip_archive_file_stat& stat = pendingRead.Stat;
+        BatchReadRequest* request = pendingRead.Request;
+
+        // Encrypted entries and unknown methods are left to miniz
+        if ((stat.m_bit_flag & 1) != 0) {
+            return false;
+        }
+        if (stat.m_method != ZipFormat::k_MethodStored && stat.m_method != ZipFormat::k_MethodDeflated) {
+            return false;
+        }
+
+        uint64_t dataOffset = ZipFormat::LocalDataOffset(header, available);
+        if (dataOffset == 0 || dataOffset + stat.m_comp_size > available) {
+            return false;
+        }
+        const uint8_t* data = header + dataOffset;
+
+        // Decode in place when caller buffer fits whole entry
+        uint8_t* output = request->Buffer;
+        if (request->BufferSize < stat.m_uncomp_size) {
+            scratch.resize(static_cast<size_t>(stat.m_uncomp_size));
+            output = scratch.data();
+        }
+
+        if (stat.m_method == ZipFormat::k_MethodStored) {
+            if (stat.m_comp_size != stat.m_uncomp_size) {
+                return false;
+            }
+            if (stat.m_uncomp_size > 0) {
+                memcpy(output, data, static_cast<size_t>(stat.m_uncomp_size));
+            }
+        } else {
+            TraceScope traceScope("zip", "Inflate", stat.m_filename);
+            size_t decodedSize = tinfl_decompress_mem_to_mem(output, static_cast<size_t>(stat.m_uncomp_size), data, static_cast<size_t>(stat.m_comp_size), 0);
+            if (decodedSize != stat.m_uncomp_size) {
+                return false;
+            }
+        }
+
+        if (mz_crc32(0, output, static_cast<size_t>(stat.m_uncomp_size)) != stat.m_crc32) {
+            return false;
+        }
+
+        request->BytesRead = eastl::min(request->BufferSize, static_cast<uint64_t>(stat.m_uncomp_size));
+        if (output != request->Buffer && request->BytesRead > 0) {
+            memcpy(request->Buffer, output, static_cast<size_t>(request->BytesRead));
+        }
+        request->IsSucceeded = true;
+        return true;
+    }
+
+    inline void ExtractEntryST(const PendingRead& pendingRead, eastl::vector<uint8_t>& scratch)
+    {
+        const mz_zip_archive_file_stat& stat = pendingRead.Stat;
+        BatchReadRequest* request = pendingRead.Request;
+
+        uint8_t* output = request->Buffer;
+        if (request->BufferSize < stat.m_uncomp_size) {
+            scratch.resize(static_cast<size_t>(stat.m_uncomp_size));
+            output = scratch.data();
+        }
+
+        TraceScope traceScope("zip", "Inflate", stat.m_filename);
+        if (!mz_zip_reader_extract_to_mem_no_alloc(m_ZipArchive.get(), stat.m_file_index, output, static_cast<size_t>(stat.m_uncomp_size), 0, 0, 0)) {
+            return;
+        }
+
+        request->BytesRead = eastl::min(request->BufferSize, static_cast<uint64_t>(stat.m_uncomp_size));
+        if (output != request->Buffer && request->BytesRead > 0) {
+            memcpy(request->Buffer, output, static_cast<size_t>(request->BytesRead));
+        }
+        request->IsSucceeded = true;
+    }
+
+    inline bool IsStreamable(const mz_zip_archive_file_stat& stat) const
+    {
+        if (m_Options.StreamingMinSize == 0 || stat.m_uncomp_size < m_Options.StreamingMinSize) {
+            return false;
+        }
+        // Encrypted entries and unknown methods are left to miniz
+        if ((stat.m_bit_flag & 1) != 0) {
+            return false;
+        }
+        return stat.m_method == ZipFormat::k_MethodDeflated || (stat.m_method == ZipFormat::k_MethodStored && stat.m_comp_size == stat.m_uncomp_size);
     }
 
     void BuildFilelist(eastl::shared_ptr<mz_zip_archive> zipArchive, TFileList& outFileList)
@@ -282,18 +833,268 @@ private:
                 // TODO: log error
                 continue;
             }
-            
-            FileInfo fileInfo(BasePathST(), file_stat.m_filename, false);
-            HFile file(new ZipFile(fileInfo, file_stat.m_file_index, file_stat.m_uncomp_size, zipArchive));
-            outFileList[fileInfo.AbsolutePath()] = file;
+
+            HFile file = NewFile(zipArchive, file_stat);
+            outFileList[file->GetFileInfo().AbsolutePath()] = file;
+        }
+    }
+
+    HFile NewFile(const eastl::shared_ptr<mz_zip_archive>& zipArchive, const mz_zip_archive_file_stat& file_stat)
+    {
+        // Directory entries end with a slash
+        FileInfo fileInfo(BasePathST(), file_stat.m_filename, mz_zip_reader_is_file_a_directory(zipArchive.get(), file_stat.m_file_index));
+        ZipFile* zipFile = new ZipFile(fileInfo, file_stat.m_file_index, file_stat.m_uncomp_size, zipArchive, SharedStats());
+        zipFile->m_IsCompressed = (file_stat.m_method != ZipFormat::k_MethodStored);
+        if (m_Mapping && !zipFile->m_IsCompressed && (file_stat.m_bit_flag & 1) == 0 && file_stat.m_comp_size == file_stat.m_uncomp_size) {
+            zipFile->m_IsViewable = true;
+            zipFile->m_LocalHeaderOffset = file_stat.m_local_header_ofs;
+            zipFile->m_Mapping = m_Mapping;
+        } else if (IsStreamable(file_stat)) {
+            zipFile->m_IsStreamed = true;
+            zipFile->m_LocalHeaderOffset = file_stat.m_local_header_ofs;
+            zipFile->m_CompressedSize = file_stat.m_comp_size;
+            zipFile->m_Crc32 = file_stat.m_crc32;
+            zipFile->m_StreamChunkSize = m_Options.StreamingChunkSize;
+            zipFile->m_ArchivePath = m_SharedZipPath;
+            zipFile->m_Mapping = m_Mapping;
+        } else {
+            zipFile->m_Cache = m_EntryCache;
+        }
+        return HFile(zipFile);
+    }
+
+    /*
+     * Entry of fast mounted archive, absolute path is kept in names of its table
+     */
+    struct CompactEntry
+    {
+        uint64_t PathId = 0;
+        uint64_t NameOffset = 0;
+        uint32_t NameLength = 0;
+        uint32_t FileIndex = 0;
+    };
+
+    struct EntryTable
+    {
+        eastl::vector<CompactEntry> Entries;
+        eastl::vector<char> Names;
+    };
+
+    // Smaller archives are parsed on calling thread, starting threads costs more than it saves.
+    // Kept well below 65535 entries that miniz can open without zip64
+    static constexpr mz_uint k_ParallelMountMinEntries = 16384;
+    // Lower bound of entries parsed by one mount thread
+    static constexpr mz_uint k_MountEntriesPerThread = 4096;
+
+    /*
+     * Index central directory that miniz already read in one piece. Only names are copied out,
+     * records are parsed again when a file object is created
+     */
+    inline void BuildEntryTableST()
+    {
+        TraceScope traceScope("zip", "BuildEntryTable");
+        mz_uint numFiles = mz_zip_reader_get_num_files(m_ZipArchive.get());
+
+        uint32_t numThreads = 1;
+        if (numFiles >= k_ParallelMountMinEntries) {
+            numThreads = m_Options.MountThreads ? m_Options.MountThreads : eastl::max(1u, std::thread::hardware_concurrency());
+            numThreads = eastl::min<uint32_t>(numThreads, numFiles / k_MountEntriesPerThread);
+        }
+
+        // Each thread fills its own part, parts are joined in archive order
+        eastl::vector<EntryTable> parts(numThreads);
+        eastl::vector<std::thread> threads;
+        mz_zip_archive* zipArchive = m_ZipArchive.get();
+        for (uint32_t i = 1; i < numThreads; ++i) {
+            threads.emplace_back([zipArchive, &parts, i, numThreads, numFiles]() {
+                mz_uint first = static_cast<mz_uint>(numFiles * uint64_t(i) / numThreads);
+                mz_uint last = static_cast<mz_uint>(numFiles * uint64_t(i + 1) / numThreads);
+                ParseEntries(zipArchive, first, last, parts[i]);
+            });
+        }
+        ParseEntries(zipArchive, 0, numFiles / numThreads, parts[0]);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        if (numThreads == 1) {
+            m_EntryTable = eastl::move(parts[0]);
+        } else {
+            size_t numEntries = 0;
+            size_t numNameBytes = 0;
+            for (const EntryTable& part : parts) {
+                numEntries += part.Entries.size();
+                numNameBytes += part.Names.size();
+            }
+
+            m_EntryTable.Entries.reserve(numEntries);
+            m_EntryTable.Names.reserve(numNameBytes);
+            for (const EntryTable& part : parts) {
+                uint64_t nameBase = m_EntryTable.Names.size();
+                m_EntryTable.Names.insert(m_EntryTable.Names.end(), part.Names.begin(), part.Names.end());
+                for (CompactEntry entry : part.Entries) {
+                    entry.NameOffset += nameBase;
+                    m_EntryTable.Entries.push_back(entry);
+                }
+            }
+        }
+
+        // Open addressing with linear probing, load factor stays below one half
+        size_t numSlots = 16;
+        while (numSlots < m_EntryTable.Entries.size() * 2) {
+            numSlots *= 2;
+        }
+        m_EntrySlots.assign(numSlots, 0);
+
+        for (uint32_t i = 0; i < m_EntryTable.Entries.size(); ++i) {
+            const CompactEntry& entry = m_EntryTable.Entries[i];
+            size_t slot = static_cast<size_t>(entry.PathId) & (numSlots - 1);
+            while (m_EntrySlots[slot] != 0 && !IsSameEntryST(m_EntryTable.Entries[m_EntrySlots[slot] - 1], entry)) {
+                slot = (slot + 1) & (numSlots - 1);
+            }
+            // Later entry of the same path replaces earlier one, as in full file list
+            m_EntrySlots[slot] = i + 1;
+        }
+    }
+
+    /*
+     * Copy absolute paths of entries ['first', 'last') into 'outTable'. Reads only central directory in memory
+     */
+    static void ParseEntries(mz_zip_archive* zipArchive, mz_uint first, mz_uint last, EntryTable& outTable)
+    {
+        outTable.Entries.reserve(last - first);
+        for (mz_uint i = first; i < last; ++i) {
+            // Length includes terminator, zero means record is invalid
+            mz_uint nameSize = mz_zip_reader_get_filename(zipArchive, i, nullptr, 0);
+            if (nameSize == 0) {
+                continue;
+            }
+
+            size_t offset = outTable.Names.size();
+            outTable.Names.resize(offset + 1 + nameSize);
+            outTable.Names[offset] = '/';
+            mz_zip_reader_get_filename(zipArchive, i, outTable.Names.data() + offset + 1, nameSize);
+            // Drop terminator
+            outTable.Names.pop_back();
+
+            // Root is joined with name the way FileInfo does it, absolute names keep their own slash
+            if (nameSize > 1 && outTable.Names[offset + 1] == '/') {
+                ++offset;
+            }
+#if defined(_WIN32)
+            eastl::replace(outTable.Names.begin() + offset, outTable.Names.end(), '\\', '/');
+#endif
+
+            CompactEntry entry;
+            entry.NameOffset = offset;
+            entry.NameLength = static_cast<uint32_t>(outTable.Names.size() - offset);
+            entry.FileIndex = i;
+            entry.PathId = StringUtils::Hash(eastl::string_view(outTable.Names.data() + offset, entry.NameLength));
+            outTable.Entries.push_back(entry);
+        }
+    }
+
+    inline eastl::string_view EntryPathST(const CompactEntry& entry) const
+    {
+        return eastl::string_view(m_EntryTable.Names.data() + entry.NameOffset, entry.NameLength);
+    }
+
+    inline bool IsSameEntryST(const CompactEntry& a, const CompactEntry& b) const
+    {
+        return a.PathId == b.PathId && EntryPathST(a) == EntryPathST(b);
+    }
+
+    inline const CompactEntry* FindEntryST(const FileInfo& filePath) const
+    {
+        const eastl::string& absolutePath = filePath.AbsolutePath();
+        return FindEntryST(eastl::string_view(absolutePath.data(), absolutePath.length()), filePath.PathId());
+    }
+
+    inline const CompactEntry* FindEntryST(eastl::string_view filePath) const
+    {
+        if (m_EntrySlots.empty()) {
+            return nullptr;
+        }
+
+        FileInfo::TPathBuffer buffer;
+        eastl::string_view normalizedPath = FileInfo::Normalize(filePath, buffer);
+        return FindEntryST(normalizedPath, StringUtils::Hash(normalizedPath));
+    }
+
+    inline const CompactEntry* FindEntryST(eastl::string_view filePath, uint64_t pathId) const
+    {
+        if (m_EntrySlots.empty()) {
+            return nullptr;
+        }
+
+        size_t mask = m_EntrySlots.size() - 1;
+        for (size_t slot = static_cast<size_t>(pathId) & mask; m_EntrySlots[slot] != 0; slot = (slot + 1) & mask) {
+            const CompactEntry& entry = m_EntryTable.Entries[m_EntrySlots[slot] - 1];
+            if (entry.PathId == pathId && EntryPathST(entry) == filePath) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    /*
+     * Create file object of fast mounted entry and keep it in file list under entry path
+     */
+    inline HFile CreateEntryFileST(const CompactEntry& entry)
+    {
+        mz_zip_archive_file_stat stat;
+        if (!mz_zip_reader_file_stat(m_ZipArchive.get(), entry.FileIndex, &stat)) {
+            return nullptr;
+        }
+
+        HFile file = NewFile(m_ZipArchive, stat);
+        eastl::string_view path = EntryPathST(entry);
+        m_FileList[eastl::string(path.data(), path.length())] = file;
+        return file;
+    }
+
+    /*
+     * Create file objects of all entries not opened yet, table is not needed afterwards
+     */
+    inline void CreateRemainingFilesST()
+    {
+        for (uint32_t slot : m_EntrySlots) {
+            if (slot == 0) {
+                continue;
+            }
+
+            const CompactEntry& entry = m_EntryTable.Entries[slot - 1];
+            auto it = m_FileList.find_as(EntryPathST(entry), StringKnownHash(entry.PathId), StringEqual());
+            if (it == m_FileList.end()) {
+                CreateEntryFileST(entry);
+            }
         }
+        ClearEntryTableST();
+    }
+
+    inline void ClearEntryTableST()
+    {
+        m_EntryTable = EntryTable();
+        m_EntrySlots = eastl::vector<uint32_t>();
+    }
+
+    inline uint64_t EntryTableBytesST() const
+    {
+        return m_EntryTable.Entries.capacity() * sizeof(CompactEntry) + m_EntryTable.Names.capacity() + m_EntrySlots.capacity() * sizeof(uint32_t);
     }
     
 private:
     eastl::string m_ZipPath;
+    Options m_Options;
+    HMappedFile m_Mapping;
+    eastl::shared_ptr<const eastl::string> m_SharedZipPath;
+    HZipEntryCache m_EntryCache;
     eastl::shared_ptr<mz_zip_archive> m_ZipArchive;
     bool m_IsInitialized;
     TFileList m_FileList;
+    // Fast mount index, empty once every file object exists
+    EntryTable m_EntryTable;
+    eastl::vector<uint32_t> m_EntrySlots;
     mutable std::mutex m_Mutex;
 };
 
@@ -0,0 +1,54 @@
+#ifndef ZIPFORMAT_HPP
+#define ZIPFORMAT_HPP
+
+#include "Global.h"
+
+namespace Titan::Vfs
+{
+
+/*
+ * Raw zip structures that are parsed directly instead of going through miniz
+ */
+class ZipFormat
+{
+public:
+    static constexpr uint32_t k_LocalHeaderSignature = 0x04034b50;
+    static constexpr uint64_t k_LocalHeaderSize = 30;
+
+    static constexpr uint16_t k_MethodStored = 0;
+    static constexpr uint16_t k_MethodDeflated = 8;
+
+    static inline uint16_t ReadU16(const uint8_t* data)
+    {
+        return static_cast<uint16_t>(data[0] | (data[1] << 8));
+    }
+
+    static inline uint32_t ReadU32(const uint8_t* data)
+    {
+        return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+            (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+    }
+
+    static inline uint64_t ReadU64(const uint8_t* data)
+    {
+        return static_cast<uint64_t>(ReadU32(data)) | (static_cast<uint64_t>(ReadU32(data + 4)) << 32);
+    }
+
+    /*
+     * Parse local file header and return offset of entry data relative to the header, 0 if header is invalid
+     */
+    static inline uint64_t LocalDataOffset(const uint8_t* header, uint64_t available)
+    {
+        if (available < k_LocalHeaderSize || ReadU32(header) != k_LocalHeaderSignature) {
+            return 0;
+        }
+
+        uint16_t nameLength = ReadU16(header + 26);
+        uint16_t extraLength = ReadU16(header + 28);
+        return k_LocalHeaderSize + nameLength + extraLength;
+    }
+};
+
+} // namespace vfspp
+
+#endif // ZIPFORMAT_HPP
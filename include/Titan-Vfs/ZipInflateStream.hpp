@@ -0,0 +1,261 @@
+#ifndef ZIPINFLATESTREAM_HPP
+#define ZIPINFLATESTREAM_HPP
+
+#include "Global.h"
+#include "ZipFormat.hpp"
+#include "MappedFile.hpp"
+#include "zip_file.hpp"
+
+#include <EASTL/unique_ptr.h>
+
+namespace Titan::Vfs
+{
+
+using HZipInflateStream = eastl::unique_ptr<class ZipInflateStream>;
+
+/*
+ * Sequential reader of one zip entry that inflates it in bounded chunks as it is read.
+ * Holds the 32 KB deflate window and one chunk of compressed input whatever the entry size,
+ * input of a mapped archive is read from mapping and needs no chunk buffer at all.
+ * Stream has its own handle to archive, so it is read without filesystem lock
+ */
+class ZipInflateStream final
+{
+public:
+    ZipInflateStream(uint64_t chunkSize)
+        : m_ChunkSize(eastl::max<uint64_t>(chunkSize, 4096))
+    {
+    }
+
+    ZipInflateStream(const ZipInflateStream&) = delete;
+    ZipInflateStream& operator=(const ZipInflateStream&) = delete;
+
+    /*
+     * Start reading entry whose local header is at 'localHeaderOffset'. Archive is read from
+     * 'mapping' if there is one, otherwise from 'archivePath'. Returns false if header is invalid
+     */
+    bool Open(HMappedFile mapping, const eastl::string& archivePath, uint64_t localHeaderOffset, uint64_t compressedSize, uint64_t size, uint32_t crc32, bool isCompressed)
+    {
+        m_Mapping = eastl::move(mapping);
+        if (!m_Mapping) {
+            m_File.open(archivePath.c_str(), std::ios_base::in | std::ios_base::binary);
+            if (!m_File.is_open()) {
+                return false;
+            }
+        }
+
+        uint8_t header[ZipFormat::k_LocalHeaderSize];
+        if (!ReadSource(localHeaderOffset, header, sizeof(header))) {
+            return false;
+        }
+
+        uint64_t dataOffset = ZipFormat::LocalDataOffset(header, sizeof(header));
+        if (dataOffset == 0) {
+            return false;
+        }
+
+        m_DataOffset = localHeaderOffset + dataOffset;
+        m_CompressedSize = compressedSize;
+        m_Size = size;
+        m_ExpectedCrc32 = crc32;
+        m_IsCompressed = isCompressed;
+        if (m_Mapping && m_DataOffset + m_CompressedSize > m_Mapping->Size()) {
+            return false;
+        }
+
+        if (m_IsCompressed) {
+            m_Window.resize(TINFL_LZ_DICT_SIZE);
+            if (!m_Mapping) {
+                m_Input.resize(static_cast<size_t>(m_ChunkSize));
+            }
+        }
+
+        Rewind();
+        return true;
+    }
+
+    /*
+     * Go back to beginning of entry, compressed entries are inflated again from start
+     */
+    void Rewind()
+    {
+        tinfl_init(&m_Inflator);
+        m_Position = 0;
+        m_CompressedRead = 0;
+        m_InputData = nullptr;
+        m_InputSize = 0;
+        m_WindowOffset = 0;
+        m_PendingOffset = 0;
+        m_PendingSize = 0;
+        m_Crc32 = MZ_CRC32_INIT;
+        m_IsCrcTracked = true;
+        m_IsFailed = false;
+    }
+
+    /*
+     * Decode up to 'size' next bytes into 'buffer', null buffer skips them. Returns number of bytes produced,
+     * read that reaches end of entry returns 0 if entry doesn't match its CRC32
+     */
+    uint64_t Read(uint8_t* buffer, uint64_t size)
+    {
+        if (m_IsFailed) {
+            return 0;
+        }
+
+        size = eastl::min(size, m_Size - m_Position);
+        if (!m_IsCompressed) {
+            if (size > 0 && buffer) {
+                if (!ReadSource(m_DataOffset + m_Position, buffer, size)) {
+                    return 0;
+                }
+                m_Crc32 = static_cast<uint32_t>(mz_crc32(m_Crc32, buffer, static_cast<size_t>(size)));
+            } else if (size > 0) {
+                // Skipped stored data is never read, such pass can't be verified
+                m_IsCrcTracked = false;
+            }
+            return FinishRead(size);
+        }
+
+        uint64_t total = 0;
+        while (total < size) {
+            if (m_PendingSize == 0 && !InflateChunk()) {
+                break;
+            }
+
+            uint64_t count = eastl::min(m_PendingSize, size - total);
+            const uint8_t* data = m_Window.data() + m_PendingOffset;
+            if (buffer) {
+                memcpy(buffer + total, data, static_cast<size_t>(count));
+            }
+            m_Crc32 = static_cast<uint32_t>(mz_crc32(m_Crc32, data, static_cast<size_t>(count)));
+            m_PendingOffset += count;
+            m_PendingSize -= count;
+            total += count;
+        }
+
+        return FinishRead(total);
+    }
+
+    inline uint64_t Tell() const
+    {
+        return m_Position;
+    }
+
+    /*
+     * Heap held by stream
+     */
+    inline uint64_t MemoryBytes() const
+    {
+        return m_Window.capacity() + m_Input.capacity();
+    }
+
+private:
+    /*
+     * Advance position by 'count' produced bytes, entry is checked against its CRC32 once it is fully produced
+     */
+    inline uint64_t FinishRead(uint64_t count)
+    {
+        if (m_Position + count == m_Size && m_IsCrcTracked && m_Crc32 != m_ExpectedCrc32) {
+            m_IsFailed = true;
+            return 0;
+        }
+
+        m_Position += count;
+        return count;
+    }
+
+    /*
+     * Inflate next piece of entry into window. Returns false at end of entry or on corrupt data
+     */
+    inline bool InflateChunk()
+    {
+        if (m_IsFailed) {
+            return false;
+        }
+
+        if (m_InputSize == 0 && m_CompressedRead < m_CompressedSize) {
+            uint64_t count = eastl::min(m_ChunkSize, m_CompressedSize - m_CompressedRead);
+            if (m_Mapping) {
+                m_InputData = m_Mapping->Data() + m_DataOffset + m_CompressedRead;
+            } else if (ReadSource(m_DataOffset + m_CompressedRead, m_Input.data(), count)) {
+                m_InputData = m_Input.data();
+            } else {
+                m_IsFailed = true;
+                return false;
+            }
+            m_InputSize = static_cast<size_t>(count);
+            m_CompressedRead += count;
+        }
+
+        size_t inputSize = m_InputSize;
+        size_t outputSize = m_Window.size() - static_cast<size_t>(m_WindowOffset);
+        mz_uint32 flags = m_CompressedRead < m_CompressedSize ? TINFL_FLAG_HAS_MORE_INPUT : 0;
+        tinfl_status status = tinfl_decompress(&m_Inflator, m_InputData, &inputSize, m_Window.data(), m_Window.data() + m_WindowOffset, &outputSize, flags);
+
+        m_InputData += inputSize;
+        m_InputSize -= inputSize;
+        m_PendingOffset = m_WindowOffset;
+        m_PendingSize = outputSize;
+        // Window is circular, its size is a power of two
+        m_WindowOffset = (m_WindowOffset + outputSize) & (m_Window.size() - 1);
+
+        if (status < TINFL_STATUS_DONE) {
+            m_IsFailed = true;
+            m_PendingSize = 0;
+            return false;
+        }
+
+        // No progress means entry ended, or its data ended early
+        if (outputSize == 0 && (status == TINFL_STATUS_DONE || (m_InputSize == 0 && m_CompressedRead == m_CompressedSize))) {
+            m_IsFailed = true;
+            return false;
+        }
+        return true;
+    }
+
+    inline bool ReadSource(uint64_t offset, uint8_t* buffer, uint64_t size)
+    {
+        if (m_Mapping) {
+            if (offset + size > m_Mapping->Size()) {
+                return false;
+            }
+            memcpy(buffer, m_Mapping->Data() + offset, static_cast<size_t>(size));
+            return true;
+        }
+
+        m_File.clear();
+        m_File.seekg(static_cast<std::streamoff>(offset));
+        m_File.read(reinterpret_cast<char*>(buffer), static_cast<std::streamsize>(size));
+        return static_cast<uint64_t>(m_File.gcount()) == size;
+    }
+
+private:
+    uint64_t m_ChunkSize;
+    HMappedFile m_Mapping;
+    std::ifstream m_File;
+    uint64_t m_DataOffset = 0;
+    uint64_t m_CompressedSize = 0;
+    uint64_t m_Size = 0;
+    uint32_t m_ExpectedCrc32 = 0;
+    bool m_IsCompressed = false;
+
+    tinfl_decompressor m_Inflator;
+    eastl::vector<uint8_t> m_Window;
+    eastl::vector<uint8_t> m_Input;
+    const uint8_t* m_InputData = nullptr;
+    size_t m_InputSize = 0;
+    uint64_t m_CompressedRead = 0;
+    uint64_t m_WindowOffset = 0;
+    // Inflated bytes in window not handed out yet
+    uint64_t m_PendingOffset = 0;
+    uint64_t m_PendingSize = 0;
+    uint64_t m_Position = 0;
+    // CRC32 of bytes produced since entry start, untracked after stored data was skipped unread
+    uint32_t m_Crc32 = MZ_CRC32_INIT;
+    bool m_IsCrcTracked = true;
+    bool m_IsFailed = false;
+};
+
+} // namespace vfspp
+
+#endif // ZIPINFLATESTREAM_HPP
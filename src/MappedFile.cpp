@@ -0,0 +1,56 @@
+#if defined(_WIN32)
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+#include <cstdint>
+
+namespace Titan::Vfs::Win32Mapping
+{
+
+/*
+ * Map whole file read-only, returns null if file can't be opened, is empty or larger than 'maxSize'
+ */
+const uint8_t* Map(const char* filePath, uint64_t maxSize, uint64_t& outSize)
+{
+    HANDLE file = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0 || static_cast<uint64_t>(fileSize.QuadPart) > maxSize) {
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    // View keeps mapping alive, both handles can be closed right away
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) {
+        return nullptr;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data) {
+        return nullptr;
+    }
+
+    outSize = static_cast<uint64_t>(fileSize.QuadPart);
+    return static_cast<const uint8_t*>(data);
+}
+
+void Unmap(const uint8_t* data)
+{
+    UnmapViewOfFile(data);
+}
+
+} // namespace Titan::Vfs::Win32Mapping
+
+#endif // _WIN32
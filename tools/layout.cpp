@@ -0,0 +1,313 @@
+// Rewrites an archive so entries are stored in the order a recorded access trace first opened them.
+// Files first opened in the same loading burst by the same thread end up next to each other, so
+// cold start reads become mostly sequential. Entries that were never opened are placed last.
+//
+// Usage: vfspplayout <trace> <source dir|archive.zip> <output.zip> [--alias /mount] [--burst-ms N] [--level N] [--list]
+//   --alias     mount point of the source in traced virtual paths, default is '/'
+//   --burst-ms  idle time that separates loading bursts, default is 50
+//   --level     compression level for files taken from a directory, default is 6
+//   --list      print resulting order without writing archive
+
+#include "Titan-Vfs/VFS.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace Titan;
+
+void* operator new[](size_t size, const char* pName, int flags, unsigned debugFlags, const char* file, int line) {
+    return malloc(size);
+}
+void* operator new[](size_t size, size_t alignment, size_t alignmentOffset, const char* pName, int flags, unsigned debugFlags, const char* file, int line) {
+    return malloc(size);
+}
+
+namespace fs = std::filesystem;
+
+/*
+ * File of source archive or directory
+ */
+struct SourceEntry
+{
+    std::string Name;
+    // Index in source archive, or path on disk for directory sources
+    mz_uint ArchiveIndex = 0;
+    std::string DiskPath;
+    uint64_t LocalHeaderOffset = 0;
+    uint64_t CompressedSize = 0;
+
+    // Position in first-access order, entries never opened keep the maximum
+    uint64_t Burst = UINT64_MAX;
+    uint32_t Thread = 0;
+    uint64_t FirstAccess = 0;
+};
+
+static const char* GetOption(int argc, char** argv, const char* name, const char* fallback)
+{
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], name) == 0) {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+static bool IsZip(const std::string& path)
+{
+    return path.size() > 4 && path.compare(path.size() - 4, 4, ".zip") == 0;
+}
+
+static bool CollectArchive(mz_zip_archive& archive, std::vector<SourceEntry>& outEntries)
+{
+    for (mz_uint i = 0; i < mz_zip_reader_get_num_files(&archive); ++i) {
+        mz_zip_archive_file_stat stat;
+        if (!mz_zip_reader_file_stat(&archive, i, &stat) || mz_zip_reader_is_file_a_directory(&archive, i)) {
+            continue;
+        }
+
+        SourceEntry entry;
+        entry.Name = stat.m_filename;
+        entry.ArchiveIndex = i;
+        entry.LocalHeaderOffset = stat.m_local_header_ofs;
+        entry.CompressedSize = stat.m_comp_size;
+        outEntries.push_back(entry);
+    }
+    return true;
+}
+
+static bool CollectDirectory(const std::string& basePath, std::vector<SourceEntry>& outEntries)
+{
+    std::error_code error;
+    for (fs::recursive_directory_iterator it(basePath, error), end; !error && it != end; it.increment(error)) {
+        if (!it->is_regular_file()) {
+            continue;
+        }
+
+        SourceEntry entry;
+        entry.Name = fs::relative(it->path(), basePath).generic_string();
+        entry.DiskPath = it->path().string();
+        outEntries.push_back(entry);
+    }
+    return !error;
+}
+
+/*
+ * Assign first-access position to every traced entry
+ */
+static void ApplyTrace(const Vfs::TraceData& trace, const std::string& alias, uint64_t burstGap, std::vector<SourceEntry>& entries)
+{
+    std::unordered_map<std::string, SourceEntry*> entriesByName;
+    for (SourceEntry& entry : entries) {
+        entriesByName[entry.Name] = &entry;
+    }
+
+    std::vector<const Vfs::TraceEvent*> opens;
+    for (const Vfs::TraceEvent& event : trace.Events) {
+        if (event.Op == Vfs::TraceOp::Open && event.Result != 0) {
+            opens.push_back(&event);
+        }
+    }
+    std::stable_sort(opens.begin(), opens.end(), [](const Vfs::TraceEvent* a, const Vfs::TraceEvent* b) {
+        return a->Timestamp < b->Timestamp;
+    });
+
+    uint64_t burst = 0;
+    uint64_t lastTimestamp = 0;
+    for (const Vfs::TraceEvent* open : opens) {
+        if (open != opens.front() && open->Timestamp - lastTimestamp > burstGap) {
+            ++burst;
+        }
+        lastTimestamp = open->Timestamp;
+
+        const eastl::string& path = trace.Paths[static_cast<size_t>(open->Value)];
+        if (path.size() < alias.size() || path.compare(0, alias.size(), alias.c_str()) != 0) {
+            continue;
+        }
+
+        std::string name(path.c_str() + alias.size());
+        name.erase(0, name.find_first_not_of('/'));
+
+        auto it = entriesByName.find(name);
+        if (it == entriesByName.end() || it->second->Burst != UINT64_MAX) {
+            continue;
+        }
+
+        it->second->Burst = burst;
+        it->second->Thread = open->ThreadIndex;
+        it->second->FirstAccess = open->Timestamp;
+    }
+}
+
+/*
+ * Number of times reading entries in first-access order has to jump within archive
+ */
+static size_t CountJumps(std::vector<SourceEntry> entries)
+{
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [](const SourceEntry& entry) {
+        return entry.Burst == UINT64_MAX;
+    }), entries.end());
+    std::sort(entries.begin(), entries.end(), [](const SourceEntry& a, const SourceEntry& b) {
+        return a.FirstAccess < b.FirstAccess;
+    });
+
+    // Local header and name lie between entries, small gaps are read through
+    const uint64_t maxGap = 64 * 1024;
+    size_t numJumps = 0;
+    for (size_t i = 1; i < entries.size(); ++i) {
+        uint64_t previousEnd = entries[i - 1].LocalHeaderOffset + entries[i - 1].CompressedSize;
+        uint64_t offset = entries[i].LocalHeaderOffset;
+        if (offset < previousEnd || offset - previousEnd > maxGap) {
+            ++numJumps;
+        }
+    }
+    return numJumps;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 4) {
+        printf("Usage: %s <trace> <source dir|archive.zip> <output.zip> [--alias /mount] [--burst-ms N] [--level N] [--list]\n", argv[0]);
+        return 1;
+    }
+
+    const std::string tracePath = argv[1];
+    const std::string sourcePath = argv[2];
+    const std::string outputPath = argv[3];
+    std::string alias = GetOption(argc, argv, "--alias", "/");
+    const uint64_t burstGap = strtoull(GetOption(argc, argv, "--burst-ms", "50"), nullptr, 10) * 1000000ull;
+    const mz_uint level = static_cast<mz_uint>(strtoul(GetOption(argc, argv, "--level", "6"), nullptr, 10));
+    bool isListOnly = false;
+    for (int i = 4; i < argc; ++i) {
+        isListOnly |= (strcmp(argv[i], "--list") == 0);
+    }
+
+    if (alias.empty() || alias.back() != '/') {
+        alias += '/';
+    }
+
+    Vfs::TraceData trace;
+    if (!Vfs::AccessTrace::Load(tracePath.c_str(), trace)) {
+        printf("Can't load trace '%s'\n", tracePath.c_str());
+        return 1;
+    }
+
+    const bool isSourceZip = IsZip(sourcePath);
+    mz_zip_archive source;
+    memset(&source, 0, sizeof(source));
+    std::vector<SourceEntry> entries;
+    if (isSourceZip) {
+        if (!mz_zip_reader_init_file(&source, sourcePath.c_str(), 0)) {
+            printf("Can't open archive '%s'\n", sourcePath.c_str());
+            return 1;
+        }
+        CollectArchive(source, entries);
+    } else if (!CollectDirectory(sourcePath, entries)) {
+        printf("Can't read directory '%s'\n", sourcePath.c_str());
+        return 1;
+    }
+
+    ApplyTrace(trace, alias, burstGap, entries);
+
+    // Burst keeps loading phases apart, thread keeps each loader's sequence contiguous
+    std::stable_sort(entries.begin(), entries.end(), [](const SourceEntry& a, const SourceEntry& b) {
+        if (a.Burst != b.Burst) {
+            return a.Burst < b.Burst;
+        }
+        if (a.Burst == UINT64_MAX) {
+            return a.Name < b.Name;
+        }
+        if (a.Thread != b.Thread) {
+            return a.Thread < b.Thread;
+        }
+        return a.FirstAccess < b.FirstAccess;
+    });
+
+    size_t numTraced = std::count_if(entries.begin(), entries.end(), [](const SourceEntry& entry) {
+        return entry.Burst != UINT64_MAX;
+    });
+
+    if (isListOnly) {
+        for (const SourceEntry& entry : entries) {
+            if (entry.Burst == UINT64_MAX) {
+                printf("%s\n", entry.Name.c_str());
+            } else {
+                printf("%s burst=%llu thread=%u first=%.3fms\n", entry.Name.c_str(), static_cast<unsigned long long>(entry.Burst),
+                    entry.Thread, static_cast<double>(entry.FirstAccess) / 1e6);
+            }
+        }
+        if (isSourceZip) {
+            mz_zip_reader_end(&source);
+        }
+        return 0;
+    }
+
+    mz_zip_archive output;
+    memset(&output, 0, sizeof(output));
+    if (!mz_zip_writer_init_file(&output, outputPath.c_str(), 0)) {
+        printf("Can't create archive '%s'\n", outputPath.c_str());
+        return 1;
+    }
+
+    bool isSucceeded = true;
+    std::vector<uint8_t> data;
+    for (const SourceEntry& entry : entries) {
+        if (isSourceZip) {
+            // Compressed data is copied as is
+            isSucceeded = mz_zip_writer_add_from_zip_reader(&output, &source, entry.ArchiveIndex);
+        } else {
+            std::ifstream stream(entry.DiskPath, std::ios_base::binary);
+            data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+            isSucceeded = stream.good() || stream.eof();
+            isSucceeded = isSucceeded && mz_zip_writer_add_mem(&output, entry.Name.c_str(), data.data(), data.size(), level);
+        }
+
+        if (!isSucceeded) {
+            printf("Can't add '%s'\n", entry.Name.c_str());
+            break;
+        }
+    }
+
+    isSucceeded = isSucceeded && mz_zip_writer_finalize_archive(&output);
+    mz_zip_writer_end(&output);
+
+    size_t jumpsBefore = isSourceZip ? CountJumps(entries) : 0;
+    if (isSourceZip) {
+        mz_zip_reader_end(&source);
+    }
+    if (!isSucceeded) {
+        fs::remove(outputPath);
+        return 1;
+    }
+
+    // Measure new archive the same way as source
+    size_t jumpsAfter = 0;
+    mz_zip_archive result;
+    memset(&result, 0, sizeof(result));
+    if (mz_zip_reader_init_file(&result, outputPath.c_str(), 0)) {
+        std::vector<SourceEntry> written;
+        CollectArchive(result, written);
+        std::unordered_map<std::string, const SourceEntry*> ordered;
+        for (const SourceEntry& entry : entries) {
+            ordered[entry.Name] = &entry;
+        }
+        for (SourceEntry& entry : written) {
+            const SourceEntry* original = ordered[entry.Name];
+            entry.Burst = original->Burst;
+            entry.FirstAccess = original->FirstAccess;
+        }
+        jumpsAfter = CountJumps(written);
+        mz_zip_reader_end(&result);
+    }
+
+    printf("Wrote %zu entries, %zu ordered by trace, %zu never opened\n", entries.size(), numTraced, entries.size() - numTraced);
+    if (isSourceZip) {
+        printf("Jumps while reading in first-access order: %zu before, %zu after\n", jumpsBefore, jumpsAfter);
+    } else {
+        printf("Jumps while reading in first-access order: %zu\n", jumpsAfter);
+    }
+
+    return 0;
+}